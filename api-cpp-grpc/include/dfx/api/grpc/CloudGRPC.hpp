@@ -8,10 +8,12 @@
 #include "dfx/api/CloudAPI.hpp"
 #include "dfx/api/CloudConfig.hpp"
 
+#include <functional>
 #include <grpcpp/grpcpp.h>
 #include <list>
 #include <memory>
 #include <string>
+#include <typeinfo>
 
 namespace dfx::api::grpc
 {
@@ -105,8 +107,26 @@ private:
 
     static std::string getServerURL(const std::string& hostname, int port);
 
+    // Channels are cached for the life of the process by host, port and credentials, so every call
+    // to the same server shares one connection which stays warm between calls
     static std::shared_ptr<::grpc::Channel> getChannel(const CloudConfig& config);
 
+    // The stub of Service on the cached channel for config, created once and shared by every caller.
+    // Stubs are safe to use from several threads at once.
+    template <typename Service>
+    static std::shared_ptr<typename Service::Stub> getStub(const CloudConfig& config)
+    {
+        auto stub = getCachedStub(config, typeid(Service), [](const std::shared_ptr<::grpc::Channel>& channel) {
+            return std::shared_ptr<void>(Service::NewStub(channel));
+        });
+        return std::static_pointer_cast<typename Service::Stub>(stub);
+    }
+
+    static std::shared_ptr<void> getCachedStub(
+        const CloudConfig& config,
+        const std::type_info& service,
+        const std::function<std::shared_ptr<void>(const std::shared_ptr<::grpc::Channel>&)>& createStub);
+
     static CloudStatus translateGrpcStatus(const ::grpc::Status& status);
 };
 
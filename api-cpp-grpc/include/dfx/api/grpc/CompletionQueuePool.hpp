@@ -0,0 +1,96 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_API_GRPC_COMPLETION_QUEUE_POOL_H
+#define DFX_API_GRPC_COMPLETION_QUEUE_POOL_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <grpcpp/completion_queue.h>
+
+namespace dfx::api::grpc
+{
+
+/**
+ * CompletionQueuePool drives the asynchronous gRPC streams registered with it from a small fixed pool
+ * of poller threads, rather than each stream owning a CompletionQueue and a thread waiting on it.
+ *
+ * Each poller thread owns one CompletionQueue and a stream is bound to the least loaded poller when
+ * it is set up. Every operation of the stream is started on that queue, so all its events arrive in
+ * order on the one thread and a stream never handles two events at once. Pollers block in Next()
+ * until an operation completes so idle streams cost no CPU.
+ *
+ * The tag of every operation is a Tag naming the Handler it is dispatched to and which event it is,
+ * the Tags are owned by the stream and must outlive every operation started with them.
+ *
+ * A process wide instance is available from getShared() which is what MeasurementStreamGRPC uses,
+ * applications which want to own the threads can construct their own.
+ */
+class CompletionQueuePool
+{
+public:
+    static const uint16_t DEFAULT_POLLER_THREADS = 2;
+
+    class Handler
+    {
+    public:
+        virtual ~Handler() = default;
+
+        // Called on the poller thread the stream is bound to for every operation which completes
+        virtual void handleEvent(int event, bool ok) = 0;
+    };
+
+    struct Tag
+    {
+        Handler* handler;
+        int event;
+    };
+
+    explicit CompletionQueuePool(uint16_t pollerThreads = DEFAULT_POLLER_THREADS);
+
+    // Every stream must have finished and detached, the queues are shut down and drained
+    ~CompletionQueuePool();
+
+    CompletionQueuePool(const CompletionQueuePool&) = delete;
+    CompletionQueuePool& operator=(const CompletionQueuePool&) = delete;
+
+    /**
+     * The process wide pool, created on first use.
+     */
+    static std::shared_ptr<CompletionQueuePool> getShared();
+
+    uint16_t getPollerThreadCount() const;
+
+    /**
+     * The number of streams currently bound to a poller thread of this pool.
+     */
+    size_t getStreamCount() const;
+
+    // Binds a stream to the least loaded poller, the stream starts all of its operations on the queue returned
+    ::grpc::CompletionQueue* attach();
+
+    // Releases the binding made by attach, once the stream has no operations outstanding
+    void detach(::grpc::CompletionQueue* queue);
+
+private:
+    struct Poller
+    {
+        ::grpc::CompletionQueue queue;
+        std::thread thread;
+        std::atomic<size_t> streams{0};
+    };
+
+    void pollerRunnable(Poller* poller);
+
+    std::vector<std::unique_ptr<Poller>> pollers;
+};
+
+} // namespace dfx::api::grpc
+
+#endif // DFX_API_GRPC_COMPLETION_QUEUE_POOL_H
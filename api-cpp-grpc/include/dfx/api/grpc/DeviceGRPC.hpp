@@ -37,7 +37,7 @@ public:
     CloudStatus remove(const CloudConfig& config, const std::string& deviceID) override;
 
 private:
-    std::unique_ptr<dfx::devices::v2::API::Stub> grpcDeviceStub;
+    std::shared_ptr<dfx::devices::v2::API::Stub> grpcDeviceStub;
 };
 
 } // namespace dfx::api::grpc
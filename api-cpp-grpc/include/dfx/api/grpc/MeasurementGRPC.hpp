@@ -35,7 +35,7 @@ public:
                                  std::vector<Measurement>& measurements) override;
 
 private:
-    std::unique_ptr<dfx::measurements::v2::API::Stub> grpcMeasurementsStub;
+    std::shared_ptr<dfx::measurements::v2::API::Stub> grpcMeasurementsStub;
 };
 
 } // namespace dfx::api::grpc
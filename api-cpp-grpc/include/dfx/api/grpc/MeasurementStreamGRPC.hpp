@@ -6,15 +6,18 @@
 #define DFX_API_CLOUD_MEASUREMENT_STREAM_GRPC_H
 
 #include "dfx/api/MeasurementStreamAPI.hpp"
+#include "dfx/api/grpc/CompletionQueuePool.hpp"
 #include "dfx/measurements/v2/measurements.grpc.pb.h"
 
+#include <chrono>
 #include <condition_variable>
 #include <mutex>
-#include <thread>
 
+#include <grpcpp/alarm.h>
+#include <grpcpp/generic/generic_stub.h>
 #include <grpcpp/grpcpp.h>
+#include <deque>
 #include <memory>
-#include <queue>
 #include <string>
 
 // A gRPC Measurement relies on bi-directional streaming which means we can send and receive multiple
@@ -22,15 +25,16 @@
 // stream but should not be performed concurrently with another Read or the order of delivery would not
 // be defined.
 //
-// We leverage the caller's thread to write messages immediately. Since the ReaderInterface blocks during
-// the Read() operation we process the reads in a dedicated read thread. Read() will return false when
+// We leverage the caller's thread to write messages immediately. Reads, and writes queued while another
+// is in flight, are completed on a poller thread of the shared CompletionQueuePool rather than a thread
+// of our own, so many concurrent measurements share a few threads. Read() will complete with !ok when
 // no more incoming messages, either because the server called WritesDone() or the stream failed/cancelled.
-// At this point, the reader thread is no longer required and terminates.
+// At this point, the stream finishes and releases its binding to the poller.
 //
-// The client can register a function callback (or lambda) and the reader thread will immediately,
-// pass the message to the callback - but the callback needs to be thread safe. Alternatively, if
-// no callback is registered this Measurement can be polled for results that are queued as they
-// are received.
+// The client can register a function callback (or lambda) and the poller thread will immediately,
+// pass the message to the callback - but the callback needs to be thread safe, and quick as it holds
+// up the other streams on the poller. Alternatively, if no callback is registered this Measurement
+// can be polled for results that are queued as they are received.
 //
 // @see https://grpc.github.io/grpc/cpp/classgrpc_1_1internal_1_1_reader_interface.html
 
@@ -39,7 +43,7 @@ namespace dfx::api::grpc
 
 class CloudGRPC;
 
-class MeasurementStreamGRPC : public MeasurementStreamAPI
+class MeasurementStreamGRPC : public MeasurementStreamAPI, private CompletionQueuePool::Handler
 {
 public:
     MeasurementStreamGRPC(const CloudConfig& config, const std::shared_ptr<CloudGRPC>& cloudGRPC);
@@ -52,6 +56,8 @@ public:
 
     CloudStatus sendChunk(const CloudConfig& config, const std::vector<uint8_t>& chunk, bool isLastChunk) override;
 
+    CloudStatus getQueueStatus(MeasurementQueueStatus& status) override;
+
     CloudStatus cancel(const CloudConfig& config) override;
 
     CloudStatus reset(const CloudConfig& config) override;
@@ -63,27 +69,40 @@ private:
 
     CloudStatus closeStream(CloudStatus status);
 
-    void readerThread(const CloudConfig& config);
+    // Called on the poller thread for every operation of the stream which completes
+    void handleEvent(int event, bool ok) override;
+    void handleStreamEvent(int event, bool ok);
+    void handleTimeout(bool ok, std::chrono::system_clock::time_point now);
+    void finishStream();
+
+    void startOperation();
+    void armTimeout();
+    void sendWritesDone();
+    void sendFinish();
+
     void handleReadResponse(const measurements::v2::StreamResponse& response);
-    void sendAsyncRequest(const CloudConfig& config, const measurements::v2::StreamRequest& request);
+    CloudStatus sendAsyncRequest(const CloudConfig& config,
+                                 measurements::v2::StreamRequest&& request,
+                                 ::grpc::Slice&& payload,
+                                 bool isLastChunk);
+    void stampQueuedChunks(const std::string& measurementID);
 
-    const std::chrono::time_point<std::chrono::system_clock> getDeadlineInMs(const unsigned int deadlineMs);
+    // Account for requests entering and leaving queuedRequests, lock must hold streamMutex
+    void queueRequest(::grpc::ByteBuffer&& request);
+    void dequeueRequests(size_t count);
 
 private:
     // recursive so setupStream and reset can call closeStream on failure
     std::recursive_mutex mutex;
     bool writerClosedStream;
 
-    std::mutex mutexMeasurementID;
-    std::condition_variable cvMeasurementID;
-    std::string measurementID;
-
-    ::grpc::ClientContext clientContext;
+    std::unique_ptr<::grpc::ClientContext> clientContext; // A context is good for one call, new for each stream
     std::shared_ptr<::grpc::Channel> grpcChannel;
-    ::grpc::CompletionQueue completionQueue;
-    std::unique_ptr<measurements::v2::API::Stub> measurementsStub;
-    std::unique_ptr<::grpc::ClientAsyncReaderWriter<measurements::v2::StreamRequest, measurements::v2::StreamResponse>>
-        measurementsStream;
+    std::shared_ptr<CompletionQueuePool> completionQueuePool;
+    ::grpc::CompletionQueue* completionQueue = nullptr; // Owned by the pool poller the stream is bound to
+    // Requests are serialized by us rather than the stream, so a chunk payload is copied once into a slice
+    std::unique_ptr<::grpc::GenericStub> measurementsStub;
+    std::unique_ptr<::grpc::GenericClientAsyncReaderWriter> measurementsStream;
 
     enum GrpcAsyncTag
     {
@@ -91,29 +110,58 @@ private:
         WriteDone,
         ReadDone,
         WritesDone,
-        FinishDone
+        FinishDone,
+        TimeoutDone
     };
     struct GrpcAsyncTags
     {
-        GrpcAsyncTag START_DONE = GrpcAsyncTag::StartDone;
-        GrpcAsyncTag WRITE_DONE = GrpcAsyncTag::WriteDone;
-        GrpcAsyncTag READ_DONE = GrpcAsyncTag::ReadDone;
-        GrpcAsyncTag WRITES_DONE = GrpcAsyncTag::WritesDone;
-        GrpcAsyncTag FINISH_DONE = GrpcAsyncTag::FinishDone;
+        CompletionQueuePool::Tag START_DONE;
+        CompletionQueuePool::Tag WRITE_DONE;
+        CompletionQueuePool::Tag READ_DONE;
+        CompletionQueuePool::Tag WRITES_DONE;
+        CompletionQueuePool::Tag FINISH_DONE;
+        CompletionQueuePool::Tag TIMEOUT_DONE;
     } tags;
 
-    std::mutex streamMutex;
-    std::unique_ptr<std::thread> pReaderThread;
-    std::condition_variable cvReaderDone;
-    bool readerWasStarted = false;
-    bool readerRunning = false;
+    // Only touched from the poller thread while the stream is running
+    ::grpc::ByteBuffer responseBuffer;
+    measurements::v2::StreamResponse response;
+    ::grpc::Status grpcStatus;
+    CloudStatus streamStatus = CloudStatus(CLOUD_OK);
+    ::grpc::Alarm timeoutAlarm;
+    std::chrono::milliseconds timeout;
+    std::chrono::system_clock::time_point lastEvent;
+    bool timeoutArmed;
+    bool readsDone;
+    bool finishSent;
+    bool finishReceived;
+
+    std::mutex streamMutex; // Protect - the stream state below and queuedRequests
+    std::condition_variable cvStream;
+    std::condition_variable cvSendQueue; // Room in queuedRequests for sendChunk, or the stream closing
+    std::string measurementID;           // Stamped on the chunks, queued without it until it arrives
+    bool streamRunning = false; // Until every operation has completed, the pollers are done with the stream
+    bool streamStarted = false; // The study ID has been written
+    bool closingStream = false;
+    bool writesDoneSent = false;
     bool sendingRequest = false;
-    bool readerShouldStop = false;
-    std::queue<measurements::v2::StreamRequest> queuedRequests;
+    size_t pendingOperations = 0;
+    struct QueuedRequest
+    {
+        ::grpc::ByteBuffer request; // Serialized, moved in rather than copied
+        std::chrono::steady_clock::time_point queued;
+        size_t bytes;
+
+        // A chunk sent before the measurement ID arrived, serialized into request once stamped with it
+        std::unique_ptr<measurements::v2::StreamRequest> unstampedChunk;
+        ::grpc::Slice payload;
+    };
+    std::deque<QueuedRequest> queuedRequests; // The write in flight at the front while sendingRequest
+    size_t queuedBytes = 0;
 
     uint16_t chunkOrder;
     bool isFirstChunk;
-    bool isLastChunk;
+    bool isLastChunk; // Protect - streamMutex once the stream is running
 };
 
 } // namespace dfx::api::grpc
@@ -38,7 +38,7 @@ public:
     CloudStatus removeUser(const CloudConfig& config, const std::string& userID, const std::string& email) override;
 
 private:
-    std::unique_ptr<dfx::users::v2::API::Stub> grpcUserStub;
+    std::shared_ptr<dfx::users::v2::API::Stub> grpcUserStub;
 };
 
 } // namespace dfx::api::grpc
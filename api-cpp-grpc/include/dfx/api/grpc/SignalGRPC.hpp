@@ -47,8 +47,8 @@ public:
                                       std::vector<Signal>& signalDetails) override;
 
 private:
-    std::unique_ptr<dfx::studysignals::v2::API::Stub> grpcStudySignalsStub;
-    std::unique_ptr<dfx::signals::v2::API::Stub> grpcSignalsStub;
+    std::shared_ptr<dfx::studysignals::v2::API::Stub> grpcStudySignalsStub;
+    std::shared_ptr<dfx::signals::v2::API::Stub> grpcSignalsStub;
 };
 
 } // namespace dfx::api::grpc
@@ -65,7 +65,7 @@ public:
                                    std::list<StudyTemplate>& studyTemplates) override;
 
 private:
-    std::unique_ptr<dfx::studies::v1::API::Stub> grpcStudiesStub;
+    std::shared_ptr<dfx::studies::v1::API::Stub> grpcStudiesStub;
 };
 
 } // namespace dfx::api::grpc
@@ -16,7 +16,11 @@
 #include <ctime>
 #include <fmt/format.h>
 #include <google/protobuf/util/time_util.h>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <tuple>
+#include <typeindex>
 
 // GRPC_VERBOSITY=DEBUG;GRPC_TRACE=all
 
@@ -46,6 +50,63 @@ using ::grpc::ClientContext;
         }                                                                                                              \
     }
 
+namespace
+{
+
+// Host, port, secure and root certificates, what a channel connects to and how
+using ChannelKey = std::tuple<std::string, int, bool, std::string>;
+
+struct CachedChannel
+{
+    std::shared_ptr<::grpc::Channel> channel;
+    std::map<std::type_index, std::shared_ptr<void>> stubs;
+};
+
+struct ChannelCache
+{
+    std::mutex mutex; // Protect - channels
+    std::map<ChannelKey, CachedChannel> channels;
+};
+
+ChannelCache& getChannelCache()
+{
+    // Never destroyed, tearing channels down from a static destructor races gRPC's own shutdown
+    static auto* cache = new ChannelCache();
+    return *cache;
+}
+
+std::shared_ptr<::grpc::Channel> createChannel(const std::string& targetAddress, bool secure, const std::string& rootCA)
+{
+    if (!secure) {
+        return ::grpc::CreateChannel(targetAddress, ::grpc::InsecureChannelCredentials());
+    } else {
+        ::grpc::SslCredentialsOptions ssl_options;
+
+        if (rootCA.length() > 0) {
+            ssl_options.pem_root_certs = rootCA;
+        }
+
+        ::grpc::ChannelArguments args;
+        return ::grpc::CreateCustomChannel(targetAddress, ::grpc::SslCredentials(ssl_options), args);
+    }
+}
+
+// The cache entry for config with a usable channel, cache.mutex must be held
+CachedChannel& findChannel(ChannelCache& cache,
+                           const CloudConfig& config,
+                           const std::string& targetAddress,
+                           const std::string& rootCA)
+{
+    auto& cached = cache.channels[ChannelKey(config.serverHost, config.serverPort, config.secure, rootCA)];
+    if (cached.channel == nullptr || cached.channel->GetState(false) == GRPC_CHANNEL_SHUTDOWN) {
+        cached.channel = createChannel(targetAddress, config.secure, rootCA);
+        cached.stubs.clear(); // They were bound to the old channel
+    }
+    return cached;
+}
+
+} // namespace
+
 CloudGRPC::CloudGRPC(const CloudConfig& config) : CloudAPI(config)
 {
     // Verifies that we have not accidentally linked against a version of the library which is incompatible
@@ -58,6 +119,9 @@ CloudStatus CloudGRPC::connect(const CloudConfig& config)
 {
     DFX_CLOUD_VALIDATOR_MACRO(CloudValidator, connect(config));
 
+    // Start connecting without waiting, so the first call is likely to find the connection ready
+    getChannel(config)->GetState(true);
+
     return CloudStatus(CLOUD_OK);
 }
 
@@ -198,7 +262,7 @@ CloudStatus CloudGRPC::login(CloudConfig& config)
     request.set_password(config.authPassword);
     request.set_organization_identifier(config.authOrg);
 
-    auto pAuth = dfx::auth::v1::API::NewStub(getChannel(config));
+    auto pAuth = getStub<dfx::auth::v1::API>(config);
 
     // Login is special, we can use it to "upgrade" our device token so we can
     // perform measurements, or we can just login and get a user token.
@@ -236,7 +300,7 @@ CloudStatus CloudGRPC::logout(CloudConfig& config)
     dfx::auth::v1::LogoutResponse response;
     dfx::auth::v1::LogoutRequest request;
 
-    auto pAuth = dfx::auth::v1::API::NewStub(getChannel(config));
+    auto pAuth = getStub<dfx::auth::v1::API>(config);
 
     ClientContext context;
     initializeClientContext(config, context, config.authToken);
@@ -254,7 +318,7 @@ CloudStatus CloudGRPC::registerDevice(CloudConfig& config,
 {
     DFX_CLOUD_VALIDATOR_MACRO(CloudValidator, registerDevice(config, appName, appVersion));
 
-    auto grpcDevices = dfx::devices::v2::API::NewStub(getChannel(config));
+    auto grpcDevices = getStub<dfx::devices::v2::API>(config);
 
     dfx::devices::v2::RegisterResponse response;
     dfx::devices::v2::RegisterRequest request;
@@ -307,7 +371,7 @@ CloudStatus CloudGRPC::unregisterDevice(CloudConfig& config)
 {
     DFX_CLOUD_VALIDATOR_MACRO(CloudValidator, unregisterDevice(config));
 
-    auto grpcDevices = dfx::devices::v2::API::NewStub(getChannel(config));
+    auto grpcDevices = getStub<dfx::devices::v2::API>(config);
 
     dfx::devices::v2::UnregisterResponse response;
     dfx::devices::v2::UnregisterRequest request;
@@ -325,7 +389,7 @@ CloudStatus CloudGRPC::verifyToken(const CloudConfig& config, std::string& _resp
 {
     DFX_CLOUD_VALIDATOR_MACRO(CloudValidator, verifyToken(config));
 
-    auto grpcAuth = dfx::auth::v1::API::NewStub(getChannel(config));
+    auto grpcAuth = getStub<dfx::auth::v1::API>(config);
 
     dfx::auth::v1::ValidateTokenRequest request;
     request.set_token(config.authToken);
@@ -364,7 +428,7 @@ CloudStatus CloudGRPC::switchEffectiveOrganization(CloudConfig& config, const st
     dfx::auth::v1::SwitchEffectiveOrganizationRequest request;
     request.set_effective_organization_identifier(organizationID);
 
-    auto grpcAuth = dfx::auth::v1::API::NewStub(getChannel(config));
+    auto grpcAuth = getStub<dfx::auth::v1::API>(config);
 
     ClientContext context;
     initializeClientContext(config, context, "");
@@ -411,20 +475,28 @@ std::shared_ptr<StudyAPI> CloudGRPC::study(const CloudConfig& config)
 
 std::shared_ptr<::grpc::Channel> CloudGRPC::getChannel(const CloudConfig& config)
 {
-    std::string targetAddress = getServerURL(config.serverHost, config.serverPort);
-    if (!config.secure) {
-        return ::grpc::CreateChannel(targetAddress, ::grpc::InsecureChannelCredentials());
-    } else {
-        ::grpc::SslCredentialsOptions ssl_options;
+    auto rootCA = config.secure ? getRootCA(config) : std::string();
 
-        std::string rootCA = getRootCA(config);
-        if (rootCA.length() > 0) {
-            ssl_options.pem_root_certs = rootCA;
-        }
+    auto& cache = getChannelCache();
+    std::lock_guard<std::mutex> lock(cache.mutex); // Protect - channels
+    return findChannel(cache, config, getServerURL(config.serverHost, config.serverPort), rootCA).channel;
+}
 
-        ::grpc::ChannelArguments args;
-        return ::grpc::CreateCustomChannel(targetAddress, ::grpc::SslCredentials(ssl_options), args);
+std::shared_ptr<void> CloudGRPC::getCachedStub(
+    const CloudConfig& config,
+    const std::type_info& service,
+    const std::function<std::shared_ptr<void>(const std::shared_ptr<::grpc::Channel>&)>& createStub)
+{
+    auto rootCA = config.secure ? getRootCA(config) : std::string();
+
+    auto& cache = getChannelCache();
+    std::lock_guard<std::mutex> lock(cache.mutex); // Protect - channels
+    auto& cached = findChannel(cache, config, getServerURL(config.serverHost, config.serverPort), rootCA);
+    auto& stub = cached.stubs[std::type_index(service)];
+    if (stub == nullptr) {
+        stub = createStub(cached.channel);
     }
+    return stub;
 }
 
 const std::string& CloudGRPC::getTransportType()
@@ -0,0 +1,86 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/grpc/CompletionQueuePool.hpp"
+
+#include <algorithm>
+
+using dfx::api::grpc::CompletionQueuePool;
+
+CompletionQueuePool::CompletionQueuePool(uint16_t pollerThreads)
+{
+    pollerThreads = std::max<uint16_t>(pollerThreads, 1);
+
+    for (uint16_t index = 0; index < pollerThreads; index++) {
+        auto poller = std::make_unique<Poller>();
+        poller->thread = std::thread(&CompletionQueuePool::pollerRunnable, this, poller.get());
+        pollers.push_back(std::move(poller));
+    }
+}
+
+CompletionQueuePool::~CompletionQueuePool()
+{
+    // Next() keeps returning what is left on a queue after Shutdown() and only then returns false
+    for (auto& poller : pollers) {
+        poller->queue.Shutdown();
+    }
+
+    for (auto& poller : pollers) {
+        if (poller->thread.joinable()) {
+            poller->thread.join();
+        }
+    }
+}
+
+std::shared_ptr<CompletionQueuePool> CompletionQueuePool::getShared()
+{
+    // Lives for the remainder of the process, streams hold a reference so any still running during
+    // static destruction keep it alive until they are done with it.
+    static std::shared_ptr<CompletionQueuePool> sharedPool = std::make_shared<CompletionQueuePool>();
+    return sharedPool;
+}
+
+uint16_t CompletionQueuePool::getPollerThreadCount() const
+{
+    return static_cast<uint16_t>(pollers.size());
+}
+
+size_t CompletionQueuePool::getStreamCount() const
+{
+    size_t streams = 0;
+    for (const auto& poller : pollers) {
+        streams += poller->streams;
+    }
+    return streams;
+}
+
+::grpc::CompletionQueue* CompletionQueuePool::attach()
+{
+    auto leastLoaded = std::min_element(pollers.begin(), pollers.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs->streams < rhs->streams;
+    });
+
+    auto* poller = leastLoaded->get();
+    poller->streams++;
+    return &poller->queue;
+}
+
+void CompletionQueuePool::detach(::grpc::CompletionQueue* queue)
+{
+    for (auto& poller : pollers) {
+        if (&poller->queue == queue) {
+            poller->streams--;
+            return;
+        }
+    }
+}
+
+void CompletionQueuePool::pollerRunnable(Poller* poller)
+{
+    void* receivedTag;
+    bool ok = false;
+    while (poller->queue.Next(&receivedTag, &ok)) {
+        auto* tag = static_cast<Tag*>(receivedTag);
+        tag->handler->handleEvent(tag->event, ok);
+    }
+}
@@ -22,7 +22,7 @@ using namespace ::grpc;
 
 DeviceGRPC::DeviceGRPC(const CloudConfig& config, const std::shared_ptr<CloudGRPC>& cloudGRPC)
 {
-    grpcDeviceStub = dfx::devices::v2::API::NewStub(cloudGRPC->getChannel(config));
+    grpcDeviceStub = cloudGRPC->getStub<dfx::devices::v2::API>(config);
 }
 
 CloudStatus create(const CloudConfig& config,
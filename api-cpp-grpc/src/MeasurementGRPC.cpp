@@ -24,7 +24,7 @@ using namespace ::grpc;
 
 MeasurementGRPC::MeasurementGRPC(const CloudConfig& config, const std::shared_ptr<CloudGRPC>& cloudGRPC)
 {
-    grpcMeasurementsStub = dfx::measurements::v2::API::NewStub(cloudGRPC->getChannel(config));
+    grpcMeasurementsStub = cloudGRPC->getStub<dfx::measurements::v2::API>(config);
 }
 
 CloudStatus MeasurementGRPC::list(const CloudConfig& config,
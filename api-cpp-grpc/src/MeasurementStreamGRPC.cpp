@@ -8,9 +8,12 @@
 #include "dfx/action/v1/action.pb.h"
 
 #include "fmt/format.h"
+#include <cassert>
 #include <chrono>
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/io/zero_copy_stream_impl_lite.h>
 #include <google/protobuf/util/time_util.h>
-#include <thread>
+#include <type_traits>
 
 using dfx::api::CloudAPI;
 using dfx::api::CloudConfig;
@@ -20,6 +23,51 @@ using namespace dfx::api::grpc;
 
 using namespace std::chrono_literals;
 
+namespace
+{
+using StreamRequest = dfx::measurements::v2::StreamRequest;
+using StreamResponse = dfx::measurements::v2::StreamResponse;
+using StreamChunk = std::decay_t<decltype(std::declval<StreamRequest>().chunk())>;
+
+const uint32_t WIRETYPE_LENGTH_DELIMITED = 2; // Protobuf wire type of embedded messages and bytes
+
+::grpc::ByteBuffer serializeRequest(const StreamRequest& request)
+{
+    ::grpc::ByteBuffer buffer;
+    bool ownBuffer;
+    ::grpc::SerializationTraits<StreamRequest>::Serialize(request, &buffer, &ownBuffer);
+    return buffer;
+}
+
+// Serializes a StreamRequest holding the chunk with the payload as it would be, but the payload is a
+// slice of its own following the chunk's other fields. Framing the chunk ourselves means the payload is
+// copied once, into its slice, rather than into the message's string and again when that is serialized.
+::grpc::ByteBuffer serializeChunkRequest(const StreamChunk& chunk, const ::grpc::Slice& payload)
+{
+    using google::protobuf::io::CodedOutputStream;
+
+    const auto chunkTag = static_cast<uint32_t>(StreamRequest::kChunkFieldNumber) << 3 | WIRETYPE_LENGTH_DELIMITED;
+    const auto payloadTag = static_cast<uint32_t>(StreamChunk::kPayloadFieldNumber) << 3 | WIRETYPE_LENGTH_DELIMITED;
+    const auto payloadSize = static_cast<uint32_t>(payload.size());
+    const auto chunkSize = static_cast<uint32_t>(chunk.ByteSizeLong()) + CodedOutputStream::VarintSize32(payloadTag) +
+                           CodedOutputStream::VarintSize32(payloadSize) + payloadSize;
+
+    std::string header;
+    {
+        google::protobuf::io::StringOutputStream stream(&header);
+        CodedOutputStream output(&stream);
+        output.WriteTag(chunkTag);
+        output.WriteVarint32(chunkSize);
+        chunk.SerializeToCodedStream(&output);
+        output.WriteTag(payloadTag);
+        output.WriteVarint32(payloadSize);
+    }
+
+    ::grpc::Slice slices[] = {::grpc::Slice(header), payload};
+    return ::grpc::ByteBuffer(slices, 2);
+}
+} // namespace
+
 // gRPC measurements function on a bi-directional stream but are only good for one measurement.
 //
 // They expect:
@@ -33,15 +81,19 @@ using namespace std::chrono_literals;
 // handed though the Context timeout, but for a streaming service the Context timeout
 // is applied to the duration of the stream and not the message which is not useful.
 //
-// Normally a CompletionQueue would be used to multiplex many end-points s this nice
-// example illustrates:
-// https://stackoverflow.com/questions/67784384/c-grpc-clientasyncreaderwriter-how-to-check-if-data-is-available-for-read
-// The use of a CompletionQueue is complicated because the request / response happen
-// asynchronously... all so it can be assured that the client is able to attach
-// a timeout for how long they are willing to wait on a response. Rather than blocking
-// the client send thread, the request is queued if the CompletionQueue is busy.
+// The CompletionQueue is one of the shared CompletionQueuePool, so streams no longer
+// cost a thread each. The stream is a small state machine driven by handleEvent() on
+// the poller thread it is bound to, the timeout is an Alarm on the same queue which is
+// pushed back by every event. Rather than blocking the client send thread, the request
+// is queued if a write is already in flight.
 
 MeasurementStreamGRPC::MeasurementStreamGRPC(const CloudConfig& config, const std::shared_ptr<CloudGRPC>& cloudGRPC)
+    : tags{{this, GrpcAsyncTag::StartDone},
+           {this, GrpcAsyncTag::WriteDone},
+           {this, GrpcAsyncTag::ReadDone},
+           {this, GrpcAsyncTag::WritesDone},
+           {this, GrpcAsyncTag::FinishDone},
+           {this, GrpcAsyncTag::TimeoutDone}}
 {
     // Defer channel into setupStream - using it as a flag to indicate active
     initialize();
@@ -49,27 +101,38 @@ MeasurementStreamGRPC::MeasurementStreamGRPC(const CloudConfig& config, const st
 
 MeasurementStreamGRPC::~MeasurementStreamGRPC()
 {
-    // The Reader thread is holding a "this" pointer and we have to keep ourselves
-    // alive until the thread exits or it's variables will be obliterated. The closeStream()
-    // will force gRPC to start a shutdown, which will wake up the gRPC Read() bue we
-    // need to wait until thread exits before continuing.
+    // The poller threads hold a "this" pointer while the stream is running and we have to
+    // keep ourselves alive until they are done with it. The closeStream() will force gRPC to
+    // start a shutdown and waits until the last operation of the stream has completed.
     closeStream(CloudStatus(CLOUD_OK));
-
-    if (readerWasStarted) {
-        pReaderThread->join();
-    }
 }
 
 // Shared with constructor and reset to ensure consistency
 void MeasurementStreamGRPC::initialize()
 {
+    measurementsStream = nullptr; // Lives in the call's arena, must go before the context holding the call
     grpcChannel = nullptr;
     measurementsStub = nullptr;
-    measurementID = "";
     chunkOrder = 0;
     isFirstChunk = true;
     isLastChunk = false;
     writerClosedStream = false;
+
+    streamStatus = CloudStatus(CLOUD_OK);
+    timeoutArmed = false;
+    readsDone = false;
+    finishSent = false;
+    finishReceived = false;
+
+    std::lock_guard lock(streamMutex);
+    measurementID = "";
+    streamStarted = false;
+    closingStream = false;
+    writesDoneSent = false;
+    sendingRequest = false;
+    pendingOperations = 0;
+    queuedRequests.clear();
+    queuedBytes = 0;
 }
 
 CloudStatus MeasurementStreamGRPC::setupStream(const CloudConfig& config,
@@ -96,62 +159,59 @@ CloudStatus MeasurementStreamGRPC::setupStream(const CloudConfig& config,
     }
 
     grpcChannel = CloudGRPC::getChannel(config);
-    measurementsStub = dfx::measurements::v2::API::NewStub(grpcChannel);
+    measurementsStub = std::make_unique<::grpc::GenericStub>(grpcChannel);
 
     // gRPC Measurement stream requires a bearer token which is obtained from a DeviceToken
     // which is upgraded to a UserToken. ie. You must first registerDevice, then login
     // to obtain the UserToken credentials necessary to make a call.
-    CloudGRPC::setAuthTokenClientContext(config, clientContext, config.authToken);
+    clientContext = std::make_unique<::grpc::ClientContext>();
+    CloudGRPC::setAuthTokenClientContext(config, *clientContext, config.authToken);
     // SKIP the deadline on the stream
 
-    measurementsStream = measurementsStub->PrepareAsyncStream(&clientContext, &completionQueue);
-    measurementsStream->StartCall(&tags.START_DONE);
-    void* got_tag;
-    bool ok = false;
-    ::grpc::CompletionQueue::NextStatus status =
-        completionQueue.AsyncNext(&got_tag, &ok, getDeadlineInMs(config.timeoutMillis));
-    switch (status) {
-        case ::grpc::CompletionQueue::NextStatus::TIMEOUT:
-            return CloudStatus(CLOUD_TIMEOUT, "Timeout on stream setup");
-        case ::grpc::CompletionQueue::NextStatus::GOT_EVENT:
-            break;
-        case ::grpc::CompletionQueue::NextStatus::SHUTDOWN:
-            return CloudStatus(CLOUD_TRANSPORT_CLOSED, "Shutdown on stream setup");
+    if (completionQueuePool == nullptr) {
+        completionQueuePool = CompletionQueuePool::getShared();
     }
-    assert(status == ::grpc::CompletionQueue::NextStatus::GOT_EVENT && ok == 1 &&
-           *(static_cast<int*>(got_tag)) == tags.START_DONE);
+    completionQueue = completionQueuePool->attach();
+    timeout = std::chrono::milliseconds(config.timeoutMillis);
 
     // Opening a new measurement, we need to tell it the study_id to use on our first request.
+    // It is written as soon as the call has started.
     dfx::measurements::v2::StreamRequest request;
     auto pSetting = request.mutable_setting();
     pSetting->set_study_id(studyID);
 
-    measurementsStream->Write(request, &tags.WRITE_DONE);
+    {
+        std::lock_guard streamLock(streamMutex);
+        queueRequest(serializeRequest(request));
+        sendingRequest = true;
+        streamRunning = true;
+        pendingOperations = 1; // Starting the call, the poller owns the stream from here
+    }
 
-    ok = false;
-    status = completionQueue.AsyncNext(&got_tag, &ok, getDeadlineInMs(config.timeoutMillis));
-    switch (status) {
-        case ::grpc::CompletionQueue::NextStatus::TIMEOUT:
-            return CloudStatus(CLOUD_TIMEOUT, "Timeout on sending study id");
-        case ::grpc::CompletionQueue::NextStatus::GOT_EVENT:
-            // The studyID write acknowledgement... the only thing it can be
-            break;
-        case ::grpc::CompletionQueue::NextStatus::SHUTDOWN:
-            return CloudStatus(CLOUD_TRANSPORT_CLOSED, "Shutdown on stream during study initialization");
-    }
-
-    if (status == ::grpc::CompletionQueue::NextStatus::GOT_EVENT) {
-        // Sometimes, unreliably, seen strings in the debug_error_string... this check
-        // might not be doing anything but hoping it caches some early closures before
-        // we go to the effort of starting up a thread.
-        bool stillValid = clientContext.debug_error_string().empty();
-        if (stillValid) {
-            // It appears we can communicate, start our thread to handle server responses.
-            pReaderThread = std::make_unique<std::thread>(&MeasurementStreamGRPC::readerThread, this, config);
-            return CloudStatus(CLOUD_OK);
+    auto method = fmt::format("/{}/Stream", dfx::measurements::v2::API::service_full_name());
+    measurementsStream = measurementsStub->PrepareCall(clientContext.get(), method, completionQueue);
+    measurementsStream->StartCall(&tags.START_DONE);
+
+    {
+        std::unique_lock<std::mutex> streamLock(streamMutex);
+        bool settled = cvStream.wait_for(streamLock, timeout, [this] { return streamStarted || !streamRunning; });
+        if (!settled) {
+            streamLock.unlock();
+            return closeStream(CloudStatus(CLOUD_TIMEOUT, "Timeout on stream setup"));
+        }
+        if (!streamStarted) {
+            streamLock.unlock();
+            return closeStream(CloudStatus(CLOUD_TRANSPORT_CLOSED, "Shutdown on stream during study initialization"));
         }
     }
 
+    // Sometimes, unreliably, seen strings in the debug_error_string... this check
+    // might not be doing anything but hoping it caches some early closures.
+    bool stillValid = clientContext->debug_error_string().empty();
+    if (stillValid) {
+        return CloudStatus(CLOUD_OK);
+    }
+
     return closeStream(CloudStatus(CLOUD_INTERNAL_ERROR, "Received unexpected event"));
 }
 
@@ -160,31 +220,27 @@ CloudStatus MeasurementStreamGRPC::closeStream(CloudStatus status)
     // Hold lock for duration of method, we don't want multiple threads to attempt to close
     std::unique_lock<std::recursive_mutex> lock(mutex);
 
-    if (isMeasurementClosed(status)) {
-        return status; // if it has already been closed, nothing left to do
+    // We won't be writing anymore, if the stream is still running cancel it and wait for the
+    // pollers to complete its last operation.
+    bool running;
+    {
+        std::lock_guard streamLock(streamMutex);
+        running = streamRunning;
+        closingStream = running;
     }
+    if (running) {
+        clientContext->TryCancel();
 
-    // We won't be writing anymore, the connection appears to be closing.
+        std::unique_lock<std::mutex> streamLock(streamMutex);
+        cvStream.wait(streamLock, [this] { return !streamRunning; });
+    }
 
-    // Wait for reader thread to terminate sequence...
-    if (readerWasStarted && readerRunning) {
-        std::unique_lock<std::mutex> lock(streamMutex);
-        readerShouldStop = true;
-        cvReaderDone.wait(lock); // Nope, need to wait until we get notified
+    if (isMeasurementClosed(status)) {
+        return status; // if it has already been closed, nothing left to do
     }
 
     status = closeMeasurement(status);
 
-    {
-        // Stream is being closed, don't let any sendChunk threads waiting on a
-        // measurement ID wait any longer, this stream is being closed.
-        //
-        // Needs to occur AFTER closeMeasurement to ensure the awoken thread
-        // will return the proper status value to calling client
-        std::unique_lock<std::mutex> lock(mutexMeasurementID);
-        cvMeasurementID.notify_all();
-    }
-
     return status;
 }
 
@@ -195,7 +251,7 @@ CloudStatus MeasurementStreamGRPC::reset(const CloudConfig& config)
     // Notify server if we haven't already
     cancel(config);
 
-    // Ensure the current thread and stream is cleaned up
+    // Ensure the current stream is cleaned up
     auto status = closeStream(CloudStatus(CLOUD_OK));
 
     // Reset the state back to the constructed state
@@ -204,130 +260,205 @@ CloudStatus MeasurementStreamGRPC::reset(const CloudConfig& config)
     return status;
 }
 
-const std::chrono::time_point<std::chrono::system_clock>
-MeasurementStreamGRPC::getDeadlineInMs(const unsigned int deadlineMs)
+void MeasurementStreamGRPC::handleEvent(int event, bool ok)
 {
-    const std::chrono::time_point<std::chrono::system_clock> deadline =
-        std::chrono::system_clock::now() + std::chrono::milliseconds(deadlineMs);
-    return deadline;
-}
+    auto now = std::chrono::system_clock::now();
+    if (event == GrpcAsyncTag::TimeoutDone) {
+        handleTimeout(ok, now);
+    } else {
+        lastEvent = now; // Any event shows the stream is alive, pushing back the timeout
+        handleStreamEvent(event, ok);
+    }
 
-void MeasurementStreamGRPC::readerThread(const CloudConfig& config)
-{
+    bool finished;
     {
-        std::unique_lock<std::recursive_mutex> lock(mutex);
-        readerWasStarted = true;
-        readerRunning = true;
+        std::lock_guard lock(streamMutex);
+        pendingOperations--;
+        finished = finishReceived && pendingOperations == 0;
     }
+    if (finished) {
+        finishStream(); // Nothing may touch the stream after this
+    }
+}
 
-    dfx::measurements::v2::StreamResponse response;
-    ::grpc::CompletionQueue::NextStatus status;
-    ::grpc::Status grpcStatus;
-
-    measurementsStream->Read(&response, &tags.READ_DONE);
-
-    CloudStatus cloudStatus(CLOUD_OK);
-    bool shutdown = false;
-    bool writesDoneSent = false;
-    bool finishDoneSent = false;
-    while (!shutdown) {
-        void* receivedTag;
-        bool ok = false;
+void MeasurementStreamGRPC::handleStreamEvent(int event, bool ok)
+{
+    if (event == GrpcAsyncTag::StartDone) {
+        armTimeout(); // Started or not, from here on the stream needs to hear something every timeout
+    }
 
-        status = completionQueue.AsyncNext(&receivedTag, &ok, getDeadlineInMs(config.timeoutMillis));
+    // A response gRPC read but we cannot parse fails the read, as it would have on a typed stream
+    if (ok && event == GrpcAsyncTag::ReadDone &&
+        !::grpc::SerializationTraits<StreamResponse>::Deserialize(&responseBuffer, &response).ok()) {
+        streamStatus = CloudStatus(CLOUD_INTERNAL_ERROR, "Unable to parse stream response");
+        clientContext->TryCancel();
+        ok = false;
+    }
 
-        GrpcAsyncTag* tag = reinterpret_cast<GrpcAsyncTag*>(receivedTag);
-        switch (status) {
-            case ::grpc::CompletionQueue::NextStatus::TIMEOUT:
-                if (cloudStatus.OK()) {
-                    cloudStatus = CloudStatus(CLOUD_TIMEOUT, "Try increasing CloudConfig timeout");
-                }
-                if (!writesDoneSent) { // Tell the server we are done
-                    writesDoneSent = true;
-                    measurementsStream->WritesDone(&tags.WRITES_DONE);
-                }
-                break;
-            case ::grpc::CompletionQueue::NextStatus::GOT_EVENT:
-                break;
-            case ::grpc::CompletionQueue::NextStatus::SHUTDOWN:
-                // Not sure the circumstance of this event, difficult to simulate
-                cloudStatus = CloudStatus(CLOUD_TRANSPORT_CLOSED, "Received shutdown event");
-                shutdown = true;
-                continue;
+    // We can get an event which is not ok, and still get subsequent events. To be a nice
+    // client we need to notify the server we are done writing and want to finish.
+    if (!ok) {
+        if (event == GrpcAsyncTag::ReadDone) {
+            readsDone = true;
+        } else if (event == GrpcAsyncTag::WriteDone || event == GrpcAsyncTag::StartDone) {
+            std::lock_guard lock(streamMutex); // A failed write, or a call which never started to write the study ID
+            sendingRequest = false;
+            dequeueRequests(queuedRequests.size()); // None of them will be written now
         }
+        // We are done, get the final status
+        if (!writesDoneSent) { // Tell the server we are done
+            sendWritesDone();
+        } else if (!finishSent) {
+            sendFinish();
+        }
+        return;
+    }
 
-        // We can get an event which is not ok, and still get subsequent events. To be a nice
-        // client we need to notify the server we are done writing and want to finish.
-        if (!ok) {
-            // We are done, get the final status
-            if (!writesDoneSent) { // Tell the server we are done
-                writesDoneSent = true;
+    switch (event) {
+        case GrpcAsyncTag::StartDone: {
+            // The call is up, write the study ID setupStream queued and start reading
+            {
+                std::lock_guard lock(streamMutex);
+                pendingOperations++;
+                measurementsStream->Write(queuedRequests.front().request, &tags.WRITE_DONE);
+            }
+            startOperation();
+            measurementsStream->Read(&responseBuffer, &tags.READ_DONE);
+            break;
+        }
+        case GrpcAsyncTag::ReadDone:
+            handleReadResponse(response);
+            startOperation();
+            measurementsStream->Read(&responseBuffer, &tags.READ_DONE);
+            break;
+        case GrpcAsyncTag::WriteDone: {
+            std::lock_guard lock(streamMutex);
+            if (!streamStarted) { // The study ID write acknowledgement, setupStream is waiting on it
+                streamStarted = true;
+                cvStream.notify_all();
+            }
+            dequeueRequests(1); // Written, making room for a sendChunk which may be waiting
+            if (writesDoneSent) {
+                // Asked for while this write was in flight, gRPC only allows one at a time
+                sendingRequest = false;
+                pendingOperations++;
                 measurementsStream->WritesDone(&tags.WRITES_DONE);
+            } else if (!queuedRequests.empty() && queuedRequests.front().unstampedChunk == nullptr) {
+                pendingOperations++;
+                measurementsStream->Write(queuedRequests.front().request, &tags.WRITE_DONE);
             } else {
-                if (!finishDoneSent) {
-                    finishDoneSent = true;
-                    measurementsStream->Finish(&grpcStatus, &tags.FINISH_DONE);
+                sendingRequest = false; // Until another chunk, or the measurement ID to stamp those queued
+                if (isLastChunk && queuedRequests.empty()) {
+                    // This was our last chunk, tell the server we are done writing.
+                    writesDoneSent = true;
+                    pendingOperations++;
+                    measurementsStream->WritesDone(&tags.WRITES_DONE);
                 }
             }
-            continue;
+            break;
         }
-
-        switch (*tag) {
-            case GrpcAsyncTag::ReadDone:
-                handleReadResponse(response);
-                measurementsStream->Read(&response, &tags.READ_DONE);
-                break;
-            case GrpcAsyncTag::WriteDone: {
-                if (!writesDoneSent) { // If we have already sent the writesDone event, do not write anything more
-                    std::lock_guard lock(streamMutex);
-                    if (!queuedRequests.empty()) {
-                        measurementsStream->Write(queuedRequests.front(), &tags.WRITE_DONE);
-                        queuedRequests.pop();
-                    } else {
-                        sendingRequest = false;
-                        if (isLastChunk) {
-                            // This was our last chunk, tell the server we are done writing.
-                            writesDoneSent = true;
-                            measurementsStream->WritesDone(&tags.WRITES_DONE);
-                        }
-                    }
-                }
-                break;
+        case GrpcAsyncTag::WritesDone:
+            writerClosedStream = true;
+            if (readsDone && !finishSent) { // The server has already stopped sending, nothing left but the status
+                sendFinish();
             }
-            case GrpcAsyncTag::WritesDone: {
-                // If this was our last, hint to the server we are done writing.
-                std::unique_lock<std::recursive_mutex> lock(mutex);
-                writerClosedStream = true;
-                break;
+            break;
+        case GrpcAsyncTag::FinishDone:
+            if (streamStatus.OK()) { // If we were still in good standing, give grpc stream a chance to weigh in
+                // This can return bad Study ID, possibly others?
+                streamStatus = CloudGRPC::translateGrpcStatus(grpcStatus);
             }
-            case GrpcAsyncTag::StartDone:
-                assert(*tag != GrpcAsyncTag::StartDone); // Unexpected START Event
-                break;
-            case GrpcAsyncTag::FinishDone:
-                if (cloudStatus.OK()) { // If we were still in good standing, give grpc stream a chance to weigh in
-                    // This can return bad Study ID, possibly others?
-                    cloudStatus = CloudGRPC::translateGrpcStatus(grpcStatus);
-                }
-                shutdown = true;
-                break;
-            default:
-                assert(false); // Unexpected event
+            finishReceived = true;
+            if (timeoutArmed) {
+                timeoutAlarm.Cancel(); // Completes right away, it is the last operation we wait on
+            }
+            break;
+        default:
+            assert(false); // Unexpected event
+    }
+}
+
+void MeasurementStreamGRPC::handleTimeout(bool ok, std::chrono::system_clock::time_point now)
+{
+    timeoutArmed = false;
+    if (!ok || finishReceived) {
+        return; // Cancelled, the stream has finished
+    }
+
+    if (now - lastEvent >= timeout) {
+        // Nothing heard for a whole timeout, each one in a row moves the stream a step closer to closed
+        if (streamStatus.OK()) {
+            streamStatus = CloudStatus(CLOUD_TIMEOUT, "Try increasing CloudConfig timeout");
+        }
+        if (!writesDoneSent) { // Tell the server we are done
+            sendWritesDone();
+        } else if (!finishSent) {
+            sendFinish();
+        } else {
+            clientContext->TryCancel();
         }
+        lastEvent = now;
     }
+    armTimeout();
+}
 
-    // If we have reached here - the server is done - quit allowing any more messages and shut
-    // the stream down.
+void MeasurementStreamGRPC::finishStream()
+{
+    // If the client is closing the stream, it closes the measurement with its own status
+    bool closing;
     {
-        std::unique_lock<std::recursive_mutex> lock(mutex);
-        readerRunning = false;
+        std::lock_guard lock(streamMutex);
+        closing = closingStream;
+    }
+    if (!closing) {
+        closeMeasurement(streamStatus);
     }
 
-    closeStream(cloudStatus);
+    completionQueuePool->detach(completionQueue);
 
-    // If the sender thread initiated a close, it will block waiting for this thread to terminate. Notify it
-    // that the thread is now terminated and it can continue the shutdown.
+    // A thread closing the stream is waiting on this and may destroy it as soon as it is notified
     std::unique_lock<std::mutex> lock(streamMutex);
-    cvReaderDone.notify_all();
+    dequeueRequests(queuedRequests.size());
+    streamRunning = false;
+    cvStream.notify_all();
+}
+
+void MeasurementStreamGRPC::startOperation()
+{
+    std::lock_guard lock(streamMutex);
+    pendingOperations++;
+}
+
+void MeasurementStreamGRPC::armTimeout()
+{
+    startOperation();
+    timeoutArmed = true;
+    timeoutAlarm.Set(completionQueue, lastEvent + timeout, &tags.TIMEOUT_DONE);
+}
+
+void MeasurementStreamGRPC::sendWritesDone()
+{
+    std::lock_guard lock(streamMutex);
+    writesDoneSent = true; // Nothing more is written from here on
+    if (sendingRequest) {
+        // The write in flight is the front of the queue and can't be taken back, drop what is behind it
+        while (queuedRequests.size() > 1) {
+            queuedBytes -= queuedRequests.back().bytes;
+            queuedRequests.pop_back();
+        }
+        cvSendQueue.notify_all();
+        return; // Sent once the write in flight completes, gRPC only allows one at a time
+    }
+    dequeueRequests(queuedRequests.size());
+    pendingOperations++;
+    measurementsStream->WritesDone(&tags.WRITES_DONE);
+}
+
+void MeasurementStreamGRPC::sendFinish()
+{
+    finishSent = true;
+    startOperation();
+    measurementsStream->Finish(&grpcStatus, &tags.FINISH_DONE);
 }
 
 CloudStatus MeasurementStreamGRPC::sendChunk(const CloudConfig& config,
@@ -336,53 +467,48 @@ CloudStatus MeasurementStreamGRPC::sendChunk(const CloudConfig& config,
 {
     CloudStatus status(CLOUD_OK);
 
-    // Need to check before waiting on condition, reader thread may never set
     if (isMeasurementClosed(status)) {
         return status; // if it has already been closed.
     }
 
-    // We need a measurement_id to fill into the session_id property here.
-    // Yes, that makes zero sense to me too but that is what is required.
-    //
-    // When the stream was setup, a request to get a measurement_id was
-    // performed and so we likely have one but depending on server load
-    // and how quick we follow with a sendChunk we may need to block to
-    // await a measurement_id to continue with this request.
-    std::string measurementID;
-    {
-        std::unique_lock<std::mutex> lock(mutexMeasurementID);
-        if (this->measurementID.empty()) { // Did we get anything back yet?
-            cvMeasurementID.wait(lock);    // Nope, need to wait until we get notified
-
-            // If we got woke up, we should have a measurement ID or the stream has been closed
-            if (isMeasurementClosed(status)) {
-                return status; // if it has already been closed.
-            }
-            assert(!this->measurementID.empty());
-        }
-        measurementID = this->measurementID;
-    }
-
     dfx::measurements::v2::StreamRequest request;
 
     dfx::action::v1::PayloadAction action(dfx::action::v1::PayloadAction::PROCESS);
     if (isFirstChunk) {
         action = dfx::action::v1::PayloadAction::FIRST;
-        isFirstChunk = false; // No longer our first request
     }
     if (isLastChunk) { // If this is the last, let the server know (more important then knowing it is first)
         action = dfx::action::v1::PayloadAction::LAST;
-        this->isLastChunk = isLastChunk;
     }
 
     auto pChunk = request.mutable_chunk();
     pChunk->set_action(action);
-    pChunk->set_chunk_order(chunkOrder++); // Server expects sequential ordering
-    pChunk->set_session_id(measurementID);
-    pChunk->set_payload(std::string(chunk.begin(), chunk.end())); // gRPC uses strings for byte arrays
+    pChunk->set_chunk_order(chunkOrder); // Server expects sequential ordering
+
+    // The session_id is the measurement_id the server answers the study ID with, yes that makes zero
+    // sense to me too but that is what is required. Rather than wait out the round trip for it, chunks
+    // sent before it arrives are queued and stamped with it as it does.
+    ::grpc::Slice payload(chunk.data(), chunk.size()); // The one copy made of the chunk
+    status = sendAsyncRequest(config, std::move(request), std::move(payload), isLastChunk);
+    if (status.code == CLOUD_WOULD_BLOCK) {
+        return status; // Not queued, the same chunk can be sent again once there is room
+    }
 
-    sendAsyncRequest(config, request);
+    chunkOrder++;
+    isFirstChunk = false; // No longer our first request
+    return status;
+}
 
+CloudStatus MeasurementStreamGRPC::getQueueStatus(MeasurementQueueStatus& status)
+{
+    std::lock_guard lock(streamMutex);
+    status.queuedMessages = queuedRequests.size();
+    status.queuedBytes = queuedBytes;
+    status.oldestQueuedMillis = 0;
+    if (!queuedRequests.empty()) {
+        auto waited = std::chrono::steady_clock::now() - queuedRequests.front().queued;
+        status.oldestQueuedMillis = std::chrono::duration_cast<std::chrono::milliseconds>(waited).count();
+    }
     return CloudStatus(CLOUD_OK);
 }
 
@@ -397,23 +523,112 @@ CloudStatus MeasurementStreamGRPC::cancel(const CloudConfig& config)
     }
 
     // Best effort... out-of-band signal if we are not already closed
-    clientContext.TryCancel();
+    if (clientContext != nullptr) {
+        clientContext->TryCancel();
+    }
 
     return status;
 }
 
-void MeasurementStreamGRPC::sendAsyncRequest(const CloudConfig& config,
-                                             const dfx::measurements::v2::StreamRequest& request)
+CloudStatus MeasurementStreamGRPC::sendAsyncRequest(const CloudConfig& config,
+                                                    dfx::measurements::v2::StreamRequest&& request,
+                                                    ::grpc::Slice&& payload,
+                                                    bool isLastChunk)
+{
+    const auto bytes = request.ByteSizeLong() + payload.size(); // Close enough while the chunk is unstamped
+    bool closing = false;
+    auto hasRoom = [this, &config, bytes, &closing] {
+        closing = !streamRunning || writesDoneSent;
+
+        // A request larger than the byte limit is let through once the queue is empty
+        bool bytesFit = config.sendQueueMaxBytes == 0 || queuedRequests.empty() ||
+                        queuedBytes + bytes <= config.sendQueueMaxBytes;
+        bool messagesFit = config.sendQueueMaxMessages == 0 || queuedRequests.size() < config.sendQueueMaxMessages;
+        return closing || (bytesFit && messagesFit);
+    };
+
+    std::unique_lock<std::mutex> lock(streamMutex);
+    if (!hasRoom()) {
+        if (config.sendQueueTimeoutMillis == CloudConfig::SEND_QUEUE_WAIT_FOREVER) {
+            cvSendQueue.wait(lock, hasRoom);
+        } else if (config.sendQueueTimeoutMillis == 0 ||
+                   !cvSendQueue.wait_for(lock, std::chrono::milliseconds(config.sendQueueTimeoutMillis), hasRoom)) {
+            return CloudStatus(CLOUD_WOULD_BLOCK, "Send queue is full");
+        }
+    }
+    if (closing) {
+        // Nothing more can be written, the chunk was not sent
+        return CloudStatus(CLOUD_TRANSPORT_CLOSED, "Measurement stream is closing");
+    }
+
+    // Along with queueing it, so the poller never sees the last chunk flagged before it is queued
+    if (isLastChunk) {
+        this->isLastChunk = true;
+    }
+    if (measurementID.empty()) {
+        QueuedRequest queued;
+        queued.unstampedChunk = std::make_unique<dfx::measurements::v2::StreamRequest>(std::move(request));
+        queued.payload = std::move(payload);
+        queued.queued = std::chrono::steady_clock::now();
+        queued.bytes = bytes;
+        queuedBytes += bytes;
+        queuedRequests.push_back(std::move(queued));
+        return CloudStatus(CLOUD_OK); // Written once stamped with the measurement ID
+    }
+
+    request.mutable_chunk()->set_session_id(measurementID);
+    queueRequest(serializeChunkRequest(request.chunk(), payload));
+    if (!sendingRequest) { // Nothing was queued, write it now
+        sendingRequest = true;
+        pendingOperations++;
+        measurementsStream->Write(queuedRequests.front().request, &tags.WRITE_DONE);
+    }
+    return CloudStatus(CLOUD_OK);
+}
+
+void MeasurementStreamGRPC::stampQueuedChunks(const std::string& measurementID)
 {
     std::lock_guard lock(streamMutex);
-    if (!sendingRequest) {
+    this->measurementID = measurementID;
+
+    // Everything unstamped is behind what was already written, chunks are queued in order
+    for (auto& queued : queuedRequests) {
+        if (queued.unstampedChunk != nullptr) {
+            queued.unstampedChunk->mutable_chunk()->set_session_id(measurementID);
+            queued.request = serializeChunkRequest(queued.unstampedChunk->chunk(), queued.payload);
+            queuedBytes = queuedBytes - queued.bytes + queued.request.Length();
+            queued.bytes = queued.request.Length();
+            queued.unstampedChunk = nullptr;
+            queued.payload = ::grpc::Slice();
+        }
+    }
+
+    if (!sendingRequest && !queuedRequests.empty() && !writesDoneSent) {
         sendingRequest = true;
-        measurementsStream->Write(request, &tags.WRITE_DONE);
-    } else {
-        queuedRequests.push(request);
+        pendingOperations++;
+        measurementsStream->Write(queuedRequests.front().request, &tags.WRITE_DONE);
     }
 }
 
+void MeasurementStreamGRPC::queueRequest(::grpc::ByteBuffer&& request)
+{
+    QueuedRequest queued;
+    queued.bytes = request.Length();
+    queued.request = std::move(request);
+    queued.queued = std::chrono::steady_clock::now();
+    queuedBytes += queued.bytes;
+    queuedRequests.push_back(std::move(queued));
+}
+
+void MeasurementStreamGRPC::dequeueRequests(size_t count)
+{
+    for (; count > 0 && !queuedRequests.empty(); count--) {
+        queuedBytes -= queuedRequests.front().bytes;
+        queuedRequests.pop_front();
+    }
+    cvSendQueue.notify_all();
+}
+
 void MeasurementStreamGRPC::handleReadResponse(const dfx::measurements::v2::StreamResponse& response)
 {
     int64_t timestampMilliseconds = 0;
@@ -424,12 +639,8 @@ void MeasurementStreamGRPC::handleReadResponse(const dfx::measurements::v2::Stre
 
     // We got a response, but what type of response is it?
     if (response.has_setting()) {
-        {
-            std::unique_lock<std::mutex> lock(mutexMeasurementID);
-            measurementID = response.setting().measurement_id();
-            cvMeasurementID.notify_all(); // Wakeup the sendChunk thread if they are waiting on an ID
-        }
-        handleMeasurementID(measurementID);
+        stampQueuedChunks(response.setting().measurement_id());
+        handleMeasurementID(response.setting().measurement_id());
     } else if (response.has_chunk_result()) {
         const auto& chunkResult = response.chunk_result();
 
@@ -442,13 +653,8 @@ void MeasurementStreamGRPC::handleReadResponse(const dfx::measurements::v2::Stre
         data.chunkOrder = chunkResult.chunk_order();
 
         for (const auto& signal : chunkResult.signal_group_results()) {
-            std::string name = signal.signal_name();
-
-            std::vector<float> floatData;
-            floatData.reserve(signal.data().size());
-            std::copy(signal.data().begin(), signal.data().end(), std::back_inserter(floatData));
-
-            data.signalData.emplace(name, floatData);
+            // Already floats, copied in one go straight into the result
+            data.signalData[signal.signal_name()].assign(signal.data().begin(), signal.data().end());
         }
 
         handleResult(data);
@@ -45,7 +45,7 @@ uint64_t strToEpoch(const std::string& str)
 
 OrganizationGRPC::OrganizationGRPC(const CloudConfig& config, const std::shared_ptr<CloudGRPC>& cloudGRPC)
 {
-    grpcUserStub = dfx::users::v2::API::NewStub(cloudGRPC->getChannel(config));
+    grpcUserStub = cloudGRPC->getStub<dfx::users::v2::API>(config);
 }
 
 CloudStatus OrganizationGRPC::listUsers(const CloudConfig& config,
@@ -21,8 +21,8 @@ using namespace ::grpc;
 
 SignalGRPC::SignalGRPC(const CloudConfig& config, const std::shared_ptr<CloudGRPC>& cloudGRPC)
 {
-    grpcStudySignalsStub = dfx::studysignals::v2::API::NewStub(cloudGRPC->getChannel(config));
-    grpcSignalsStub = dfx::signals::v2::API::NewStub(cloudGRPC->getChannel(config));
+    grpcStudySignalsStub = cloudGRPC->getStub<dfx::studysignals::v2::API>(config);
+    grpcSignalsStub = cloudGRPC->getStub<dfx::signals::v2::API>(config);
 }
 
 CloudStatus SignalGRPC::list(const CloudConfig& config,
@@ -22,7 +22,7 @@ using namespace ::grpc;
 
 StudyGRPC::StudyGRPC(const CloudConfig& config, const std::shared_ptr<CloudGRPC>& cloudGRPC)
 {
-    grpcStudiesStub = dfx::studies::v1::API::NewStub(cloudGRPC->getChannel(config));
+    grpcStudiesStub = cloudGRPC->getStub<dfx::studies::v1::API>(config);
 }
 
 // NOTE: gRPC does not support the studyConfig option
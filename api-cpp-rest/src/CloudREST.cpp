@@ -17,6 +17,8 @@
 #include "dfx/api/validator/CloudValidator.hpp"
 
 #include "dfx/api/utils/HexDump.hpp"
+#include "dfx/api/utils/JsonParser.hpp"
+#include "dfx/api/utils/TLSSessionCache.hpp"
 
 #include "curl/curl.h"
 #include "fmt/args.h" // for fmt::dynamic_format_arg_store
@@ -194,6 +196,13 @@ static size_t curlCallbackFunction(void* contents, size_t size, size_t nmemb, vo
     return size * nmemb;
 }
 
+// Called once curl has set up the SSL_CTX for a connection, after its own session handling, userp is the scope
+static CURLcode curlSSLContextFunction(CURL* curl, void* sslContext, void* userp)
+{
+    dfx::api::utils::TLSSessionCache::getShared().install(sslContext, *static_cast<const std::string*>(userp));
+    return CURLE_OK;
+}
+
 CloudStatus CloudREST::performRESTCall(const CloudConfig& config,
                                        const dfx::api::web::WebServiceDetail& details,
                                        const std::string& authToken,
@@ -317,6 +326,17 @@ CloudStatus CloudREST::performRESTCall(const CloudConfig& config,
             curl_easy_setopt(curl, CURLOPT_HTTPHEADER, curlHeaders);
             curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L); // enable following HTTP 3xx redirects
 
+            // Each call has its own handle so curl's session cache would start empty every time, share ours
+            if (!config.tlsSessionCacheFile.empty()) {
+                dfx::api::utils::TLSSessionCache::getShared().setFilePath(config.tlsSessionCacheFile);
+            }
+            // curl does its own socket I/O so the cache can't see the port, it is part of the scope instead
+            auto sessionScope = dfx::api::utils::TLSSessionCache::makeScope(
+                config.skipVerify ? "rest-noverify" : "rest-verify", config.skipVerify ? "" : config.rootCA);
+            sessionScope += ":" + std::to_string(config.serverPort);
+            curl_easy_setopt(curl, CURLOPT_SSL_CTX_FUNCTION, curlSSLContextFunction);
+            curl_easy_setopt(curl, CURLOPT_SSL_CTX_DATA, &sessionScope);
+
             // Should we validate the TLS connection?
             // Informative read on verification https://curl.se/docs/sslcerts.html
             if (!config.skipVerify) {
@@ -395,7 +415,7 @@ CloudStatus CloudREST::performRESTCall(const CloudConfig& config,
 
     // If there is a CODE && Message should peel and inject
     if (res == CURLE_OK) {
-        response = nlohmann::json::parse(readBuffer, nullptr, false);
+        dfx::api::utils::parseJson(readBuffer.data(), readBuffer.size(), response);
 
         if (cloudLogIsActive(CLOUD_LOG_LEVEL_INFO)) {
             auto responseDump = response.dump();
@@ -7,15 +7,20 @@
 
 #include "dfx/api/CloudAPI.hpp"
 #include "dfx/api/CloudConfig.hpp"
+#include "dfx/api/utils/RequestSlotTable.hpp"
+#include "dfx/api/utils/TimerWheel.hpp"
 #include "dfx/api/web/WebServiceDetail.hpp"
 #include "dfx/websocket/WebSocket.hpp"
 
 #include <condition_variable>
+#include <functional>
+#include <future>
 #include <list>
 #include <map>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 
 extern "C" {
 void CloudWebSocketJsonCallback(const dfx::websocket::WebSocketEvent&, void*);
@@ -88,6 +93,54 @@ public:
 
     std::shared_ptr<UserAPI> user(const CloudConfig& config) override;
 
+    // *********************************************************************************
+    // ASYNCHRONOUS REQUESTS
+    // *********************************************************************************
+
+    /**
+     * Completion of an asynchronous request, run exactly once with the status of the response and its
+     * parsed payload.
+     *
+     * It runs on the WebSocket service thread which received the response or the close of the
+     * connection (the dispatcher's thread when the socket has an event dispatcher), or on the timeout
+     * thread of this connection when no response arrives within CloudConfig::timeoutMillis. Service
+     * threads are shared with every other connection so it should be quick, it may send further
+     * requests but must not wait on one.
+     */
+    using JsonCompletion = std::function<void(const CloudStatus& status, nlohmann::json& response)>;
+
+    /**
+     * Sends a request without waiting for its response, any number may be outstanding on the socket
+     * and each response is matched to its request by request ID. The completion is only run when
+     * CLOUD_OK is returned, otherwise the request was not sent.
+     *
+     * When throttle is set the send queue limits apply and CLOUD_WOULD_BLOCK is returned if it stays
+     * full for config.sendQueueTimeoutMillis.
+     */
+    CloudStatus sendMessageJsonAsync(const CloudConfig& config,
+                                     const dfx::api::web::WebServiceDetail& detail,
+                                     const nlohmann::json& params,
+                                     const nlohmann::json& query,
+                                     const nlohmann::json& message,
+                                     JsonCompletion completion,
+                                     bool throttle = false);
+
+    /**
+     * Sends a request without waiting for its response like the completion overload. The future
+     * becomes ready with the status of the response once it arrives, after response has been set to
+     * its payload, so response must stay valid until then. A request which could not be sent makes the
+     * future ready straight away with the failure.
+     *
+     * Must not be waited on from a completion or an event callback, the response would never arrive.
+     */
+    std::future<CloudStatus> sendMessageJsonAsync(const CloudConfig& config,
+                                                  const dfx::api::web::WebServiceDetail& detail,
+                                                  const nlohmann::json& params,
+                                                  const nlohmann::json& query,
+                                                  const nlohmann::json& message,
+                                                  nlohmann::json& response,
+                                                  bool throttle = false);
+
 private:
     friend void ::CloudWebSocketJsonCallback(const dfx::websocket::WebSocketEvent&, void*);
     friend class DeviceWebSocketJson;
@@ -99,20 +152,73 @@ private:
     friend class UserWebSocketJson;
     friend class OrganizationWebSocketJson;
 
+    struct PendingRequest
+    {
+        const dfx::api::web::WebServiceDetail* detail = nullptr; // One of the static details of web::
+        JsonCompletion completion;
+        uint16_t timeoutMillis = 0; // CloudConfig::timeoutMillis, 0 waits forever
+        dfx::api::utils::TimerWheel::Clock::time_point deadline; // Default constructed when there is none
+    };
+
+    // When throttle is set the send queue limits apply and CLOUD_WOULD_BLOCK is returned if it stays
+    // full for config.sendQueueTimeoutMillis.
     CloudStatus sendMessageJson(const CloudConfig& config,
                                 const dfx::api::web::WebServiceDetail& detail,
                                 const nlohmann::json& params,
                                 const nlohmann::json& query,
                                 const nlohmann::json& message,
-                                nlohmann::json& response);
+                                nlohmann::json& response,
+                                bool throttle = false);
+
+    // Registers the completion of a request about to be sent and gives the header it is sent with. The
+    // completion is given CLOUD_TIMEOUT if no response arrives within config.timeoutMillis (0 waits
+    // forever) of the request being written, time spent in the send queue does not count. Fails with
+    // CLOUD_WOULD_BLOCK when too many requests are already waiting on a response.
+    CloudStatus acquireRequest(const CloudConfig& config,
+                               const dfx::api::web::WebServiceDetail& detail,
+                               JsonCompletion completion,
+                               uint32_t& sequence,
+                               dfx::api::utils::RequestHeader& header);
+
+    // Drops a request acquired but not sent, false if it was already completed
+    bool releaseRequest(uint32_t sequence);
+
+    // Sends an acquired request already serialized into buffer, its header followed by the JSON, like
+    // sendMessageJsonAsync() does for the requests it builds.
+    CloudStatus sendRequestAsync(const CloudConfig& config,
+                                 const dfx::api::web::WebServiceDetail& detail,
+                                 uint32_t sequence,
+                                 std::unique_ptr<dfx::websocket::WebSocketSendBuffer> buffer,
+                                 bool throttle = false);
+
+    // Status code of a response to the request and its parsed JSON payload
+    CloudStatus parseResponse(const dfx::api::web::WebServiceDetail& detail,
+                              const std::vector<uint8_t>& responseMessage,
+                              nlohmann::json& response);
+
+    // Completes every request still waiting on a response with CLOUD_TRANSPORT_CLOSED
+    void failPendingRequests();
+
+    // Frees the slot of a request and its timer, mutex must be held
+    void releaseSlot(uint32_t sequence, PendingRequest& request);
+
+    // Starts the timeout of a request once the socket has written it, called from the service thread
+    void startRequestTimer(uint32_t sequence);
+
+    // Runs on timeoutThread, completing the requests whose deadline passes with CLOUD_TIMEOUT
+    void serviceTimeouts();
 
     void handleEvent(const dfx::websocket::WebSocketEvent& event);
     void handleMessageEvent(const dfx::websocket::WebSocketMessageEvent& messageEvent);
-    std::string getRequestID(int actionID);
 
-    void registerStream(const std::string& streamID, MeasurementStreamWebSocketJson* measurementStream);
+    // Allocates a stream ID unique among the streams on this connection and routes the responses
+    // carrying it to measurementStream until it is deregistered
+    std::string registerStream(const std::shared_ptr<MeasurementStreamWebSocketJson>& measurementStream);
     void deregisterStream(const std::string& streamID);
 
+    // The stream registered for streamID, nullptr if there is none or it has gone away
+    std::shared_ptr<MeasurementStreamWebSocketJson> findStream(const std::string& streamID);
+
 private:
     const int PAYLOAD_OFFSET = 13;
     std::string closedReason;
@@ -121,12 +227,18 @@ private:
     std::condition_variable cvWebSocketOpen;
 
     std::shared_ptr<dfx::websocket::WebSocket> webSocket;
-    std::atomic<int> lastTransactionID;
-    std::mutex mutex;
+    std::mutex mutex; // Protect - pending, timers, closed, closedReason, stopTimeouts, timeoutWakeup
     std::condition_variable cvServiceThread;
-    std::map<std::string, MeasurementStreamWebSocketJson*> streams;
-    std::map<std::string, std::shared_ptr<std::condition_variable>> pending;
-    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> responses;
+    std::thread timeoutThread;
+    bool stopTimeouts;
+    dfx::api::utils::TimerWheel timers;
+    dfx::api::utils::TimerWheel::Clock::time_point timeoutWakeup; // When timeoutThread next wakes
+
+    std::mutex streamsMutex; // Protect - streams, lastStreamID
+    std::map<std::string, std::weak_ptr<MeasurementStreamWebSocketJson>> streams;
+    int lastStreamID;
+
+    dfx::api::utils::RequestSlotTable<PendingRequest> pending;
 };
 
 } // namespace dfx::api::websocket::json
@@ -20,7 +20,8 @@ namespace dfx::api::websocket::json
 
 class CloudWebSocketJson;
 
-class MeasurementStreamWebSocketJson : public MeasurementStreamAPI
+class MeasurementStreamWebSocketJson : public MeasurementStreamAPI,
+                                       public std::enable_shared_from_this<MeasurementStreamWebSocketJson>
 {
 public:
     MeasurementStreamWebSocketJson(const CloudConfig& config,
@@ -30,6 +31,8 @@ public:
 
     CloudStatus sendChunk(const CloudConfig& config, const std::vector<uint8_t>& chunk, bool isLast) override;
 
+    CloudStatus getQueueStatus(MeasurementQueueStatus& status) override;
+
     CloudStatus reset(const CloudConfig& config) override;
 
     CloudStatus cancel(const CloudConfig& config) override;
@@ -45,6 +48,9 @@ private:
 
     void handleStreamResponse(const std::shared_ptr<std::vector<uint8_t>>& message);
 
+    // Acknowledgement of a chunk sent by sendChunk
+    void handleChunkResponse(const CloudStatus& status);
+
     CloudStatus closeStream();
 
 private:
@@ -54,7 +60,7 @@ private:
     bool writerClosedStream;
     bool lastChunkSent;
 
-    std::mutex mutexChunks;
+    std::mutex mutexChunks; // Protect - lastChunkSent, chunksOutstanding
     std::mutex mutexMeasurementID;
     std::condition_variable cvMeasurementID;
     std::string measurementID;
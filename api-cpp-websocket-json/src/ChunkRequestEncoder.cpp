@@ -0,0 +1,96 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "ChunkRequestEncoder.hpp"
+
+#include "libbase64.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+using dfx::websocket::WebSocketSendBuffer;
+
+namespace
+{
+
+constexpr char ACTION_PREFIX[] = R"({"Action":")";
+constexpr char PARAMS_PREFIX[] = R"(","Params":{"ID":)";
+constexpr char LIMIT_PREFIX[] = R"(,"Limit":)";
+constexpr char PAYLOAD_PREFIX[] = R"(},"Payload":")";
+constexpr char SUFFIX[] = R"("})";
+
+// Longest JSON escape of a byte is \u00XX, a uint16_t is at most 5 digits
+constexpr size_t MAX_ESCAPE_LENGTH = 6;
+constexpr size_t MAX_LIMIT_LENGTH = sizeof(LIMIT_PREFIX) - 1 + 5;
+
+size_t getBase64Size(size_t size)
+{
+    return (size + 2) / 3 * 4;
+}
+
+void appendLiteral(WebSocketSendBuffer& buffer, const char* literal)
+{
+    buffer.append(literal, strlen(literal));
+}
+
+bool needsEscape(const std::string& text)
+{
+    return std::any_of(text.begin(), text.end(), [](char c) {
+        return c == '"' || c == '\\' || static_cast<unsigned char>(c) < 0x20;
+    });
+}
+
+} // namespace
+
+size_t dfx::api::websocket::json::getChunkRequestSize(const dfx::api::utils::RequestHeader& header,
+                                                      const char* action,
+                                                      const std::string& measurementID,
+                                                      size_t chunkSize)
+{
+    return header.size() + sizeof(ACTION_PREFIX) - 1 + strlen(action) + sizeof(PARAMS_PREFIX) -
+           1 + 2 + measurementID.size() * MAX_ESCAPE_LENGTH + MAX_LIMIT_LENGTH + sizeof(PAYLOAD_PREFIX) - 1 +
+           getBase64Size(chunkSize) + sizeof(SUFFIX) - 1;
+}
+
+void dfx::api::websocket::json::encodeChunkRequest(WebSocketSendBuffer& buffer,
+                                                   const dfx::api::utils::RequestHeader& header,
+                                                   const char* action,
+                                                   const std::string& measurementID,
+                                                   uint16_t limit,
+                                                   const uint8_t* chunk,
+                                                   size_t chunkSize)
+{
+    buffer.append(header.data(), header.size());
+    appendLiteral(buffer, ACTION_PREFIX);
+    appendLiteral(buffer, action);
+    appendLiteral(buffer, PARAMS_PREFIX);
+
+    // Measurement IDs are plain identifiers, should one ever need escaping defer to the serializer
+    if (needsEscape(measurementID)) {
+        buffer.append(nlohmann::json(measurementID).dump());
+    } else {
+        buffer.append("\"", 1);
+        buffer.append(measurementID);
+        buffer.append("\"", 1);
+    }
+
+    if (limit > 0) {
+        appendLiteral(buffer, LIMIT_PREFIX);
+        buffer.append(std::to_string(limit));
+    }
+    appendLiteral(buffer, PAYLOAD_PREFIX);
+
+    // Base64 is encoded in place, the only time the payload is copied
+    auto offset = buffer.size();
+    buffer.resize(offset + getBase64Size(chunkSize));
+    size_t encodedLength = 0;
+    base64_encode(reinterpret_cast<const char*>(chunk),
+                  chunkSize,
+                  reinterpret_cast<char*>(buffer.data() + offset),
+                  &encodedLength,
+                  0);
+    buffer.resize(offset + encodedLength);
+
+    appendLiteral(buffer, SUFFIX);
+}
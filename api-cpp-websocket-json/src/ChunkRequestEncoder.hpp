@@ -0,0 +1,43 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_API_WEBSOCKET_JSON_CHUNK_REQUEST_ENCODER_H
+#define DFX_API_WEBSOCKET_JSON_CHUNK_REQUEST_ENCODER_H
+
+#include "dfx/api/utils/RequestSlotTable.hpp"
+#include "dfx/websocket/WebSocketBuffer.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace dfx::api::websocket::json
+{
+
+// Upper bound of the bytes encodeChunkRequest() writes, to size the send buffer up front
+size_t getChunkRequestSize(const dfx::api::utils::RequestHeader& header,
+                           const char* action,
+                           const std::string& measurementID,
+                           size_t chunkSize);
+
+/**
+ * Writes a measurement data request straight into buffer in a single pass, the request header
+ * followed by
+ *
+ *   {"Action":"<action>","Params":{"ID":"<measurementID>","Limit":<limit>},"Payload":"<base64 chunk>"}
+ *
+ * which is byte for byte what serializing the request as a nlohmann::json document produced, without
+ * the intermediate copies of the payload that took. Limit is left out when it is 0.
+ */
+void encodeChunkRequest(dfx::websocket::WebSocketSendBuffer& buffer,
+                        const dfx::api::utils::RequestHeader& header,
+                        const char* action,
+                        const std::string& measurementID,
+                        uint16_t limit,
+                        const uint8_t* chunk,
+                        size_t chunkSize);
+
+} // namespace dfx::api::websocket::json
+
+#endif // DFX_API_WEBSOCKET_JSON_CHUNK_REQUEST_ENCODER_H
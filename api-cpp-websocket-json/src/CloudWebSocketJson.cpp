@@ -5,6 +5,7 @@
 #include "dfx/api/CloudLog.hpp"
 
 #include "dfx/api/utils/HexDump.hpp"
+#include "dfx/api/utils/JsonParser.hpp"
 #include "dfx/api/validator/CloudValidator.hpp"
 #include "dfx/api/websocket/json/DeviceWebSocketJson.hpp"
 #include "dfx/api/websocket/json/LicenseWebSocketJson.hpp"
@@ -18,6 +19,7 @@
 #include "dfx/api/web/WebServiceDetail.hpp"
 
 #include "dfx/websocket/WebSocket.hpp"
+#include "dfx/websocket/WebSocketEventDispatcher.hpp"
 
 #include "fmt/format.h"
 #include "nlohmann/json.hpp"
@@ -37,6 +39,8 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
+#include <future>
 #include <thread>
 using namespace dfx::api;
 using namespace dfx::api::websocket::json;
@@ -51,7 +55,8 @@ void CloudWebSocketJsonCallback(const WebSocketEvent& event, void* userData)
 }
 
 CloudWebSocketJson::CloudWebSocketJson(const CloudConfig& config)
-    : CloudAPI(config), lastTransactionID(1), closedReason(""), closed(true)
+    : CloudAPI(config), closedReason(""), closed(true), stopTimeouts(false),
+      timeoutWakeup(dfx::api::utils::TimerWheel::Clock::time_point::max()), lastStreamID(1009)
 {
 }
 
@@ -61,6 +66,10 @@ CloudStatus CloudWebSocketJson::connect(const CloudConfig& config)
 
     closed = false;
 
+    if (!timeoutThread.joinable()) {
+        timeoutThread = std::thread(&CloudWebSocketJson::serviceTimeouts, this);
+    }
+
     if (cloudLogEnabled()) {
         auto logLevel = cloudLogLevel();
         webSocket = WebSocket::create(logLevel, [](uint8_t level, const char* message) { cloudLog(level, message); });
@@ -70,8 +79,25 @@ CloudStatus CloudWebSocketJson::connect(const CloudConfig& config)
     }
 
     webSocket->setRootCertificate(getRootCA(config));
+    if (config.dispatchEvents) {
+        webSocket->setEventDispatcher(WebSocketEventDispatcher::getShared());
+    }
     webSocket->setEventCallback(&CloudWebSocketJsonCallback, this);
 
+    // Measurement chunks are held back once the send queue is full, log as it fills and drains
+    webSocket->setSendQueueLimits(config.sendQueueMaxBytes, config.sendQueueMaxMessages);
+    webSocket->setSendQueueWaterMarks(config.sendQueueMaxBytes / 4 * 3, config.sendQueueMaxBytes / 4);
+
+    WebSocketCompression compression;
+    compression.enabled = config.compression;
+    compression.windowBits = config.compressionWindowBits;
+    webSocket->setCompression(compression);
+    webSocket->setReceiveBufferSize(config.receiveBufferSize);
+
+    if (!config.tlsSessionCacheFile.empty()) {
+        webSocket->setTLSSessionFile(config.tlsSessionCacheFile);
+    }
+
     std::string wssURL = fmt::format("wss://{}:{}", config.serverHost, config.serverPort);
     webSocket->open(wssURL, "json");
 
@@ -85,9 +111,10 @@ CloudStatus CloudWebSocketJson::connect(const CloudConfig& config)
 
     // The call to open will kick of a bunch of asynchronous activity that will eventually trigger
     // a call to handleEvent(OPEN) hopefully, or error but in any case we wait.
+    // The connection is made from the event loop thread so it may already have opened or failed.
     std::unique_lock<std::mutex> lock(mutexOpen);
-    if (!closed) {
-        cvWebSocketOpen.wait(lock);
+    cvWebSocketOpen.wait(lock, [this] { return closed || webSocket->getState() == WebSocketState::OPEN; });
+    if (webSocket->getState() == WebSocketState::OPEN) {
         return CloudStatus(CLOUD_OK);
     } else {
         return CloudStatus(CLOUD_INTERNAL_ERROR, closedReason);
@@ -96,11 +123,22 @@ CloudStatus CloudWebSocketJson::connect(const CloudConfig& config)
 
 CloudWebSocketJson::~CloudWebSocketJson()
 {
+    if (timeoutThread.joinable()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex); // Protect stopTimeouts
+            stopTimeouts = true;
+        }
+        cvServiceThread.notify_one();
+        timeoutThread.join();
+    }
+
     // The webSocket thread may notify us via a callback so we need to ensure the
     // webSocket is properly closed and its associated thread terminates prior to
     // allowing the memory associated with this instance from being released.
     if (webSocket != nullptr) {
         webSocket->close();
+        // Waits out an event the dispatcher thread is still handling and drops any behind it
+        webSocket->setEventCallback(nullptr, nullptr);
     }
 }
 
@@ -132,6 +170,14 @@ void CloudWebSocketJson::handleEvent(const WebSocketEvent& event)
                 cloudLog(CLOUD_LOG_LEVEL_TRACE, "CloudWebSocketJson::handleEvent(MESSAGE) received\n");
                 break;
             }
+            case dfx::websocket::WebSocketEventType::SEND_QUEUE_HIGH: {
+                cloudLog(CLOUD_LOG_LEVEL_TRACE, "CloudWebSocketJson::handleEvent(SEND_QUEUE_HIGH) received\n");
+                break;
+            }
+            case dfx::websocket::WebSocketEventType::SEND_QUEUE_LOW: {
+                cloudLog(CLOUD_LOG_LEVEL_TRACE, "CloudWebSocketJson::handleEvent(SEND_QUEUE_LOW) received\n");
+                break;
+            }
             case dfx::websocket::WebSocketEventType::CLOSED: {
                 cloudLog(CLOUD_LOG_LEVEL_TRACE, "CloudWebSocketJson::handleEvent(CLOSE) received\n");
                 break;
@@ -162,15 +208,7 @@ void CloudWebSocketJson::handleEvent(const WebSocketEvent& event)
                 cvWebSocketOpen.notify_all();
             }
 
-            {
-                // Wake up any client threads pending on response
-                std::unique_lock<std::mutex> lock(mutex);
-                responses.clear();
-                for (auto& condition : pending) {
-                    condition.second->notify_all();
-                }
-                pending.clear(); // Remove all now that they have been notified
-            }
+            failPendingRequests(); // Complete anything still waiting on a response
 
             break;
         }
@@ -182,18 +220,27 @@ void CloudWebSocketJson::handleEvent(const WebSocketEvent& event)
         case dfx::websocket::WebSocketEventType::LISTEN:
         case dfx::websocket::WebSocketEventType::CONNECTION:
             break;
+        case dfx::websocket::WebSocketEventType::SEND_QUEUE_HIGH: {
+            auto queue = webSocket->getSendQueueStatus();
+            cloudLog(CLOUD_LOG_LEVEL_DEBUG,
+                     "Send queue high, %zu requests %zu bytes queued\n",
+                     queue.messages,
+                     queue.bytes);
+            break;
+        }
+        case dfx::websocket::WebSocketEventType::SEND_QUEUE_LOW:
+            cloudLog(CLOUD_LOG_LEVEL_DEBUG, "Send queue drained\n");
+            break;
         case dfx::websocket::WebSocketEventType::MESSAGE:
             handleMessageEvent(event.message);
             break;
         case dfx::websocket::WebSocketEventType::CLOSED: {
-            std::unique_lock<std::mutex> lock(mutex); // Protect pending, closed
-            closedReason = "received closed";
-            closed = true;
-            responses.clear();
-            for (const auto& condition : pending) {
-                condition.second->notify_all();
+            {
+                std::unique_lock<std::mutex> lock(mutex); // Protect closed
+                closedReason = "received closed";
+                closed = true;
             }
-            pending.clear(); // Remove all now that they have been notified
+            failPendingRequests();
             break;
         }
     }
@@ -205,23 +252,36 @@ void CloudWebSocketJson::handleMessageEvent(const dfx::websocket::WebSocketMessa
         cloudLog(CLOUD_LOG_LEVEL_WARNING, "Ignoring empty data event\n");
     } else {
         auto rawData = reinterpret_cast<const char*>(messageEvent.data->data());
-        std::string requestID(rawData, 10);
-
-        std::unique_lock<std::mutex> lock(mutex); // Protect pending
-        if (requestID.rfind("STRM") != 0) {
-            // This is not a stream response so wake up client and send them the response
-            auto iter = pending.find(requestID);
-            if (iter != pending.end()) {
-                auto condition = iter->second;
-                pending.erase(iter);
+        if (messageEvent.data->size() < dfx::api::utils::REQUEST_ID_LENGTH) {
+            cloudLog(CLOUD_LOG_LEVEL_WARNING, "Ignoring message without a request ID\n");
+            return;
+        }
 
-                responses[requestID] = messageEvent.data;
+        if (strncmp(rawData, "STRM", 4) != 0) {
+            // This is not a stream response so complete the request it answers, outside of the lock as
+            // the completion may well send the next request
+            uint32_t actionID = 0;
+            uint32_t sequence = 0;
+            const dfx::api::web::WebServiceDetail* detail = nullptr;
+            JsonCompletion completion;
+            if (dfx::api::utils::parseRequestID(rawData, actionID, sequence)) {
+                std::unique_lock<std::mutex> lock(mutex); // Protect pending
+                auto* request = pending.find(sequence);
+                if (request != nullptr && static_cast<uint32_t>(request->detail->wsCode) == actionID) {
+                    detail = request->detail;
+                    completion = std::move(request->completion);
+                    releaseSlot(sequence, *request);
+                }
+            }
 
-                condition->notify_one();
+            if (completion) {
+                nlohmann::json response;
+                auto status = parseResponse(*detail, *messageEvent.data, response);
+                completion(status, response);
             } else {
                 // Something bad has happened - shutdown
                 if (cloudLogIsActive(CLOUD_LOG_LEVEL_ERROR)) {
-                    cloudLog(CLOUD_LOG_LEVEL_ERROR, "requestID %s missing, nothing to notify\n", requestID.c_str());
+                    cloudLog(CLOUD_LOG_LEVEL_ERROR, "requestID %.10s missing, nothing to notify\n", rawData);
 
                     auto hexData = dfx::api::utils::hexDump(
                         "Unhandled Message", messageEvent.data.get()->data(), messageEvent.data->size());
@@ -229,42 +289,65 @@ void CloudWebSocketJson::handleMessageEvent(const dfx::websocket::WebSocketMessa
                 }
             }
         } else {
-            auto iter = streams.find(requestID);
-            if (iter != streams.end()) {
-                iter->second->handleStreamResponse(messageEvent.data);
+            // Results for one of the measurements on this connection
+            auto measurementStream = findStream(std::string(rawData, dfx::api::utils::REQUEST_ID_LENGTH));
+            if (measurementStream != nullptr) {
+                measurementStream->handleStreamResponse(messageEvent.data);
             }
         }
     }
 }
 
-// The header comprises 4 digits for the actionID followed by a 10 digit requestID. In order
-// to track which type of request it was when we receive a response, the first four of the 10 digit
-// requestID stores the actionID leaving the remaining 6 digits to represent a monotonically
-// increasing number. When it reaches the maximum number representable by those 6 digits, it is
-// wrapped back to the start.
-std::string CloudWebSocketJson::getRequestID(int actionID)
+std::string CloudWebSocketJson::registerStream(const std::shared_ptr<MeasurementStreamWebSocketJson>& measurementStream)
 {
-    auto nextID = lastTransactionID++;
-    if (nextID > 999999) {
-        lastTransactionID = 2;
-        nextID = 1;
-    }
-    assert(actionID <= 9999);              // Developer error, no actionID > 9999.
-    actionID = (std::min)(actionID, 9999); // Explicit (std::min) to help Windows compile.
-    auto requestID = fmt::format("{:04}{:06}", actionID, nextID);
-    return requestID;
-}
+    std::unique_lock<std::mutex> lock(streamsMutex); // Protect - streams, lastStreamID
+
+    // STRM is nothing special but nice to look at when debugging, API just wants a 10 byte transaction ID.
+    // The number wraps like request IDs do, skipping any still in use by a long running stream.
+    std::string streamID;
+    do {
+        lastStreamID = lastStreamID >= 999999 ? 1 : lastStreamID + 1;
+        streamID = fmt::format("STRM{:06}", lastStreamID);
+    } while (streams.count(streamID) != 0);
 
-void CloudWebSocketJson::registerStream(const std::string& streamID, MeasurementStreamWebSocketJson* measurementStream)
-{
     streams[streamID] = measurementStream;
+    return streamID;
 }
 
 void CloudWebSocketJson::deregisterStream(const std::string& streamID)
 {
+    std::unique_lock<std::mutex> lock(streamsMutex); // Protect - streams
+    streams.erase(streamID);
+}
+
+std::shared_ptr<MeasurementStreamWebSocketJson> CloudWebSocketJson::findStream(const std::string& streamID)
+{
+    std::unique_lock<std::mutex> lock(streamsMutex); // Protect - streams
     auto iter = streams.find(streamID);
-    if (iter != streams.end()) {
-        streams.erase(iter);
+    if (iter == streams.end()) {
+        return nullptr;
+    }
+    return iter->second.lock();
+}
+
+void CloudWebSocketJson::failPendingRequests()
+{
+    std::vector<JsonCompletion> failed;
+    std::string reason;
+    {
+        std::unique_lock<std::mutex> lock(mutex); // Protect pending, closedReason
+        failed.reserve(pending.size());
+        pending.forEach([this, &failed](uint32_t sequence, PendingRequest& request) {
+            failed.push_back(std::move(request.completion));
+            pending.release(sequence);
+        });
+        timers.clear();
+        reason = closedReason;
+    }
+
+    for (auto& completion : failed) {
+        nlohmann::json response;
+        completion(CloudStatus(CLOUD_TRANSPORT_CLOSED, reason), response);
     }
 }
 
@@ -273,7 +356,35 @@ CloudStatus CloudWebSocketJson::sendMessageJson(const CloudConfig& config,
                                                 const nlohmann::json& params,
                                                 const nlohmann::json& query,
                                                 const nlohmann::json& message,
-                                                nlohmann::json& response)
+                                                nlohmann::json& response,
+                                                bool throttle)
+{
+    std::promise<CloudStatus> promise;
+    auto future = promise.get_future();
+    auto status = sendMessageJsonAsync(
+        config,
+        detail,
+        params,
+        query,
+        message,
+        [&promise, &response](const CloudStatus& result, nlohmann::json& resultResponse) {
+            response = std::move(resultResponse);
+            promise.set_value(result);
+        },
+        throttle);
+    if (!status.OK()) {
+        return status;
+    }
+    return future.get();
+}
+
+CloudStatus CloudWebSocketJson::sendMessageJsonAsync(const CloudConfig& config,
+                                                     const dfx::api::web::WebServiceDetail& detail,
+                                                     const nlohmann::json& params,
+                                                     const nlohmann::json& query,
+                                                     const nlohmann::json& message,
+                                                     JsonCompletion completion,
+                                                     bool throttle)
 {
     nlohmann::json request = message;
     nlohmann::json requestParams = params;
@@ -296,126 +407,280 @@ CloudStatus CloudWebSocketJson::sendMessageJson(const CloudConfig& config,
         requestString = "{}";
     }
 
-    auto actionID = fmt::format("{:04}", detail.wsCode);
-    auto requestID = getRequestID(detail.wsCode);
+    uint32_t sequence;
+    dfx::api::utils::RequestHeader header;
+    auto status = acquireRequest(config, detail, std::move(completion), sequence, header);
+    if (!status.OK()) {
+        return status;
+    }
 
-    auto strRequest = actionID + requestID + requestString;
+    // Assemble the message directly in a buffer leased from the socket which is sent without a further copy
+    auto buffer = webSocket->acquireSendBuffer(header.size() + requestString.size());
+    buffer->append(header.data(), header.size());
+    buffer->append(requestString);
 
-    auto condition = std::make_shared<std::condition_variable>();
-    {
-        std::unique_lock<std::mutex> lock(mutex);
-        if (webSocket->getState() != WebSocketState::OPEN) {
-            return CloudStatus(CLOUD_TRANSPORT_CLOSED, closedReason);
+    return sendRequestAsync(config, detail, sequence, std::move(buffer), throttle);
+}
+
+std::future<CloudStatus> CloudWebSocketJson::sendMessageJsonAsync(const CloudConfig& config,
+                                                                  const dfx::api::web::WebServiceDetail& detail,
+                                                                  const nlohmann::json& params,
+                                                                  const nlohmann::json& query,
+                                                                  const nlohmann::json& message,
+                                                                  nlohmann::json& response,
+                                                                  bool throttle)
+{
+    // Shared with the completion which may outlive this call
+    auto promise = std::make_shared<std::promise<CloudStatus>>();
+    auto future = promise->get_future();
+    auto status = sendMessageJsonAsync(
+        config,
+        detail,
+        params,
+        query,
+        message,
+        [promise, &response](const CloudStatus& result, nlohmann::json& resultResponse) {
+            response = std::move(resultResponse);
+            promise->set_value(result);
+        },
+        throttle);
+    if (!status.OK()) {
+        promise->set_value(status);
+    }
+    return future;
+}
+
+CloudStatus CloudWebSocketJson::acquireRequest(const CloudConfig& config,
+                                               const dfx::api::web::WebServiceDetail& detail,
+                                               JsonCompletion completion,
+                                               uint32_t& sequence,
+                                               dfx::api::utils::RequestHeader& header)
+{
+    // Registered before sending so a response can never arrive ahead of its request
+    std::unique_lock<std::mutex> lock(mutex); // Protect pending, closed
+    if (closed || webSocket->getState() != WebSocketState::OPEN) {
+        return CloudStatus(CLOUD_TRANSPORT_CLOSED, closedReason);
+    }
+
+    sequence = pending.acquire();
+    if (sequence == 0) {
+        return CloudStatus(CLOUD_WOULD_BLOCK, "Too many requests waiting on a response");
+    }
+    auto* request = pending.find(sequence);
+    request->detail = &detail;
+    request->completion = std::move(completion);
+    request->timeoutMillis = config.timeoutMillis;
+    request->deadline = {}; // Scheduled once written, a slow uplink can hold it in the send queue for a while
+
+    assert(detail.wsCode <= 9999); // Developer error, no actionID > 9999.
+    header = dfx::api::utils::formatRequestHeader(static_cast<uint32_t>((std::min)(detail.wsCode, 9999)), sequence);
+    return CloudStatus(CLOUD_OK);
+}
+
+bool CloudWebSocketJson::releaseRequest(uint32_t sequence)
+{
+    std::unique_lock<std::mutex> lock(mutex); // Protect pending
+    auto* request = pending.find(sequence);
+    if (request == nullptr) {
+        return false;
+    }
+    request->completion = nullptr; // Let go of whatever it captured
+    releaseSlot(sequence, *request);
+    return true;
+}
+
+void CloudWebSocketJson::releaseSlot(uint32_t sequence, PendingRequest& request)
+{
+    if (request.deadline != dfx::api::utils::TimerWheel::Clock::time_point()) {
+        timers.cancel(sequence, request.deadline);
+    }
+    pending.release(sequence);
+}
+
+void CloudWebSocketJson::startRequestTimer(uint32_t sequence)
+{
+    std::unique_lock<std::mutex> lock(mutex); // Protect pending, timers, timeoutWakeup
+    auto* request = pending.find(sequence);
+    if (request == nullptr || request->timeoutMillis == 0) {
+        return; // Already answered or closed, or waits forever
+    }
+    request->deadline =
+        dfx::api::utils::TimerWheel::Clock::now() + std::chrono::milliseconds(request->timeoutMillis);
+    timers.schedule(sequence, request->deadline);
+    if (request->deadline < timeoutWakeup) {
+        cvServiceThread.notify_one(); // Sooner than the timeout thread is waiting for
+    }
+}
+
+void CloudWebSocketJson::serviceTimeouts()
+{
+    std::vector<uint32_t> expired;
+    std::vector<JsonCompletion> timedOut;
+
+    std::unique_lock<std::mutex> lock(mutex); // Protect pending, timers, stopTimeouts, timeoutWakeup
+    while (!stopTimeouts) {
+        timeoutWakeup = timers.nextExpiry();
+        if (timeoutWakeup == dfx::api::utils::TimerWheel::Clock::time_point::max()) {
+            cvServiceThread.wait(lock);
+        } else {
+            cvServiceThread.wait_until(lock, timeoutWakeup);
+        }
+
+        expired.clear();
+        timers.expire(dfx::api::utils::TimerWheel::Clock::now(), expired);
+        for (auto sequence : expired) {
+            auto* request = pending.find(sequence);
+            if (request != nullptr) {
+                timedOut.push_back(std::move(request->completion));
+                pending.release(sequence); // Its timer has just expired, a late response finds no request
+            }
         }
-        pending[requestID] = condition;
 
+        if (!timedOut.empty()) {
+            // Completed outside of the lock as a completion may well send the next request
+            lock.unlock();
+            cloudLog(CLOUD_LOG_LEVEL_WARNING, "%zu requests timed out waiting on a response\n", timedOut.size());
+            for (auto& completion : timedOut) {
+                nlohmann::json response;
+                completion(CloudStatus(CLOUD_TIMEOUT, "No response to the request"), response);
+            }
+            timedOut.clear();
+            lock.lock();
+        }
+    }
+}
+
+CloudStatus CloudWebSocketJson::sendRequestAsync(const CloudConfig& config,
+                                                 const dfx::api::web::WebServiceDetail& detail,
+                                                 uint32_t sequence,
+                                                 std::unique_ptr<dfx::websocket::WebSocketSendBuffer> buffer,
+                                                 bool throttle)
+{
 #ifndef NDEBUG
-        if (cloudLogIsActive(CLOUD_LOG_LEVEL_DEBUG)) {
-            cloudLog(CLOUD_LOG_LEVEL_DEBUG,
-                     "Request [%d,%s,%s]\n",
-                     detail.wsCode,
-                     detail.httpOption.c_str(),
-                     detail.urlPath.c_str());
-            if (cloudLogIsActive(CLOUD_LOG_LEVEL_TRACE)) {
-                auto hexBytes = dfx::api::utils::hexDump("Request bytes:\n", strRequest.c_str(), strRequest.size());
-                cloudLog(CLOUD_LOG_LEVEL_TRACE, "%s", hexBytes.c_str());
-
-                // Convert the message data to a string and parse it as JSON to dump it
-                if (strRequest.size() >= 15) {
-                    std::string identifier = strRequest.substr(0, 14);
-                    std::string jsonPayload = strRequest.substr(14, strRequest.size() - 14);
-                    nlohmann::json jsonData = nlohmann::json::parse(jsonPayload, nullptr, false);
-                    std::string jsonString = jsonData.dump(4);
-                    cloudLog(CLOUD_LOG_LEVEL_TRACE, "Request JSON:\n%s\n%s\n", identifier.c_str(), jsonString.c_str());
-                }
+    if (cloudLogIsActive(CLOUD_LOG_LEVEL_DEBUG)) {
+        cloudLog(CLOUD_LOG_LEVEL_DEBUG,
+                 "Request [%d,%s,%s]\n",
+                 detail.wsCode,
+                 detail.httpOption.c_str(),
+                 detail.urlPath.c_str());
+        if (cloudLogIsActive(CLOUD_LOG_LEVEL_TRACE)) {
+            auto hexBytes = dfx::api::utils::hexDump("Request bytes:\n", buffer->data(), buffer->size());
+            cloudLog(CLOUD_LOG_LEVEL_TRACE, "%s", hexBytes.c_str());
+
+            // Convert the message data to a string and parse it as JSON to dump it
+            if (buffer->size() >= 15) {
+                std::string identifier(buffer->data(), buffer->data() + 14);
+                nlohmann::json jsonData =
+                    nlohmann::json::parse(buffer->data() + 14, buffer->data() + buffer->size(), nullptr, false);
+                std::string jsonString = jsonData.dump(4);
+                cloudLog(CLOUD_LOG_LEVEL_TRACE, "Request JSON:\n%s\n%s\n", identifier.c_str(), jsonString.c_str());
             }
         }
+    }
 #endif
 
-        // Need to check we are not terminated before the send and wait
-        webSocket->sendUTF8(strRequest);
+    buffer->setWrittenCallback([this, sequence]() { startRequestTimer(sequence); });
 
-        condition->wait(lock);
-        if (closed) {
+    // Queue outside of mutex, waiting for room in the send queue must not hold up responses
+    if (throttle) {
+        auto sendStatus = webSocket->trySend(buffer, config.sendQueueTimeoutMillis);
+        if (sendStatus != dfx::websocket::Status::OK) {
+            if (!releaseRequest(sequence)) {
+                return CloudStatus(CLOUD_OK); // Closed meanwhile, the completion has been run
+            }
+            if (sendStatus == dfx::websocket::Status::WOULD_BLOCK) {
+                return CloudStatus(CLOUD_WOULD_BLOCK, "Send queue is full");
+            }
+            std::unique_lock<std::mutex> lock(mutex); // Protect closedReason
             return CloudStatus(CLOUD_TRANSPORT_CLOSED, closedReason);
         }
+    } else {
+        webSocket->send(std::move(buffer));
     }
 
-    auto iter = responses.find(requestID);
-    if (iter == responses.end()) {
-        // Unable to find a response for the requestID, should not happen
-        return CloudStatus(CLOUD_INTERNAL_ERROR);
-    } else {
-        auto message = iter->second;
-        responses.erase(iter);
+    return CloudStatus(CLOUD_OK);
+}
 
-        if (message->size() < PAYLOAD_OFFSET) {
-            return CloudStatus(CLOUD_INTERNAL_ERROR,
-                               "Response message was too small: " + std::to_string(message->size()));
-        }
+CloudStatus CloudWebSocketJson::parseResponse(const dfx::api::web::WebServiceDetail& detail,
+                                              const std::vector<uint8_t>& responseMessage,
+                                              nlohmann::json& response)
+{
+    if (responseMessage.size() < PAYLOAD_OFFSET) {
+        return CloudStatus(CLOUD_INTERNAL_ERROR,
+                           "Response message was too small: " + std::to_string(responseMessage.size()));
+    }
 
-        auto rawData = reinterpret_cast<const char*>(message->data());
+    auto rawData = reinterpret_cast<const char*>(responseMessage.data());
 
-        std::string statusCode(rawData + 10, 3);
+    std::string statusCode(rawData + 10, 3);
 
-        auto rawSize = message->size();
-        assert(rawSize < INT_MAX); // Explicit cast - something wrong if this big
-        int messageSize = static_cast<int>(rawSize);
+    auto rawSize = responseMessage.size();
+    assert(rawSize < INT_MAX); // Explicit cast - something wrong if this big
+    int messageSize = static_cast<int>(rawSize);
 
 #ifndef NDEBUG
-        if (cloudLogIsActive(CLOUD_LOG_LEVEL_DEBUG)) {
-            cloudLog(CLOUD_LOG_LEVEL_DEBUG,
-                     "Response [%d,%s,%s]\n",
-                     detail.wsCode,
-                     detail.httpOption.c_str(),
-                     detail.urlPath.c_str());
-            if (cloudLogIsActive(CLOUD_LOG_LEVEL_TRACE)) {
-                auto hexBytes = dfx::api::utils::hexDump("Response bytes:\n", message->data(), message->size());
-                cloudLog(CLOUD_LOG_LEVEL_TRACE, "%s", hexBytes.c_str());
-
-                // Convert the message data to a string and parse it as JSON to dump it
-                if (message->size() >= 15) {
-                    auto data = reinterpret_cast<char*>(message->data());
-                    std::string messageString(data, message->size());
-                    std::string identifier = messageString.substr(0, 13);
-                    std::string jsonPayload = messageString.substr(13, message->size() - 13);
-                    nlohmann::json jsonData = nlohmann::json::parse(jsonPayload, nullptr, false);
-                    std::string jsonString = jsonData.dump(4);
-                    cloudLog(CLOUD_LOG_LEVEL_TRACE, "Response JSON:\n%s\n%s\n", identifier.c_str(), jsonString.c_str());
-                }
+    if (cloudLogIsActive(CLOUD_LOG_LEVEL_DEBUG)) {
+        cloudLog(CLOUD_LOG_LEVEL_DEBUG,
+                 "Response [%d,%s,%s]\n",
+                 detail.wsCode,
+                 detail.httpOption.c_str(),
+                 detail.urlPath.c_str());
+        if (cloudLogIsActive(CLOUD_LOG_LEVEL_TRACE)) {
+            auto hexBytes =
+                dfx::api::utils::hexDump("Response bytes:\n", responseMessage.data(), responseMessage.size());
+            cloudLog(CLOUD_LOG_LEVEL_TRACE, "%s", hexBytes.c_str());
+
+            // Convert the message data to a string and parse it as JSON to dump it
+            if (responseMessage.size() >= 15) {
+                std::string messageString(rawData, responseMessage.size());
+                std::string identifier = messageString.substr(0, 13);
+                std::string jsonPayload = messageString.substr(13, responseMessage.size() - 13);
+                nlohmann::json jsonData = nlohmann::json::parse(jsonPayload, nullptr, false);
+                std::string jsonString = jsonData.dump(4);
+                cloudLog(CLOUD_LOG_LEVEL_TRACE, "Response JSON:\n%s\n%s\n", identifier.c_str(), jsonString.c_str());
             }
         }
+    }
 #endif
 
-        std::string responseData(rawData + PAYLOAD_OFFSET, messageSize - PAYLOAD_OFFSET);
-        response = nlohmann::json::parse(responseData, nullptr, false);
+    dfx::api::utils::parseJson(rawData + PAYLOAD_OFFSET, messageSize - PAYLOAD_OFFSET, response);
 
-        // Request is considered OK
-        if (statusCode == "200") {
-            if (!response.is_discarded()) {
-                return CloudStatus(CLOUD_OK);
-            }
+    // Request is considered OK
+    if (statusCode == "200") {
+        if (!response.is_discarded()) {
+            return CloudStatus(CLOUD_OK);
         }
+    }
 
-        if (statusCode == "400") {
-            auto errorCode = response["Code"].get<std::string>();
-            auto errorMessage = response["Message"].get<std::string>();
-            if (errorCode == "INCORRECT_REQUEST" && errorMessage.substr(0, 20) == "Invalid Route Number") {
-                // Cloud is reporting it an unsupported feature
-                return CloudStatus(CLOUD_UNSUPPORTED_FEATURE, errorMessage);
+    if (statusCode == "400") {
+        // Runs on the socket's thread where an exception would end the process, so a body which is not
+        // JSON or lacks the string fields is read as empty rather than with get<>()
+        auto readString = [&response](const char* key) {
+            if (response.is_object()) {
+                auto field = response.find(key);
+                if (field != response.end() && field->is_string()) {
+                    return field->get<std::string>();
+                }
             }
-            return CloudStatus(CLOUD_PARAMETER_VALIDATION_ERROR);
-        } else if (statusCode == "403") {
-            return CloudStatus(CLOUD_USER_NOT_AUTHORIZED);
-        } else if (statusCode == "404") {
-            return CloudStatus(CLOUD_RECORD_NOT_FOUND);
-        } else if (statusCode == "409") {
-            return CloudStatus(CLOUD_RECORD_ALREADY_EXISTS);
-        } else if (statusCode == "500") {
-            return CloudStatus(CLOUD_INTERNAL_ERROR);
+            return std::string();
+        };
+        auto errorCode = readString("Code");
+        auto errorMessage = readString("Message");
+        if (errorCode == "INCORRECT_REQUEST" && errorMessage.substr(0, 20) == "Invalid Route Number") {
+            // Cloud is reporting it an unsupported feature
+            return CloudStatus(CLOUD_UNSUPPORTED_FEATURE, errorMessage);
         }
+        return CloudStatus(CLOUD_PARAMETER_VALIDATION_ERROR);
+    } else if (statusCode == "403") {
+        return CloudStatus(CLOUD_USER_NOT_AUTHORIZED);
+    } else if (statusCode == "404") {
+        return CloudStatus(CLOUD_RECORD_NOT_FOUND);
+    } else if (statusCode == "409") {
+        return CloudStatus(CLOUD_RECORD_ALREADY_EXISTS);
+    } else if (statusCode == "500") {
         return CloudStatus(CLOUD_INTERNAL_ERROR);
     }
+    return CloudStatus(CLOUD_INTERNAL_ERROR);
 }
 
 CloudStatus CloudWebSocketJson::login(CloudConfig& config)
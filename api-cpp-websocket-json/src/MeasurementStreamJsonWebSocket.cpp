@@ -2,12 +2,15 @@
 // See LICENSE.txt in the project root for license information.
 
 #include "dfx/api/CloudLog.hpp"
+#include "dfx/api/utils/Dequantize.hpp"
+#include "dfx/api/utils/JsonParser.hpp"
 #include "dfx/api/validator/CloudValidator.hpp"
 #include "dfx/api/websocket/json/CloudWebSocketJson.hpp"
 #include "dfx/api/websocket/json/MeasurementStreamWebSocketJson.hpp"
 
+#include "ChunkRequestEncoder.hpp"
+
 #include "fmt/format.h"
-#include "libbase64.h"
 #include <chrono>
 #include <thread>
 
@@ -31,6 +34,9 @@ MeasurementStreamWebSocketJson::MeasurementStreamWebSocketJson(
 MeasurementStreamWebSocketJson::~MeasurementStreamWebSocketJson()
 {
     closeStream();
+    if (!requestID.empty()) {
+        cloudWebSocketJson->deregisterStream(requestID);
+    }
 }
 
 void MeasurementStreamWebSocketJson::initialize()
@@ -111,9 +117,11 @@ CloudStatus MeasurementStreamWebSocketJson::setupStream(const CloudConfig& confi
     }
 
     {
-        // STRM is nothing special but nice to look at when debugging, API just wants
-        // a random 10 byte transaction ID
-        requestID = fmt::format("STRM{:06}", 1010);
+        // Each measurement on the connection gets its own stream ID so their results are kept apart
+        if (!requestID.empty()) {
+            cloudWebSocketJson->deregisterStream(requestID); // Left over from before a reset
+        }
+        requestID = cloudWebSocketJson->registerStream(shared_from_this());
 
         nlohmann::json request;
         request["RequestID"] = requestID;
@@ -123,7 +131,6 @@ CloudStatus MeasurementStreamWebSocketJson::setupStream(const CloudConfig& confi
         nlohmann::json params;
         params["ID"] = measurementID;
 
-        cloudWebSocketJson->registerStream(requestID, this);
 
         // https://dfxapiversion10.docs.apiary.io/#reference/0/measurements/subscribe-to-results
         auto result = cloudWebSocketJson->sendMessageJson(
@@ -159,39 +166,62 @@ CloudStatus MeasurementStreamWebSocketJson::sendChunk(const CloudConfig& config,
         return result; // if it has already been closed.
     }
 
-    nlohmann::json request;
-
+    const char* action;
     if (!isLastChunk) {
         if (isFirstChunk) {
-            request["Action"] = "FIRST::PROCESS";
-            isFirstChunk = false;
+            action = "FIRST::PROCESS";
         } else {
-            request["Action"] = "CHUNK::PROCESS";
+            action = "CHUNK::PROCESS";
         }
     } else {
-        request["Action"] = "LAST::PROCESS";
-        lastChunkSent = true;
+        action = "LAST::PROCESS";
     }
 
-    // Base64 encode the chunk
-    const char* unencodedData = reinterpret_cast<const char*>(chunk.data());
-    size_t unencodedLength = chunk.size();
-    std::vector<char> chunkBase64;
-    chunkBase64.resize(chunk.size()*2);
-    size_t encoded_length = 0;
-    int flags = 0;
-    base64_encode(unencodedData, unencodedLength, chunkBase64.data(), &encoded_length, flags );
-    chunkBase64.resize(encoded_length);
-    const std::string payload(chunkBase64.begin(), chunkBase64.end());
-    request["Payload"] = payload;
-
-    nlohmann::json response;
-
-    nlohmann::json params;
-    params["ID"] = measurementID;
-
     // https://dfxapiversion10.docs.apiary.io/#reference/0/measurements/add-data
-    result = cloudWebSocketJson->sendMessageJson(config, web::Measurements::Data, params, {}, request, response);
+    // The response only acknowledges the chunk, results arrive on the stream. Rather than a round trip
+    // per chunk they are pipelined and each acknowledgement is checked as it arrives.
+    const auto& detail = web::Measurements::Data;
+    std::weak_ptr<MeasurementStreamWebSocketJson> weakThis = weak_from_this();
+    uint32_t sequence;
+    dfx::api::utils::RequestHeader header;
+    result = cloudWebSocketJson->acquireRequest(
+        config,
+        detail,
+        [weakThis](const CloudStatus& status, nlohmann::json& response) {
+            if (auto self = weakThis.lock()) {
+                self->handleChunkResponse(status);
+            }
+        },
+        sequence,
+        header);
+
+    if (result.OK()) {
+        // The chunk is base64 encoded straight into the message with the rest of the request written
+        // around it, rather than built up as a JSON document which copies the payload several times.
+        auto buffer = cloudWebSocketJson->webSocket->acquireSendBuffer(
+            getChunkRequestSize(header, action, measurementID, chunk.size()));
+        encodeChunkRequest(*buffer, header, action, measurementID, config.listLimit, chunk.data(), chunk.size());
+
+        // Counted before it is sent, its result may be handled before sendRequestAsync() returns
+        bool wasLastChunkSent;
+        {
+            const std::lock_guard<std::mutex> lock(mutexChunks);
+            wasLastChunkSent = lastChunkSent;
+            lastChunkSent = lastChunkSent || isLastChunk;
+            chunksOutstanding++;
+        }
+
+        const bool throttle = true;
+        result = cloudWebSocketJson->sendRequestAsync(config, detail, sequence, std::move(buffer), throttle);
+        if (!result.OK()) {
+            const std::lock_guard<std::mutex> lock(mutexChunks);
+            lastChunkSent = wasLastChunkSent;
+            chunksOutstanding--;
+        }
+    }
+    if (result.code == CLOUD_WOULD_BLOCK) {
+        return result; // Nothing was sent, the caller can retry the chunk once the queue drains
+    }
 
     if (!result.OK()) {
         cloudLog(CLOUD_LOG_LEVEL_WARNING, "WEB: Send not okay %d: %s", result.code, result.message.c_str());
@@ -201,14 +231,17 @@ CloudStatus MeasurementStreamWebSocketJson::sendChunk(const CloudConfig& config,
         return result;
     }
 
-    {
-        const std::lock_guard<std::mutex> lock(mutexChunks);
-        if (isLastChunk) {
-            lastChunkSent = true;
-        }
-        chunksOutstanding++;
-    }
+    isFirstChunk = false;
+
+    return CloudStatus(CLOUD_OK);
+}
 
+CloudStatus MeasurementStreamWebSocketJson::getQueueStatus(MeasurementQueueStatus& status)
+{
+    auto queue = cloudWebSocketJson->webSocket->getSendQueueStatus();
+    status.queuedMessages = queue.messages;
+    status.queuedBytes = queue.bytes;
+    status.oldestQueuedMillis = queue.oldestMillis;
     return CloudStatus(CLOUD_OK);
 }
 
@@ -233,6 +266,16 @@ CloudStatus MeasurementStreamWebSocketJson::cancel(const CloudConfig& config)
     return status;
 }
 
+void MeasurementStreamWebSocketJson::handleChunkResponse(const CloudStatus& status)
+{
+    if (!status.OK()) {
+        cloudLog(CLOUD_LOG_LEVEL_WARNING, "WEB: Chunk not accepted %d: %s", status.code, status.message.c_str());
+
+        // Results for it will never arrive, report why the measurement ended
+        closeMeasurement(status);
+    }
+}
+
 void MeasurementStreamWebSocketJson::handleStreamResponse(const std::shared_ptr<std::vector<uint8_t>>& message)
 {
     // This is a stream response, need to decode enough of it to decide what type
@@ -246,13 +289,11 @@ void MeasurementStreamWebSocketJson::handleStreamResponse(const std::shared_ptr<
 
     std::string statusCode(rawData + 10, 3);
 
-    auto responseString = std::string(rawData + 13, messageSize - 13);
-
-    bool allow_exceptions = false;
-    nlohmann::json response = nlohmann::json::parse(responseString, nullptr, allow_exceptions);
-
     // Request is considered OK
     if (statusCode != "200") {
+        nlohmann::json response;
+        dfx::api::utils::parseJson(rawData + 13, messageSize - 13, response);
+
         auto result = CloudStatus(CLOUD_INTERNAL_ERROR);
         if (!response.is_discarded() && response.contains("Code")) {
             std::string code = response["Code"];
@@ -266,14 +307,17 @@ void MeasurementStreamWebSocketJson::handleStreamResponse(const std::shared_ptr<
         }
         closeMeasurement(result);
     } else {
-        if (response.is_discarded()) {
+        // Only the fields used are read from a result rather than building a document of the whole message,
+        // the spare capacity of the receive buffer lets the parser read it in place.
+        dfx::api::utils::JsonStreamResult response;
+        if (!dfx::api::utils::parseStreamResult(
+                rawData + 13, messageSize - 13, message->capacity() - 13, response)) {
             cloudLog(CLOUD_LOG_LEVEL_WARNING, "WEB: Response decode failed");
             closeMeasurement(CloudStatus(CLOUD_INTERNAL_ERROR, "WEB: Response decode failed"));
         } else {
-            if (response.contains("Error")) {
-                const auto& error = response["Error"];
-                const auto& errorCode = error["Code"].get<std::string>();
-                if (errorCode != "OK") {
+            if (!response.errorJson.empty()) {
+                auto error = nlohmann::json::parse(response.errorJson, nullptr, false);
+                if (error.is_object() && error.value("Code", "") != "OK" && error.contains("Errors")) {
                     for (const auto& error : error["Errors"].items()) {
                         MeasurementWarning warning{};
                         warning.warningCode = -1;               // Code & message, both strings :(
@@ -286,21 +330,20 @@ void MeasurementStreamWebSocketJson::handleStreamResponse(const std::shared_ptr<
                 }
             }
 
-            if (response.contains("ID")) {
+            if (!response.id.empty()) {
                 if (measurementID.empty()) { // Only send client measurement ID once per measurement
-                    auto id = response["ID"].get<std::string>();
-                    handleMeasurementID(id);
-                    measurementID = id;
+                    handleMeasurementID(response.id);
+                    measurementID = response.id;
                 }
             }
 
-            auto multiplier = 1;
-            if (response.contains("Multiplier")) {
-                multiplier = response["Multiplier"].get<int>();
+            auto multiplier = static_cast<float>(response.multiplier);
+            if (multiplier == 0) {
+                multiplier = 1; // Extra cautious to avoid divide by zero below
             }
 
             int chunkNumber(0);
-            auto measurementDataID = response["MeasurementDataID"].get<std::string>();
+            auto& measurementDataID = response.measurementDataID;
             if (measurementDataID.length() > measurementID.length() + 1) { // Expect measurementID:#
                 measurementDataID = measurementDataID.substr(measurementID.length() + 1);
                 chunkNumber = std::stoi(measurementDataID);
@@ -312,21 +355,12 @@ void MeasurementStreamWebSocketJson::handleStreamResponse(const std::shared_ptr<
             result.timestampMS = 0; // Nothing available
             result.frameEndTimestampMS = 0;
 
-            for (const auto& entry : response["Channels"].items()) {
-                std::string signalName = entry.key();
-                const auto& signalValue = entry.value();
-                std::string channelName = signalValue["Channel"].get<std::string>();
-
-                std::vector<float> data;
-                auto measurementData = signalValue["Data"].get<std::vector<int>>();
-                data.reserve(measurementData.size());
-                for (const auto& value : measurementData) {
-                    // Data in measurementData is type float, the v2 interface was
-                    // designed to hand back doubles.
-                    data.push_back(static_cast<float>(value) / multiplier);
-                }
-
-                result.signalData[signalName] = data;
+            for (const auto& channel : response.channels) {
+                // Data in the channel is quantized, the v2 interface was designed to hand back floats
+                const auto& measurementData = channel.second;
+                auto& data = result.signalData[channel.first];
+                data.resize(measurementData.size());
+                dfx::api::utils::dequantize(measurementData.data(), measurementData.size(), multiplier, data.data());
             }
 
             if (result.signalData.size() > 0) {
@@ -7,6 +7,8 @@
 
 #include "dfx/api/CloudAPI.hpp"
 #include "dfx/api/CloudConfig.hpp"
+#include "dfx/api/utils/RequestSlotTable.hpp"
+#include "dfx/api/utils/TimerWheel.hpp"
 #include "dfx/api/web/WebServiceDetail.hpp"
 #include "dfx/websocket/WebSocket.hpp"
 
@@ -17,6 +19,7 @@
 #include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 
 extern "C" {
 void CloudWebSocketProtobufCallback(const dfx::websocket::WebSocketEvent&, void*);
@@ -103,15 +106,40 @@ private:
     CloudStatus sendMessage(const dfx::api::web::WebServiceDetail& detail,
                             ::google::protobuf::Message& message,
                             ::google::protobuf::Message& response);
+
+    // Sends message followed by a bytes field serialized straight from payload, so a large payload
+    // is copied once into the outgoing buffer instead of into the message first. When sendQueueConfig
+    // is provided the send queue limits apply and CLOUD_WOULD_BLOCK is returned if it stays full.
+    CloudStatus sendMessage(const dfx::api::web::WebServiceDetail& detail,
+                            const ::google::protobuf::Message& message,
+                            int payloadFieldNumber,
+                            const uint8_t* payload,
+                            size_t payloadSize,
+                            ::google::protobuf::Message& response,
+                            const CloudConfig* sendQueueConfig = nullptr);
     void handleEvent(const dfx::websocket::WebSocketEvent& event);
     void handleMessageEvent(const dfx::websocket::WebSocketMessageEvent& messageEvent);
-    std::string getRequestID(int actionID);
+
+    // Wakes every thread waiting on a response so it can see the connection closed, mutex must be held
+    void wakePendingRequests();
+
+    // Runs on timeoutThread, waking the threads whose request passes its deadline without a response
+    void serviceTimeouts();
+
+    // Starts the timeout of a request once the socket has written it, called from the service thread.
+    // Time spent in the send queue does not count toward requestTimeoutMillis.
+    void startRequestTimer(uint32_t sequence);
 
     CloudStatus decodeWebSocketError(const std::string& statusCode, const std::vector<uint8_t>& data);
 
-    void registerStream(const std::string& streamID, MeasurementStreamWebSocketProtobuf* measurementStream);
+    // Allocates a stream ID unique among the streams on this connection and routes the responses
+    // carrying it to measurementStream until it is deregistered
+    std::string registerStream(const std::shared_ptr<MeasurementStreamWebSocketProtobuf>& measurementStream);
     void deregisterStream(const std::string& streamID);
 
+    // The stream registered for streamID, nullptr if there is none or it has gone away
+    std::shared_ptr<MeasurementStreamWebSocketProtobuf> findStream(const std::string& streamID);
+
 private:
     const int PAYLOAD_OFFSET = 13;
     std::string closedReason;
@@ -120,12 +148,27 @@ private:
     std::condition_variable cvWebSocketOpen;
 
     std::shared_ptr<dfx::websocket::WebSocket> webSocket;
-    std::atomic<int> lastTransactionID;
-    std::mutex mutex;
+    std::mutex mutex; // Protect - pending, timers, closed, closedReason, stopTimeouts, timeoutWakeup
     std::condition_variable cvServiceThread;
-    std::map<std::string, MeasurementStreamWebSocketProtobuf*> streams;
-    std::map<std::string, std::shared_ptr<std::condition_variable>> pending;
-    std::map<std::string, std::shared_ptr<std::vector<uint8_t>>> responses;
+    std::thread timeoutThread;
+    bool stopTimeouts;
+    dfx::api::utils::TimerWheel timers;
+    dfx::api::utils::TimerWheel::Clock::time_point timeoutWakeup; // When timeoutThread next wakes
+    uint16_t requestTimeoutMillis; // CloudConfig::timeoutMillis of the connection, 0 waits forever
+
+    std::mutex streamsMutex; // Protect - streams, lastStreamID
+    std::map<std::string, std::weak_ptr<MeasurementStreamWebSocketProtobuf>> streams;
+    int lastStreamID;
+
+    struct PendingRequest
+    {
+        uint32_t actionID = 0;
+        std::condition_variable answered;
+        std::shared_ptr<std::vector<uint8_t>> response;
+        dfx::api::utils::TimerWheel::Clock::time_point deadline; // Default constructed when there is none
+        bool timedOut = false;
+    };
+    dfx::api::utils::RequestSlotTable<PendingRequest> pending;
 };
 
 } // namespace dfx::api::websocket::protobuf
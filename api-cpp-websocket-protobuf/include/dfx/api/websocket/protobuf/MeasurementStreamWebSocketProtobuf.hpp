@@ -19,8 +19,10 @@ namespace dfx::api::websocket::protobuf
 {
 
 class CloudWebSocketProtobuf;
+class ProtobufArena;
 
-class MeasurementStreamWebSocketProtobuf : public MeasurementStreamAPI
+class MeasurementStreamWebSocketProtobuf : public MeasurementStreamAPI,
+                                           public std::enable_shared_from_this<MeasurementStreamWebSocketProtobuf>
 {
 public:
     MeasurementStreamWebSocketProtobuf(const CloudConfig& config,
@@ -30,6 +32,8 @@ public:
 
     CloudStatus sendChunk(const CloudConfig& config, const std::vector<uint8_t>& chunk, bool isLast) override;
 
+    CloudStatus getQueueStatus(MeasurementQueueStatus& status) override;
+
     CloudStatus cancel(const CloudConfig& config) override;
 
 private:
@@ -52,6 +56,7 @@ private:
     bool writerClosedStream;
     bool lastChunkSent;
 
+    std::mutex mutexChunks; // Protect - lastChunkSent, chunksOutstanding
     std::mutex mutexMeasurementID;
     std::condition_variable cvMeasurementID;
     std::string measurementID;
@@ -62,6 +67,10 @@ private:
     uint16_t chunkOrder;
     bool isFirstChunk;
 
+    // The messages of each chunk sent and each result received are built in these and reset after
+    std::unique_ptr<ProtobufArena> chunkArena;
+    std::unique_ptr<ProtobufArena> resultArena;
+
 private:
     std::shared_ptr<CloudWebSocketProtobuf> cloudWebSocketProtobuf;
 };
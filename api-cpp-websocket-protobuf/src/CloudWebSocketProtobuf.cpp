@@ -18,6 +18,7 @@
 #include "dfx/api/web/WebServiceDetail.hpp"
 
 #include "dfx/websocket/WebSocket.hpp"
+#include "dfx/websocket/WebSocketEventDispatcher.hpp"
 
 #include "dfx/proto/general.pb.h"
 #include "dfx/proto/organizations.pb.h"
@@ -27,6 +28,9 @@
 #include "fmt/format.h"
 #include "nlohmann/json.hpp"
 
+#include <google/protobuf/io/coded_stream.h>
+#include <google/protobuf/wire_format_lite.h>
+
 #include <sstream>
 #include <string>
 #include <vector>
@@ -43,6 +47,7 @@
 
 #include <algorithm>
 #include <chrono>
+#include <cstring>
 #include <thread>
 using namespace dfx::api;
 using namespace dfx::api::websocket::protobuf;
@@ -57,7 +62,9 @@ void CloudWebSocketProtobufCallback(const WebSocketEvent& event, void* userData)
 }
 
 CloudWebSocketProtobuf::CloudWebSocketProtobuf(const CloudConfig& config)
-    : CloudAPI(config), lastTransactionID(1), closedReason(""), closed(true)
+    : CloudAPI(config), closedReason(""), closed(true), stopTimeouts(false),
+      timeoutWakeup(dfx::api::utils::TimerWheel::Clock::time_point::max()), requestTimeoutMillis(0),
+      lastStreamID(1009)
 {
 }
 
@@ -67,6 +74,14 @@ CloudStatus CloudWebSocketProtobuf::connect(const CloudConfig& config)
 
     closed = false;
 
+    {
+        std::unique_lock<std::mutex> lock(mutex); // Protect requestTimeoutMillis
+        requestTimeoutMillis = config.timeoutMillis;
+    }
+    if (!timeoutThread.joinable()) {
+        timeoutThread = std::thread(&CloudWebSocketProtobuf::serviceTimeouts, this);
+    }
+
     if (cloudLogEnabled()) {
         auto logLevel = cloudLogLevel();
         webSocket = WebSocket::create(logLevel, [](uint8_t level, const char* message) { cloudLog(level, message); });
@@ -76,8 +91,25 @@ CloudStatus CloudWebSocketProtobuf::connect(const CloudConfig& config)
     }
 
     webSocket->setRootCertificate(getRootCA(config));
+    if (config.dispatchEvents) {
+        webSocket->setEventDispatcher(WebSocketEventDispatcher::getShared());
+    }
     webSocket->setEventCallback(&CloudWebSocketProtobufCallback, this);
 
+    // Measurement chunks are held back once the send queue is full, log as it fills and drains
+    webSocket->setSendQueueLimits(config.sendQueueMaxBytes, config.sendQueueMaxMessages);
+    webSocket->setSendQueueWaterMarks(config.sendQueueMaxBytes / 4 * 3, config.sendQueueMaxBytes / 4);
+
+    WebSocketCompression compression;
+    compression.enabled = config.compression;
+    compression.windowBits = config.compressionWindowBits;
+    webSocket->setCompression(compression);
+    webSocket->setReceiveBufferSize(config.receiveBufferSize);
+
+    if (!config.tlsSessionCacheFile.empty()) {
+        webSocket->setTLSSessionFile(config.tlsSessionCacheFile);
+    }
+
     std::string wssURL = fmt::format("wss://{}:{}", config.serverHost, config.serverPort);
     std::string wssProtocol("proto");
     webSocket->open(wssURL, wssProtocol);
@@ -92,9 +124,10 @@ CloudStatus CloudWebSocketProtobuf::connect(const CloudConfig& config)
 
     // The call to open will kick of a bunch of asynchronous activity that will eventually trigger
     // a call to handleEvent(OPEN) hopefully, or error but in any case we wait.
+    // The connection is made from the event loop thread so it may already have opened or failed.
     std::unique_lock<std::mutex> lock(mutexOpen);
-    if (!closed) {
-        cvWebSocketOpen.wait(lock);
+    cvWebSocketOpen.wait(lock, [this] { return closed || webSocket->getState() == WebSocketState::OPEN; });
+    if (webSocket->getState() == WebSocketState::OPEN) {
         return CloudStatus(CLOUD_OK);
     } else {
         return CloudStatus(CLOUD_INTERNAL_ERROR, closedReason);
@@ -103,11 +136,22 @@ CloudStatus CloudWebSocketProtobuf::connect(const CloudConfig& config)
 
 CloudWebSocketProtobuf::~CloudWebSocketProtobuf()
 {
+    if (timeoutThread.joinable()) {
+        {
+            std::unique_lock<std::mutex> lock(mutex); // Protect stopTimeouts
+            stopTimeouts = true;
+        }
+        cvServiceThread.notify_one();
+        timeoutThread.join();
+    }
+
     // The webSocket thread may notify us via a callback so we need to ensure the
     // webSocket is properly closed and its associated thread terminates prior to
     // allowing the memory associated with this instance from being released.
     if (webSocket != nullptr) {
         webSocket->close();
+        // Waits out an event the dispatcher thread is still handling and drops any behind it
+        webSocket->setEventCallback(nullptr, nullptr);
     }
 }
 
@@ -139,8 +183,17 @@ void CloudWebSocketProtobuf::handleEvent(const WebSocketEvent& event)
                 cloudLog(CLOUD_LOG_LEVEL_TRACE, "CloudWebSocketProtobuf::handleEvent(MESSAGE) received\n");
                 break;
             }
+            case dfx::websocket::WebSocketEventType::SEND_QUEUE_HIGH: {
+                cloudLog(CLOUD_LOG_LEVEL_TRACE, "CloudWebSocketProtobuf::handleEvent(SEND_QUEUE_HIGH) received\n");
+                break;
+            }
+            case dfx::websocket::WebSocketEventType::SEND_QUEUE_LOW: {
+                cloudLog(CLOUD_LOG_LEVEL_TRACE, "CloudWebSocketProtobuf::handleEvent(SEND_QUEUE_LOW) received\n");
+                break;
+            }
             case dfx::websocket::WebSocketEventType::CLOSED: {
                 cloudLog(CLOUD_LOG_LEVEL_TRACE, "CloudWebSocketProtobuf::handleEvent(CLOSE) received\n");
+                break;
             }
         }
     }
@@ -165,11 +218,7 @@ void CloudWebSocketProtobuf::handleEvent(const WebSocketEvent& event)
             {
                 // Wake up any client threads pending on response
                 std::unique_lock<std::mutex> lock(mutex);
-                responses.clear();
-                for (auto& condition : pending) {
-                    condition.second->notify_all();
-                }
-                pending.clear(); // Remove all now that they have been notified
+                wakePendingRequests();
             }
 
             break;
@@ -182,6 +231,17 @@ void CloudWebSocketProtobuf::handleEvent(const WebSocketEvent& event)
         case dfx::websocket::WebSocketEventType::LISTEN:
         case dfx::websocket::WebSocketEventType::CONNECTION:
             break;
+        case dfx::websocket::WebSocketEventType::SEND_QUEUE_HIGH: {
+            auto queue = webSocket->getSendQueueStatus();
+            cloudLog(CLOUD_LOG_LEVEL_DEBUG,
+                     "Send queue high, %zu requests %zu bytes queued\n",
+                     queue.messages,
+                     queue.bytes);
+            break;
+        }
+        case dfx::websocket::WebSocketEventType::SEND_QUEUE_LOW:
+            cloudLog(CLOUD_LOG_LEVEL_DEBUG, "Send queue drained\n");
+            break;
         case dfx::websocket::WebSocketEventType::MESSAGE:
             handleMessageEvent(event.message);
             break;
@@ -189,11 +249,7 @@ void CloudWebSocketProtobuf::handleEvent(const WebSocketEvent& event)
             std::unique_lock<std::mutex> lock(mutex); // Protect pending, closed
             closedReason = "received closed";
             closed = true;
-            responses.clear();
-            for (const auto& condition : pending) {
-                condition.second->notify_all();
-            }
-            pending.clear(); // Remove all now that they have been notified
+            wakePendingRequests();
             break;
         }
     }
@@ -210,23 +266,29 @@ void CloudWebSocketProtobuf::handleMessageEvent(const dfx::websocket::WebSocketM
         cloudLog(CLOUD_LOG_LEVEL_WARNING, "Ignoring empty data event\n");
     } else {
         auto rawData = reinterpret_cast<const char*>(messageEvent.data->data());
-        std::string requestID(rawData, 10);
+        if (messageEvent.data->size() < dfx::api::utils::REQUEST_ID_LENGTH) {
+            cloudLog(CLOUD_LOG_LEVEL_WARNING, "Ignoring message without a request ID\n");
+            return;
+        }
 
-        std::unique_lock<std::mutex> lock(mutex); // Protect pending
-        if (requestID.rfind("STRM") != 0) {
+        if (strncmp(rawData, "STRM", 4) != 0) {
             // This is not a stream response so wake up client and send them the response
-            auto iter = pending.find(requestID);
-            if (iter != pending.end()) {
-                auto condition = iter->second;
-                pending.erase(iter);
-
-                responses[requestID] = messageEvent.data;
+            uint32_t actionID = 0;
+            uint32_t sequence = 0;
+            PendingRequest* request = nullptr;
 
-                condition->notify_one();
+            std::unique_lock<std::mutex> lock(mutex); // Protect pending
+            if (dfx::api::utils::parseRequestID(rawData, actionID, sequence)) {
+                request = pending.find(sequence);
+            }
+            if (request != nullptr && request->actionID == actionID && request->response == nullptr) {
+                // The waiting thread releases the slot once it has taken the response
+                request->response = messageEvent.data;
+                request->answered.notify_one();
             } else {
                 // Something bad has happened - shutdown
                 if (cloudLogIsActive(CLOUD_LOG_LEVEL_ERROR)) {
-                    cloudLog(CLOUD_LOG_LEVEL_ERROR, "requestID %s missing, nothing to notify\n", requestID.c_str());
+                    cloudLog(CLOUD_LOG_LEVEL_ERROR, "requestID %.10s missing, nothing to notify\n", rawData);
 
                     auto hexData = dfx::api::utils::hexDump(
                         "Unhandled Message", messageEvent.data.get()->data(), messageEvent.data->size());
@@ -234,157 +296,283 @@ void CloudWebSocketProtobuf::handleMessageEvent(const dfx::websocket::WebSocketM
                 }
             }
         } else {
-            auto iter = streams.find(requestID);
-            if (iter != streams.end()) {
-                iter->second->handleStreamResponse(messageEvent.data);
+            // Results for one of the measurements on this connection
+            auto measurementStream = findStream(std::string(rawData, dfx::api::utils::REQUEST_ID_LENGTH));
+            if (measurementStream != nullptr) {
+                measurementStream->handleStreamResponse(messageEvent.data);
             }
         }
     }
 }
 
-// The header comprises 4 digits for the actionID followed by a 10 digit requestID. In order
-// to track which type of request it was when we receive a response, the first four of the 10 digit
-// requestID stores the actionID leaving the remaining 6 digits to represent a monotonically
-// increasing number. When it reaches the maximum number representable by those 6 digits, it is
-// wrapped back to the start.
-std::string CloudWebSocketProtobuf::getRequestID(int actionID)
+void CloudWebSocketProtobuf::wakePendingRequests()
+{
+    // Each waiting thread releases its own slot when it wakes
+    pending.forEach([](uint32_t, PendingRequest& request) { request.answered.notify_all(); });
+}
+
+void CloudWebSocketProtobuf::serviceTimeouts()
 {
-    auto nextID = lastTransactionID++;
-    if (nextID > 999999) {
-        lastTransactionID = 2;
-        nextID = 1;
+    std::vector<uint32_t> expired;
+
+    std::unique_lock<std::mutex> lock(mutex); // Protect pending, timers, stopTimeouts, timeoutWakeup
+    while (!stopTimeouts) {
+        timeoutWakeup = timers.nextExpiry();
+        if (timeoutWakeup == dfx::api::utils::TimerWheel::Clock::time_point::max()) {
+            cvServiceThread.wait(lock);
+        } else {
+            cvServiceThread.wait_until(lock, timeoutWakeup);
+        }
+
+        expired.clear();
+        timers.expire(dfx::api::utils::TimerWheel::Clock::now(), expired);
+        for (auto sequence : expired) {
+            // The waiting thread releases the slot once it sees it timed out
+            auto* request = pending.find(sequence);
+            if (request != nullptr && request->response == nullptr) {
+                request->timedOut = true;
+                request->answered.notify_one();
+            }
+        }
+        if (!expired.empty()) {
+            cloudLog(CLOUD_LOG_LEVEL_WARNING, "%zu requests timed out waiting on a response\n", expired.size());
+        }
     }
-    assert(actionID <= 9999);              // Developer error, no actionID > 9999.
-    actionID = (std::min)(actionID, 9999); // Explicit (std::min) to help Windows compile.
-    auto requestID = fmt::format("{:04}{:06}", actionID, nextID);
-    return requestID;
 }
 
-void CloudWebSocketProtobuf::registerStream(const std::string& streamID,
-                                            MeasurementStreamWebSocketProtobuf* measurementStream)
+void CloudWebSocketProtobuf::startRequestTimer(uint32_t sequence)
 {
+    std::unique_lock<std::mutex> lock(mutex); // Protect pending, timers, timeoutWakeup
+    auto* request = pending.find(sequence);
+    if (request == nullptr || request->response != nullptr || requestTimeoutMillis == 0) {
+        return; // Already answered or closed, or waits forever
+    }
+    request->deadline =
+        dfx::api::utils::TimerWheel::Clock::now() + std::chrono::milliseconds(requestTimeoutMillis);
+    timers.schedule(sequence, request->deadline);
+    if (request->deadline < timeoutWakeup) {
+        cvServiceThread.notify_one(); // Sooner than the timeout thread is waiting for
+    }
+}
+
+std::string CloudWebSocketProtobuf::registerStream(
+    const std::shared_ptr<MeasurementStreamWebSocketProtobuf>& measurementStream)
+{
+    std::unique_lock<std::mutex> lock(streamsMutex); // Protect - streams, lastStreamID
+
+    // STRM is nothing special but nice to look at when debugging, API just wants a 10 byte transaction ID.
+    // The number wraps like request IDs do, skipping any still in use by a long running stream.
+    std::string streamID;
+    do {
+        lastStreamID = lastStreamID >= 999999 ? 1 : lastStreamID + 1;
+        streamID = fmt::format("STRM{:06}", lastStreamID);
+    } while (streams.count(streamID) != 0);
+
     streams[streamID] = measurementStream;
+    return streamID;
 }
 
 void CloudWebSocketProtobuf::deregisterStream(const std::string& streamID)
 {
+    std::unique_lock<std::mutex> lock(streamsMutex); // Protect - streams
+    streams.erase(streamID);
+}
+
+std::shared_ptr<MeasurementStreamWebSocketProtobuf> CloudWebSocketProtobuf::findStream(const std::string& streamID)
+{
+    std::unique_lock<std::mutex> lock(streamsMutex); // Protect - streams
     auto iter = streams.find(streamID);
-    if (iter != streams.end()) {
-        streams.erase(iter);
+    if (iter == streams.end()) {
+        return nullptr;
     }
+    return iter->second.lock();
 }
 
 CloudStatus CloudWebSocketProtobuf::sendMessage(const dfx::api::web::WebServiceDetail& detail,
                                                 ::google::protobuf::Message& message,
                                                 ::google::protobuf::Message& response)
 {
-    std::string requestString;
-    if (!message.SerializeToString(&requestString)) {
-        return CloudStatus(CLOUD_PARAMETER_VALIDATION_ERROR);
-    }
-
-    auto actionID = fmt::format("{:04}", detail.wsCode);
-    auto requestID = getRequestID(detail.wsCode);
+    return sendMessage(detail, message, 0, nullptr, 0, response);
+}
 
-    auto strRequest = actionID + requestID + requestString;
+CloudStatus CloudWebSocketProtobuf::sendMessage(const dfx::api::web::WebServiceDetail& detail,
+                                                const ::google::protobuf::Message& message,
+                                                int payloadFieldNumber,
+                                                const uint8_t* payload,
+                                                size_t payloadSize,
+                                                ::google::protobuf::Message& response,
+                                                const CloudConfig* sendQueueConfig)
+{
+    using ::google::protobuf::internal::WireFormatLite;
+    using ::google::protobuf::io::CodedOutputStream;
 
-    auto condition = std::make_shared<std::condition_variable>();
+    // Registered before sending so a response can never arrive ahead of its request
+    uint32_t sequence;
+    PendingRequest* request;
     {
-        std::unique_lock<std::mutex> lock(mutex);
+        std::unique_lock<std::mutex> lock(mutex); // Protect pending
         if (webSocket->getState() != WebSocketState::OPEN) {
             return CloudStatus(CLOUD_TRANSPORT_CLOSED, closedReason);
         }
-        pending[requestID] = condition;
+        sequence = pending.acquire();
+        if (sequence == 0) {
+            return CloudStatus(CLOUD_WOULD_BLOCK, "Too many requests waiting on a response");
+        }
+        request = pending.find(sequence); // Slots never move, safe to use until released
+        request->actionID = static_cast<uint32_t>(detail.wsCode);
+        request->response.reset();
+        request->timedOut = false;
+        request->deadline = {}; // Scheduled once written, a slow uplink can hold it in the send queue for a while
+    }
+    // Frees the slot and its timer, mutex must be held
+    auto releaseSlot = [this, sequence, request]() {
+        if (request->deadline != dfx::api::utils::TimerWheel::Clock::time_point()) {
+            timers.cancel(sequence, request->deadline);
+        }
+        pending.release(sequence);
+    };
+    auto releaseRequest = [this, &releaseSlot]() {
+        std::unique_lock<std::mutex> lock(mutex); // Protect pending, timers
+        releaseSlot();
+    };
+
+    assert(detail.wsCode <= 9999); // Developer error, no actionID > 9999.
+    auto actionID = static_cast<uint32_t>((std::min)(detail.wsCode, 9999));
+    auto header = dfx::api::utils::formatRequestHeader(actionID, sequence);
+
+    const auto serializedSize = message.ByteSizeLong();
+
+    // Fields may appear in any order on the wire, the payload field is written after the message
+    uint32_t payloadTag = 0;
+    size_t payloadHeaderSize = 0;
+    if (payloadFieldNumber > 0) {
+        payloadTag = WireFormatLite::MakeTag(payloadFieldNumber, WireFormatLite::WIRETYPE_LENGTH_DELIMITED);
+        payloadHeaderSize = CodedOutputStream::VarintSize32(payloadTag) +
+                            CodedOutputStream::VarintSize32(static_cast<uint32_t>(payloadSize));
+    }
+
+    // Serialize directly into a buffer leased from the socket which is sent without a further copy
+    auto buffer = webSocket->acquireSendBuffer(header.size() + serializedSize + payloadHeaderSize + payloadSize);
+    buffer->append(header.data(), header.size());
+
+    const auto messageOffset = buffer->size();
+    buffer->resize(messageOffset + serializedSize + payloadHeaderSize);
+    auto* target = buffer->data() + messageOffset;
+    if (!message.SerializeToArray(target, static_cast<int>(serializedSize))) {
+        releaseRequest();
+        return CloudStatus(CLOUD_PARAMETER_VALIDATION_ERROR);
+    }
+    if (payloadFieldNumber > 0) {
+        target = CodedOutputStream::WriteVarint32ToArray(payloadTag, target + serializedSize);
+        CodedOutputStream::WriteVarint32ToArray(static_cast<uint32_t>(payloadSize), target);
+        buffer->append(payload, payloadSize);
+    }
 
 #ifndef NDEBUG
-        if (cloudLogIsActive(CLOUD_LOG_LEVEL_DEBUG)) {
-            cloudLog(CLOUD_LOG_LEVEL_DEBUG,
-                     "Request [%d,%s,%s]\n",
-                     detail.wsCode,
-                     detail.httpOption.c_str(),
-                     detail.urlPath.c_str());
-            if (cloudLogIsActive(CLOUD_LOG_LEVEL_TRACE)) {
-                auto hexBytes = dfx::api::utils::hexDump("Request bytes:\n", strRequest.c_str(), strRequest.size());
-                cloudLog(CLOUD_LOG_LEVEL_TRACE, "%s", hexBytes.c_str());
-            }
+    if (cloudLogIsActive(CLOUD_LOG_LEVEL_DEBUG)) {
+        cloudLog(CLOUD_LOG_LEVEL_DEBUG,
+                 "Request [%d,%s,%s]\n",
+                 detail.wsCode,
+                 detail.httpOption.c_str(),
+                 detail.urlPath.c_str());
+        if (cloudLogIsActive(CLOUD_LOG_LEVEL_TRACE)) {
+            auto hexBytes = dfx::api::utils::hexDump("Request bytes:\n", buffer->data(), buffer->size());
+            cloudLog(CLOUD_LOG_LEVEL_TRACE, "%s", hexBytes.c_str());
         }
+    }
 #endif
 
-        // Need to check we are not terminated before the send and wait
-        webSocket->sendUTF8(strRequest);
+    buffer->setWrittenCallback([this, sequence]() { startRequestTimer(sequence); });
 
-        condition->wait(lock);
-        if (closed) {
+    // Queue outside of mutex, waiting for room in the send queue must not hold up responses
+    if (sendQueueConfig != nullptr) {
+        auto sendStatus = webSocket->trySend(buffer, sendQueueConfig->sendQueueTimeoutMillis);
+        if (sendStatus != dfx::websocket::Status::OK) {
+            releaseRequest();
+            if (sendStatus == dfx::websocket::Status::WOULD_BLOCK) {
+                return CloudStatus(CLOUD_WOULD_BLOCK, "Send queue is full");
+            }
+            std::unique_lock<std::mutex> lock(mutex); // Protect closedReason
             return CloudStatus(CLOUD_TRANSPORT_CLOSED, closedReason);
         }
-    }
-
-    auto iter = responses.find(requestID);
-    if (iter == responses.end()) {
-        // Unable to find a response for the requestID, should not happen
-        return CloudStatus(CLOUD_INTERNAL_ERROR);
     } else {
-        auto message = iter->second;
-        responses.erase(iter);
+        webSocket->send(std::move(buffer));
+    }
 
-        if (message->size() < PAYLOAD_OFFSET) {
-            return CloudStatus(CLOUD_INTERNAL_ERROR,
-                               "Response message was too small: " + std::to_string(message->size()));
+    std::shared_ptr<std::vector<uint8_t>> responseMessage;
+    {
+        std::unique_lock<std::mutex> lock(mutex); // Protect pending, timers, closed
+        request->answered.wait(
+            lock, [this, request] { return closed || request->timedOut || request->response != nullptr; });
+        responseMessage = std::move(request->response);
+        const bool timedOut = request->timedOut;
+        releaseSlot();
+        if (responseMessage == nullptr) {
+            if (timedOut) {
+                return CloudStatus(CLOUD_TIMEOUT, "No response to the request");
+            }
+            return CloudStatus(CLOUD_TRANSPORT_CLOSED, closedReason);
         }
+    }
+
+    if (responseMessage->size() < PAYLOAD_OFFSET) {
+        return CloudStatus(CLOUD_INTERNAL_ERROR,
+                           "Response message was too small: " + std::to_string(responseMessage->size()));
+    }
 
-        auto rawData = reinterpret_cast<const char*>(message->data());
+    auto rawData = reinterpret_cast<const char*>(responseMessage->data());
 
-        std::string statusCode(rawData + 10, 3);
+    std::string statusCode(rawData + 10, 3);
 
-        auto rawSize = message->size();
-        assert(rawSize < INT_MAX); // Explicit cast - something wrong if this big
-        int messageSize = static_cast<int>(rawSize);
+    auto rawSize = responseMessage->size();
+    assert(rawSize < INT_MAX); // Explicit cast - something wrong if this big
+    int messageSize = static_cast<int>(rawSize);
 
 #ifndef NDEBUG
-        if (cloudLogIsActive(CLOUD_LOG_LEVEL_DEBUG)) {
-            cloudLog(CLOUD_LOG_LEVEL_DEBUG,
-                     "Response [%d,%s,%s]\n",
-                     detail.wsCode,
-                     detail.httpOption.c_str(),
-                     detail.urlPath.c_str());
-            if (cloudLogIsActive(CLOUD_LOG_LEVEL_TRACE)) {
-                auto hexBytes = dfx::api::utils::hexDump("Response bytes:\n", message->data(), message->size());
-                cloudLog(CLOUD_LOG_LEVEL_TRACE, "%s", hexBytes.c_str());
-            }
+    if (cloudLogIsActive(CLOUD_LOG_LEVEL_DEBUG)) {
+        cloudLog(CLOUD_LOG_LEVEL_DEBUG,
+                 "Response [%d,%s,%s]\n",
+                 detail.wsCode,
+                 detail.httpOption.c_str(),
+                 detail.urlPath.c_str());
+        if (cloudLogIsActive(CLOUD_LOG_LEVEL_TRACE)) {
+            auto hexBytes =
+                dfx::api::utils::hexDump("Response bytes:\n", responseMessage->data(), responseMessage->size());
+            cloudLog(CLOUD_LOG_LEVEL_TRACE, "%s", hexBytes.c_str());
         }
+    }
 #endif
 
-        // Request is considered OK
-        if (statusCode == "200") {
-            if (response.ParseFromArray(rawData + PAYLOAD_OFFSET, messageSize - PAYLOAD_OFFSET)) {
-                return CloudStatus(CLOUD_OK);
-            } else {
-                return CloudStatus(CLOUD_INTERNAL_ERROR);
-            }
-        } else if (statusCode == "403") {
-            if (response.GetTypeName() == "dfx.proto.users.LoginResponse") {
-                if (response.ParseFromArray(rawData + PAYLOAD_OFFSET, messageSize - PAYLOAD_OFFSET)) {
-                    dfx::proto::users::LoginResponse* loginResponse =
-                        static_cast<dfx::proto::users::LoginResponse*>(&response);
-                    return CloudStatus(CLOUD_USER_NOT_AUTHORIZED, loginResponse->token());
-                }
-            }
-        } else if (statusCode == "409") {
-            if (response.ParseFromArray(rawData + PAYLOAD_OFFSET, messageSize - PAYLOAD_OFFSET)) {
-                // Don't really know what type of response it is, best we can do is grab the debug string
-                return CloudStatus(CLOUD_RECORD_ALREADY_EXISTS, response.DebugString());
-            }
-        } else if (statusCode == "500") {
+    // Request is considered OK
+    if (statusCode == "200") {
+        if (response.ParseFromArray(rawData + PAYLOAD_OFFSET, messageSize - PAYLOAD_OFFSET)) {
+            return CloudStatus(CLOUD_OK);
+        } else {
+            return CloudStatus(CLOUD_INTERNAL_ERROR);
+        }
+    } else if (statusCode == "403") {
+        if (response.GetTypeName() == "dfx.proto.users.LoginResponse") {
             if (response.ParseFromArray(rawData + PAYLOAD_OFFSET, messageSize - PAYLOAD_OFFSET)) {
-                // Don't really know what type of response it is, best we can do is grab the debug string
-                // which returns something like: "DeviceID: \"INTERNAL_ERROR\"\n"
-                return CloudStatus(CLOUD_INTERNAL_ERROR, response.DebugString());
+                dfx::proto::users::LoginResponse* loginResponse =
+                    static_cast<dfx::proto::users::LoginResponse*>(&response);
+                return CloudStatus(CLOUD_USER_NOT_AUTHORIZED, loginResponse->token());
             }
         }
-
-        // Some form of error occurred
-        return decodeWebSocketError(statusCode, std::vector<uint8_t>(rawData + PAYLOAD_OFFSET, rawData + messageSize));
+    } else if (statusCode == "409") {
+        if (response.ParseFromArray(rawData + PAYLOAD_OFFSET, messageSize - PAYLOAD_OFFSET)) {
+            // Don't really know what type of response it is, best we can do is grab the debug string
+            return CloudStatus(CLOUD_RECORD_ALREADY_EXISTS, response.DebugString());
+        }
+    } else if (statusCode == "500") {
+        if (response.ParseFromArray(rawData + PAYLOAD_OFFSET, messageSize - PAYLOAD_OFFSET)) {
+            // Don't really know what type of response it is, best we can do is grab the debug string
+            // which returns something like: "DeviceID: \"INTERNAL_ERROR\"\n"
+            return CloudStatus(CLOUD_INTERNAL_ERROR, response.DebugString());
+        }
     }
+
+    // Some form of error occurred
+    return decodeWebSocketError(statusCode, std::vector<uint8_t>(rawData + PAYLOAD_OFFSET, rawData + messageSize));
 }
 
 CloudStatus CloudWebSocketProtobuf::decodeWebSocketError(const std::string& statusCode,
@@ -3,9 +3,12 @@
 
 #include "dfx/api/websocket/protobuf/MeasurementStreamWebSocketProtobuf.hpp"
 #include "dfx/api/CloudLog.hpp"
+#include "dfx/api/utils/Dequantize.hpp"
 #include "dfx/api/validator/CloudValidator.hpp"
 #include "dfx/api/websocket/protobuf/CloudWebSocketProtobuf.hpp"
 
+#include "ProtobufArena.hpp"
+
 #include "dfx/proto/measurements.pb.h"
 
 #include "fmt/format.h"
@@ -25,7 +28,8 @@ using namespace std::chrono_literals;
 
 MeasurementStreamWebSocketProtobuf::MeasurementStreamWebSocketProtobuf(
     const CloudConfig& config, const std::shared_ptr<CloudWebSocketProtobuf>& cloudWebSocketProtobuf)
-    : cloudWebSocketProtobuf(std::move(cloudWebSocketProtobuf))
+    : chunkArena(std::make_unique<ProtobufArena>()), resultArena(std::make_unique<ProtobufArena>()),
+      cloudWebSocketProtobuf(std::move(cloudWebSocketProtobuf))
 {
     initialize();
 }
@@ -33,6 +37,9 @@ MeasurementStreamWebSocketProtobuf::MeasurementStreamWebSocketProtobuf(
 MeasurementStreamWebSocketProtobuf::~MeasurementStreamWebSocketProtobuf()
 {
     closeStream();
+    if (!requestID.empty()) {
+        cloudWebSocketProtobuf->deregisterStream(requestID);
+    }
 }
 
 void MeasurementStreamWebSocketProtobuf::initialize()
@@ -139,9 +146,11 @@ CloudStatus MeasurementStreamWebSocketProtobuf::setupStream(const CloudConfig& c
     }
 
     {
-        // STRM is nothing special but nice to look at when debugging, API just wants
-        // a random 10 byte transaction ID
-        requestID = fmt::format("STRM{:06}", 1010);
+        // Each measurement on the connection gets its own stream ID so their results are kept apart
+        if (!requestID.empty()) {
+            cloudWebSocketProtobuf->deregisterStream(requestID); // Left over from before a reset
+        }
+        requestID = cloudWebSocketProtobuf->registerStream(shared_from_this());
 
         dfx::proto::measurements::SubscribeResultsRequest request;
         dfx::proto::measurements::SubscribeResultsResponse response;
@@ -149,7 +158,6 @@ CloudStatus MeasurementStreamWebSocketProtobuf::setupStream(const CloudConfig& c
         request.mutable_params()->set_id(measurementID);
         request.set_requestid(requestID);
 
-        cloudWebSocketProtobuf->registerStream(requestID, this);
         auto status =
             cloudWebSocketProtobuf->sendMessage(dfx::api::web::Measurements::SubscribeResults, request, response);
         if (!status.OK()) {
@@ -182,25 +190,46 @@ CloudStatus MeasurementStreamWebSocketProtobuf::sendChunk(const CloudConfig& con
         return status; // if it has already been closed.
     }
 
-    dfx::proto::measurements::DataRequest request;
-    dfx::proto::measurements::DataResponse response;
+    auto* request = chunkArena->create<dfx::proto::measurements::DataRequest>();
+    auto* response = chunkArena->create<dfx::proto::measurements::DataResponse>();
 
-    request.mutable_params()->set_id(measurementID);
+    request->mutable_params()->set_id(measurementID);
     if (!isLastChunk) {
         if (chunkOrder == 0) {
-            request.set_action("FIRST::PROCESS");
+            request->set_action("FIRST::PROCESS");
         } else {
-            request.set_action("CHUNK::PROCESS");
+            request->set_action("CHUNK::PROCESS");
         }
     } else {
-        request.set_action("LAST::PROCESS");
-        lastChunkSent = true;
+        request->set_action("LAST::PROCESS");
     }
 
-    const std::string payload(chunk.begin(), chunk.end());
-    request.set_payload(payload);
+    // Counted before it is sent, its result may be handled before sendMessage() returns
+    bool wasLastChunkSent;
+    {
+        const std::lock_guard<std::mutex> lock(mutexChunks);
+        wasLastChunkSent = lastChunkSent;
+        lastChunkSent = lastChunkSent || isLastChunk;
+        chunksOutstanding++;
+    }
 
-    status = cloudWebSocketProtobuf->sendMessage(dfx::api::web::Measurements::Data, request, response);
+    // The chunk is serialized as the payload field straight into the outgoing buffer, not copied into request
+    status = cloudWebSocketProtobuf->sendMessage(dfx::api::web::Measurements::Data,
+                                                 *request,
+                                                 dfx::proto::measurements::DataRequest::kPayloadFieldNumber,
+                                                 chunk.data(),
+                                                 chunk.size(),
+                                                 *response,
+                                                 &config);
+    chunkArena->reset(); // Neither message is needed past here
+    if (!status.OK()) {
+        const std::lock_guard<std::mutex> lock(mutexChunks);
+        lastChunkSent = wasLastChunkSent;
+        chunksOutstanding--;
+    }
+    if (status.code == CLOUD_WOULD_BLOCK) {
+        return status; // Nothing was sent, the caller can retry the chunk once the queue drains
+    }
     if (!status.OK()) {
         cloudLog(CLOUD_LOG_LEVEL_WARNING, "WEB: Send not okay %d: %s", status.code, status.message.c_str());
 
@@ -209,11 +238,20 @@ CloudStatus MeasurementStreamWebSocketProtobuf::sendChunk(const CloudConfig& con
         return status;
     }
 
-    chunksOutstanding++;
+    chunkOrder++;
 
     return CloudStatus(CLOUD_OK);
 }
 
+CloudStatus MeasurementStreamWebSocketProtobuf::getQueueStatus(MeasurementQueueStatus& status)
+{
+    auto queue = cloudWebSocketProtobuf->webSocket->getSendQueueStatus();
+    status.queuedMessages = queue.messages;
+    status.queuedBytes = queue.bytes;
+    status.oldestQueuedMillis = queue.oldestMillis;
+    return CloudStatus(CLOUD_OK);
+}
+
 CloudStatus MeasurementStreamWebSocketProtobuf::cancel(const CloudConfig& config)
 {
     CloudStatus status(CLOUD_OK);
@@ -247,14 +285,16 @@ void MeasurementStreamWebSocketProtobuf::handleStreamResponse(const std::shared_
         cloudLog(CLOUD_LOG_LEVEL_WARNING, "WEB: Response status bad %d: %s", status.code, status.message.c_str());
         closeMeasurement(status);
     } else {
-        dfx::proto::measurements::SubscribeResultsResponse response;
+        // Decoded into the stream's arena, the channel map and its packed data make up most of a response
+        auto* response = resultArena->create<dfx::proto::measurements::SubscribeResultsResponse>();
 
-        if (!response.ParseFromArray(rawData + 13, messageSize - 13)) {
+        if (!response->ParseFromArray(rawData + 13, messageSize - 13)) {
+            resultArena->reset();
             cloudLog(CLOUD_LOG_LEVEL_WARNING, "WEB: Response decode failed");
             closeMeasurement(CloudStatus(CLOUD_INTERNAL_ERROR, "WEB: Response decode failed"));
         } else {
-            if (response.has_error()) {
-                const auto& error = response.error();
+            if (response->has_error()) {
+                const auto& error = response->error();
                 const auto& errorCode = error.code();
                 if (errorCode != "OK") {
                     MeasurementWarning warning{};
@@ -265,20 +305,20 @@ void MeasurementStreamWebSocketProtobuf::handleStreamResponse(const std::shared_
                 }
             }
 
-            if (response.measurementid().length() > 0) {
+            if (response->measurementid().length() > 0) {
                 if (measurementID.empty()) { // Only send client measurement ID once per measurement
-                    handleMeasurementID(response.measurementid());
-                    measurementID = response.measurementid();
+                    handleMeasurementID(response->measurementid());
+                    measurementID = response->measurementid();
                 }
             }
 
-            auto multiplier = static_cast<float>(response.multiplier());
+            auto multiplier = static_cast<float>(response->multiplier());
             if (multiplier == 0) {
                 multiplier = 1; // Extra cautious to avoid divide by zero below
             }
 
             int chunkNumber(0);
-            auto measurementDataID = response.measurementdataid();
+            auto measurementDataID = response->measurementdataid();
             if (measurementDataID.length() > measurementID.length() + 1) { // Expect measurementID:#
                 measurementDataID = measurementDataID.substr(measurementID.length() + 1);
                 chunkNumber = std::stoi(measurementDataID);
@@ -306,26 +346,21 @@ void MeasurementStreamWebSocketProtobuf::handleStreamResponse(const std::shared_
             //  map<string, Channel> Channels = 5;
             //  Error Error = 6;
             //}
-            for (auto& channel : response.channels()) {
-                std::string signalName = channel.first;
-                std::string channelName = channel.second.channel();
-
-                std::vector<float> data;
+            for (auto& channel : response->channels()) {
+                // Data in measurementData is quantized, the v2 interface was designed to hand back floats
                 auto& measurementData = channel.second.data();
-                data.reserve(measurementData.size());
-                for (const auto& value : measurementData) {
-                    // Data in measurementData is type float, the v2 interface was
-                    // designed to hand back doubles.
-                    data.push_back(static_cast<float>(value) / multiplier);
-                }
-
-                result.signalData[signalName] = data;
+                auto& data = result.signalData[channel.first];
+                data.resize(static_cast<size_t>(measurementData.size()));
+                dfx::api::utils::dequantize(measurementData.data(), data.size(), multiplier, data.data());
             }
 
+            resultArena->reset(); // Everything needed has been copied into result
+
             if (result.signalData.size() > 0) {
                 handleResult(result);
             }
 
+            const std::lock_guard<std::mutex> lock(mutexChunks);
             chunksOutstanding--;
             if (lastChunkSent && chunksOutstanding == 0) {
                 closeStream(); // All responses received, shut the stream down
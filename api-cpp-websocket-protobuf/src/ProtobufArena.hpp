@@ -0,0 +1,65 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_API_WEBSOCKET_PROTOBUF_ARENA_H
+#define DFX_API_WEBSOCKET_PROTOBUF_ARENA_H
+
+#include <google/protobuf/arena.h>
+
+#include <cstddef>
+#include <memory>
+
+namespace dfx::api::websocket::protobuf
+{
+
+/**
+ * A google::protobuf::Arena for the messages of one stream, reset after each message. Its first block
+ * is owned here and survives reset(), so a message which fits in it (a chunk request, a results
+ * response with its map of channels and packed data) is built and decoded without touching the heap.
+ * Larger messages spill into blocks the arena allocates and frees on reset().
+ *
+ * Messages are only valid until the next reset() and it is not thread safe, each thread which builds
+ * messages needs its own.
+ */
+class ProtobufArena
+{
+public:
+    static const size_t DEFAULT_BLOCK_SIZE = 64 * 1024;
+
+    explicit ProtobufArena(size_t blockSize = DEFAULT_BLOCK_SIZE)
+        : block(new char[blockSize]), arena(getOptions(block.get(), blockSize))
+    {
+    }
+
+    ProtobufArena(const ProtobufArena&) = delete;
+    ProtobufArena& operator=(const ProtobufArena&) = delete;
+
+    template <typename Message>
+    Message* create()
+    {
+        return google::protobuf::Arena::CreateMessage<Message>(&arena);
+    }
+
+    // Destroys every message created since the last reset
+    void reset()
+    {
+        arena.Reset();
+    }
+
+private:
+    static google::protobuf::ArenaOptions getOptions(char* block, size_t blockSize)
+    {
+        google::protobuf::ArenaOptions options;
+        options.initial_block = block;
+        options.initial_block_size = blockSize;
+        return options;
+    }
+
+    std::unique_ptr<char[]> block;
+    google::protobuf::Arena arena;
+};
+
+} // namespace dfx::api::websocket::protobuf
+
+#endif // DFX_API_WEBSOCKET_PROTOBUF_ARENA_H
@@ -7,6 +7,7 @@
 
 #include "dfx/api/CloudAPI_Export.hpp"
 
+#include <cstdint>
 #include <ostream>
 #include <string>
 
@@ -247,12 +248,17 @@ public:
 
     /**
      * \~english
-     * The network timeout in milliseconds to use for server communications.
+     * The network timeout in milliseconds to use for server communications. On WebSocket
+     * connections a request with no response by then fails with CLOUD_TIMEOUT, 0 waits forever.
+     * It counts from when the request is written, not while it waits in the send queue.
+     * Defaults to 10 seconds, as when loaded from a configuration file.
      *
      * \~chinese
-     * 链接服务超时时间,单位毫秒
+     * 链接服务超时时间,单位毫秒。WebSocket连接上的请求超时未收到响应时返回CLOUD_TIMEOUT，0为一直等待。
+     * 从请求写出时开始计时，在发送队列中等待的时间不计入。
+     * 默认为10秒，与从配置文件加载时相同
      */
-    uint16_t timeoutMillis;
+    uint16_t timeoutMillis = 10 * 1000;
 
     /**
      * \~english
@@ -298,6 +304,117 @@ public:
      * 当很明确知道服务安全的情况下，可跳过验证
      */
     bool skipVerify;
+
+    /**
+     * \~english
+     * The most bytes of requests which may be queued for sending on a connection
+     * before measurement chunks are held back, zero is unlimited.
+     *
+     * Used by the WebSocket and gRPC transports, when the uplink is slower than chunks are
+     * produced sendChunk() waits for up to sendQueueTimeoutMillis for the queue to
+     * drain and then returns CLOUD_WOULD_BLOCK so the producer can throttle.
+     *
+     * \~chinese
+     * 连接上等待发送的请求的最大字节数，超过后暂缓发送测量数据块，0为不限制。
+     * 用于WebSocket和gRPC传输，上行速度慢于数据块产生速度时，sendChunk()最多等待
+     * sendQueueTimeoutMillis让队列腾出空间，然后返回CLOUD_WOULD_BLOCK以便调用方降低发送速度
+     */
+    uint32_t sendQueueMaxBytes = 0;
+
+    /**
+     * \~english
+     * The most requests which may be queued for sending on a connection before
+     * measurement chunks are held back, zero is unlimited.
+     *
+     * \~chinese
+     * 连接上等待发送的请求的最大数量，超过后暂缓发送测量数据块，0为不限制
+     */
+    uint32_t sendQueueMaxMessages = 0;
+
+    /**
+     * \~english
+     * The time in milliseconds sendChunk() waits for room in a full send queue
+     * before returning CLOUD_WOULD_BLOCK, zero returns immediately and
+     * SEND_QUEUE_WAIT_FOREVER waits until there is room or the connection closes.
+     *
+     * \~chinese
+     * 发送队列已满时sendChunk()等待空间的时间,单位毫秒，超时返回CLOUD_WOULD_BLOCK。
+     * 0为立即返回，SEND_QUEUE_WAIT_FOREVER为一直等待直到有空间或连接关闭
+     */
+    uint32_t sendQueueTimeoutMillis = 0;
+
+    /**
+     * \~english
+     * sendQueueTimeoutMillis value which waits for room in the send queue without a time limit.
+     *
+     * \~chinese
+     * sendQueueTimeoutMillis取此值时等待发送队列空间不设时间限制
+     */
+    static const uint32_t SEND_QUEUE_WAIT_FOREVER = UINT32_MAX;
+
+    /**
+     * \~english
+     * Offer permessage-deflate compression on WebSocket connections, off by default.
+     *
+     * Large JSON results and base64 encoded chunks compress well, the server may
+     * still decline it in which case messages are sent uncompressed.
+     *
+     * \~chinese
+     * 是否在WebSocket连接上请求permessage-deflate压缩，默认关闭。
+     * 较大的JSON结果和base64编码的数据块压缩效果好，服务器拒绝时消息不压缩发送
+     */
+    bool compression = false;
+
+    /**
+     * \~english
+     * The deflate window size as a power of two from 9 to 15 used in both directions
+     * when compression is enabled, smaller windows use less memory per connection.
+     *
+     * \~chinese
+     * 启用压缩时双向使用的deflate窗口大小，为2的9到15次方，窗口越小每个连接占用内存越少
+     */
+    uint8_t compressionWindowBits = 15;
+
+    /**
+     * \~english
+     * Size in bytes of the buffer each WebSocket connection reads frames into.
+     *
+     * Zero, the default, uses a small buffer and reassembles larger messages as
+     * they arrive so many connections can be held open without reserving memory
+     * for the largest possible message on each of them.
+     *
+     * \~chinese
+     * 每个WebSocket连接读取帧的缓冲区大小,单位字节。
+     * 默认为0，使用较小的缓冲区并在收到数据时拼接较大的消息，
+     * 这样可以同时保持多个连接而无需为每个连接预留最大消息所需的内存
+     */
+    uint32_t receiveBufferSize = 0;
+
+    /**
+     * \~english
+     * Run WebSocket event handling, including request completions, on a shared dispatcher
+     * thread rather than the network service thread which received the event, off by default.
+     *
+     * Worth enabling when completion callbacks do real work, so they do not hold up network
+     * I/O for every other connection served by the same thread.
+     *
+     * \~chinese
+     * 是否在共享的分发线程而不是接收事件的网络服务线程上处理WebSocket事件(包括请求完成回调)，默认关闭。
+     * 完成回调执行较多工作时建议开启，避免阻塞同一线程上其他连接的网络读写
+     */
+    bool dispatchEvents = false;
+
+    /**
+     * \~english
+     * File to keep TLS sessions in so connections made after a restart resume a
+     * session with an abbreviated handshake, sessions are kept in memory for
+     * the process either way. Empty does not persist them.
+     *
+     * \~chinese
+     * 保存TLS会话的文件，使重启后建立的连接可以通过简化握手恢复会话。
+     * 进程内始终在内存中缓存会话，为空时不保存到文件
+     */
+    std::string tlsSessionCacheFile;
 };
 
 /**
@@ -57,6 +57,9 @@ typedef enum
 
     CLOUD_TOKEN_EXPIRED,
 
+    // Send queue is full, the request was not sent and can be retried once it drains
+    CLOUD_WOULD_BLOCK,
+
     CLOUD_LAST // Not used
 } dfx_status_code;
 
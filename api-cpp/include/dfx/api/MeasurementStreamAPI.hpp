@@ -46,6 +46,16 @@ struct DFXCLOUD_EXPORT MeasurementWarning
     int64_t timestampMS;
 };
 
+/**
+ * @brief MeasurementQueueStatus is the depth of the queue of data waiting to be sent.
+ */
+struct DFXCLOUD_EXPORT MeasurementQueueStatus
+{
+    size_t queuedMessages;       ///< Requests, including chunks, not yet written to the connection
+    size_t queuedBytes;          ///< Bytes of the queued requests
+    uint64_t oldestQueuedMillis; ///< How long the oldest queued request has waited, zero when none are
+};
+
 /**
  * @brief Asynchronous callback signature to receive a Measurement ID.
  *
@@ -141,6 +151,18 @@ public:
      */
     virtual CloudStatus sendChunk(const CloudConfig& config, const std::vector<uint8_t>& chunk, bool isLastChunk);
 
+    /**
+     * @brief Obtain the depth of the queue of data waiting to be sent on the measurement connection.
+     *
+     * When CloudConfig::sendQueueMaxBytes or sendQueueMaxMessages limit the queue, sendChunk
+     * returns CLOUD_WOULD_BLOCK if the chunk did not fit and can be retried once the queue drains.
+     * A growing oldestQueuedMillis shows the connection is falling behind before the queue fills.
+     *
+     * @param status the queue depth if the CloudStatus is CLOUD_OK.
+     * @return status of operation, CLOUD_OK on SUCCESS
+     */
+    virtual CloudStatus getQueueStatus(MeasurementQueueStatus& status);
+
     /**
      * @brief Waits for the measurement connection to close ensuring that all results
      * have been properly received.
@@ -263,6 +263,30 @@ static void loadCloudConfigYAMLServiceNode(CloudConfig& config, YAML::Node& node
     if (node["list-limit"]) {
         config.listLimit = node["list-limit"].as<uint16_t>();
     }
+    if (node["send-queue-max-bytes"]) {
+        config.sendQueueMaxBytes = node["send-queue-max-bytes"].as<uint32_t>();
+    }
+    if (node["send-queue-max-messages"]) {
+        config.sendQueueMaxMessages = node["send-queue-max-messages"].as<uint32_t>();
+    }
+    if (node["send-queue-timeout"]) {
+        config.sendQueueTimeoutMillis = node["send-queue-timeout"].as<uint32_t>();
+    }
+    if (node["compression"]) {
+        config.compression = node["compression"].as<bool>();
+    }
+    if (node["compression-window-bits"]) {
+        config.compressionWindowBits = node["compression-window-bits"].as<uint16_t>();
+    }
+    if (node["receive-buffer-size"]) {
+        config.receiveBufferSize = node["receive-buffer-size"].as<uint32_t>();
+    }
+    if (node["dispatch-events"]) {
+        config.dispatchEvents = node["dispatch-events"].as<bool>();
+    }
+    if (node["tls-session-cache"]) {
+        config.tlsSessionCacheFile = node["tls-session-cache"].as<std::string>();
+    }
 }
 #endif // WITH_YAML
 
@@ -309,5 +333,27 @@ std::ostream& operator<<(std::ostream& os, const CloudConfig& config)
     if (config.timeoutMillis != 0) {
         os << "timeout=" << config.timeoutMillis << "\n";
     }
+    if (config.sendQueueMaxBytes != 0) {
+        os << "send-queue-max-bytes=" << config.sendQueueMaxBytes << "\n";
+    }
+    if (config.sendQueueMaxMessages != 0) {
+        os << "send-queue-max-messages=" << config.sendQueueMaxMessages << "\n";
+    }
+    if (config.sendQueueTimeoutMillis != 0) {
+        os << "send-queue-timeout=" << config.sendQueueTimeoutMillis << "\n";
+    }
+    if (config.compression) {
+        os << "compression=" << config.compression << "\n";
+        os << "compression-window-bits=" << static_cast<int>(config.compressionWindowBits) << "\n";
+    }
+    if (config.receiveBufferSize != 0) {
+        os << "receive-buffer-size=" << config.receiveBufferSize << "\n";
+    }
+    if (config.dispatchEvents) {
+        os << "dispatch-events=" << config.dispatchEvents << "\n";
+    }
+    if (!config.tlsSessionCacheFile.empty()) {
+        os << "tls-session-cache=" << config.tlsSessionCacheFile << "\n";
+    }
     return os;
 }
@@ -67,6 +67,8 @@ std::string dfx::api::ToString(dfx_status_code code)
             return "CLOUD_USER_NOT_AUTHORIZED";
         case CLOUD_TOKEN_EXPIRED:
             return "CLOUD_TOKEN_EXPIRED";
+        case CLOUD_WOULD_BLOCK:
+            return "CLOUD_WOULD_BLOCK";
         default:
             return "CloudStatus(" + std::to_string(code) + ")";
     }
@@ -32,6 +32,11 @@ CloudStatus MeasurementStreamAPI::sendChunk(const CloudConfig& config,
     return CloudStatus(CLOUD_UNIMPLEMENTED_FEATURE);
 }
 
+CloudStatus MeasurementStreamAPI::getQueueStatus(MeasurementQueueStatus& status)
+{
+    return CloudStatus(CLOUD_UNIMPLEMENTED_FEATURE);
+}
+
 CloudStatus MeasurementStreamAPI::cancel(const CloudConfig& config)
 {
     return CloudStatus(CLOUD_UNIMPLEMENTED_FEATURE);
@@ -0,0 +1,39 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_API_UTILS_DEQUANTIZE_H
+#define DFX_API_UTILS_DEQUANTIZE_H
+
+#include "dfx/api/CloudAPI_Export.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace dfx::api::utils
+{
+
+/**
+ * Writes count values of data divided by multiplier to output, how the stream decoders turn the
+ * quantized channel data of a result back into the signal values.
+ *
+ * Uses AVX or SSE2 on x86 (chosen at runtime) and NEON on ARM64, falling back to a plain loop. Every
+ * path divides, rather than multiplying by the reciprocal, so the values are exactly what
+ * static_cast<float>(value) / multiplier gives.
+ */
+DFXCLOUD_EXPORT void dequantize(const int32_t* data, size_t count, float multiplier, float* output);
+
+// "avx", "sse2", "neon" or "scalar", whichever dequantize() uses on this machine
+DFXCLOUD_EXPORT const char* getDequantizeKernelName();
+
+/**
+ * Runs dequantize() with the named kernel rather than the one chosen for this machine, so tests can
+ * check every kernel against the scalar one. Returns false without writing output if the kernel is
+ * not built in or this machine does not support it.
+ */
+DFXCLOUD_EXPORT bool dequantizeWithKernel(
+    const char* kernelName, const int32_t* data, size_t count, float multiplier, float* output);
+
+} // namespace dfx::api::utils
+
+#endif // DFX_API_UTILS_DEQUANTIZE_H
@@ -0,0 +1,57 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_API_UTILS_JSON_PARSER_H
+#define DFX_API_UTILS_JSON_PARSER_H
+
+#include "dfx/api/CloudAPI_Export.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dfx::api::utils
+{
+
+/**
+ * Parses size bytes of JSON at data into json for the transports, reading straight from the received
+ * bytes without first copying them into a std::string. Returns false and leaves json discarded, as
+ * nlohmann::json::parse() does when not allowed exceptions, if it is not valid JSON.
+ */
+DFXCLOUD_EXPORT bool parseJson(const char* data, size_t size, nlohmann::json& json);
+
+/**
+ * The fields of a measurement stream result which the JSON WebSocket transport reads.
+ */
+struct JsonStreamResult
+{
+    std::string errorJson;         // The "Error" object as JSON text, empty when there is none
+    std::string id;                // "ID", empty when there is none
+    std::string measurementDataID; // "MeasurementDataID", empty when there is none
+    int64_t multiplier = 1;        // "Multiplier", 1 when there is none
+    std::vector<std::pair<std::string, std::vector<int32_t>>> channels; // Each of "Channels" and its "Data"
+};
+
+/**
+ * Reads the fields of a measurement stream result from size bytes of JSON at data, skipping over the
+ * rest of the message rather than building a document of it. Returns false if it is not valid JSON
+ * or a field read does not have the expected type.
+ *
+ * When built WITH_SIMDJSON the fields are read by the simdjson On-Demand parser, reusing a parser per
+ * thread. It reads past the end of the text so when fewer than 64 bytes of capacity follow data the
+ * text is first copied, pass the capacity of the buffer holding it from data onwards to avoid that.
+ * Otherwise the message is parsed by nlohmann::json and the fields taken from the document.
+ */
+DFXCLOUD_EXPORT bool parseStreamResult(const char* data, size_t size, size_t capacity, JsonStreamResult& result);
+
+// "simdjson" or "nlohmann", whichever parseStreamResult() uses
+DFXCLOUD_EXPORT const char* getJsonParserName();
+
+} // namespace dfx::api::utils
+
+#endif // DFX_API_UTILS_JSON_PARSER_H
@@ -0,0 +1,164 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_API_UTILS_REQUEST_SLOT_TABLE_H
+#define DFX_API_UTILS_REQUEST_SLOT_TABLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace dfx::api::utils
+{
+
+/**
+ * Every WebSocket request starts with a 4 digit action ID followed by a 10 digit request ID, which
+ * the response echoes back. The request ID repeats the action ID and adds a 6 digit sequence number
+ * to tell requests apart.
+ */
+constexpr size_t REQUEST_ID_LENGTH = 10;
+constexpr size_t REQUEST_HEADER_LENGTH = 4 + REQUEST_ID_LENGTH;
+constexpr uint32_t MAX_REQUEST_SEQUENCE = 999999;
+
+using RequestHeader = std::array<char, REQUEST_HEADER_LENGTH>;
+
+namespace detail
+{
+inline void formatDigits(char* text, size_t digits, uint32_t value)
+{
+    for (size_t index = digits; index > 0; index--) {
+        text[index - 1] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    }
+}
+
+inline bool parseDigits(const char* text, size_t digits, uint32_t& value)
+{
+    value = 0;
+    for (size_t index = 0; index < digits; index++) {
+        if (text[index] < '0' || text[index] > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<uint32_t>(text[index] - '0');
+    }
+    return true;
+}
+} // namespace detail
+
+inline RequestHeader formatRequestHeader(uint32_t actionID, uint32_t sequence)
+{
+    RequestHeader header;
+    detail::formatDigits(header.data(), 4, actionID);
+    detail::formatDigits(header.data() + 4, 4, actionID);
+    detail::formatDigits(header.data() + 8, 6, sequence);
+    return header;
+}
+
+// The action ID and sequence of a response's request ID, false if it is not one (like a STRM stream ID)
+inline bool parseRequestID(const char* requestID, uint32_t& actionID, uint32_t& sequence)
+{
+    return detail::parseDigits(requestID, 4, actionID) && detail::parseDigits(requestID + 4, 6, sequence);
+}
+
+/**
+ * RequestSlotTable tracks the requests waiting on a response by their sequence number. It is a
+ * fixed number of slots allocated up front, a sequence lives in the slot sequence % capacity, so
+ * acquiring, finding and releasing a request is O(1) and allocates nothing.
+ *
+ * Sequences run from 1 to MAX_REQUEST_SEQUENCE and wrap back to 1, any whose slot is still taken
+ * by an outstanding request are skipped. As each slot remembers the sequence it holds, a response
+ * to a request which has been released (or a duplicated one) is never matched to a later request
+ * sharing the slot.
+ *
+ * Values stay in their slot and are reused, the caller resets what it needs on acquire(). It is
+ * not thread safe, the transports use it under their own mutex.
+ */
+template <typename T>
+class RequestSlotTable
+{
+public:
+    static const size_t DEFAULT_CAPACITY = 1024;
+
+    explicit RequestSlotTable(size_t capacity = DEFAULT_CAPACITY)
+        : capacity(capacity), slots(std::make_unique<Slot[]>(capacity)), lastSequence(0), inUse(0)
+    {
+    }
+
+    RequestSlotTable(const RequestSlotTable&) = delete;
+    RequestSlotTable& operator=(const RequestSlotTable&) = delete;
+
+    // Claims the slot for the next free sequence and returns the sequence, 0 when every slot is taken
+    uint32_t acquire()
+    {
+        if (inUse == capacity) {
+            return 0;
+        }
+
+        // Wrapping may skip a few slots, going around twice is sure to reach a free one
+        for (size_t attempt = 0; attempt < 2 * capacity; attempt++) {
+            lastSequence = lastSequence >= MAX_REQUEST_SEQUENCE ? 1 : lastSequence + 1;
+            auto& slot = slots[lastSequence % capacity];
+            if (slot.sequence == 0) {
+                slot.sequence = lastSequence;
+                inUse++;
+                return lastSequence;
+            }
+        }
+        return 0;
+    }
+
+    // The value of an acquired sequence, nullptr if it was released or never acquired
+    T* find(uint32_t sequence)
+    {
+        if (sequence == 0 || sequence > MAX_REQUEST_SEQUENCE) {
+            return nullptr;
+        }
+        auto& slot = slots[sequence % capacity];
+        return slot.sequence == sequence ? &slot.value : nullptr;
+    }
+
+    // Frees the slot of the sequence, false if it was not acquired
+    bool release(uint32_t sequence)
+    {
+        if (find(sequence) == nullptr) {
+            return false;
+        }
+        slots[sequence % capacity].sequence = 0;
+        inUse--;
+        return true;
+    }
+
+    // Calls function(sequence, value) for every acquired sequence
+    template <typename Function>
+    void forEach(Function function)
+    {
+        for (size_t index = 0; index < capacity && inUse > 0; index++) {
+            if (slots[index].sequence != 0) {
+                function(slots[index].sequence, slots[index].value);
+            }
+        }
+    }
+
+    size_t size() const
+    {
+        return inUse;
+    }
+
+private:
+    struct Slot
+    {
+        uint32_t sequence = 0; // 0 when free
+        T value;
+    };
+
+    size_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    uint32_t lastSequence;
+    size_t inUse;
+};
+
+} // namespace dfx::api::utils
+
+#endif // DFX_API_UTILS_REQUEST_SLOT_TABLE_H
@@ -0,0 +1,108 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_API_UTILS_TLS_SESSION_CACHE_H
+#define DFX_API_UTILS_TLS_SESSION_CACHE_H
+
+#include "dfx/api/CloudAPI_Export.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+
+struct ssl_st;         // OpenSSL SSL
+struct ssl_session_st; // OpenSSL SSL_SESSION
+
+namespace dfx::api::utils
+{
+
+struct TLSSessionStats
+{
+    uint64_t resumed = 0;  // Handshakes which resumed a cached session
+    uint64_t full = 0;     // Handshakes which negotiated a new session
+    uint64_t sessions = 0; // Sessions currently cached
+};
+
+/**
+ * TLSSessionCache keeps the TLS sessions servers hand out so later connections to the same
+ * server resume them with an abbreviated handshake instead of a full one, which saves round
+ * trips on high latency links.
+ *
+ * It works on any OpenSSL SSL_CTX used for client connections, install() hooks the context so
+ * every handshake made with it offers the cached session for the server and stores the one it
+ * receives. Sessions are kept per scope as well as per server, a session negotiated under a lax
+ * verification policy or a different root CA is never offered to a context with a stricter one.
+ * The WebSocket and REST transports install it on their contexts with scopes of their own, so
+ * each resumes its own sessions from one cache for the process. Sessions may optionally be
+ * persisted to a file across restarts.
+ */
+class DFXCLOUD_EXPORT TLSSessionCache
+{
+public:
+    /**
+     * The process wide cache used by the transports.
+     */
+    static TLSSessionCache& getShared();
+
+    TLSSessionCache();
+
+    ~TLSSessionCache();
+
+    TLSSessionCache(const TLSSessionCache&) = delete;
+    TLSSessionCache& operator=(const TLSSessionCache&) = delete;
+
+    /**
+     * Hooks an OpenSSL SSL_CTX (passed as void* to keep OpenSSL out of this header) so its
+     * client handshakes resume and store sessions through this cache. Only sessions stored under
+     * the same scope are resumed, see makeScope(). Any new session or info callback already on the
+     * context keeps being called.
+     */
+    void install(void* sslContext, const std::string& scope);
+
+    /**
+     * A scope for install() from the context's verification policy (any name which differs
+     * between policies) and the PEM root CA it trusts, empty for the system trust store.
+     * Transports whose connections have no socket for the cache to read the port from should
+     * also append the port.
+     */
+    static std::string makeScope(const std::string& policy, const std::string& rootCA);
+
+    /**
+     * Loads any sessions saved in filePath and saves the cache there from then on when save() is
+     * called or the cache is destroyed. Loading the same path again does nothing. Returns false if
+     * an existing file could not be read.
+     */
+    bool setFilePath(const std::string& filePath);
+
+    // Writes the cached sessions to the file path if one was set
+    bool save();
+
+    TLSSessionStats getStats();
+
+private:
+    static int newSessionCallback(struct ssl_st* ssl, struct ssl_session_st* session);
+    static void infoCallback(const struct ssl_st* ssl, int where, int ret);
+
+    // The scope and the server a connection is for, its SNI host name or peer address and the port
+    static std::string getSessionKey(const struct ssl_st* ssl, const std::string& scope);
+
+    // Takes the reference to session
+    void store(const std::string& key, struct ssl_session_st* session);
+
+    // Adds a reference for the caller, nullptr if there is no usable session for the key
+    struct ssl_session_st* find(const std::string& key);
+
+    std::mutex mutex; // Protect - sessions, filePath
+    std::map<std::string, struct ssl_session_st*> sessions;
+    std::string filePath;
+
+    std::atomic<uint64_t> resumed;
+    std::atomic<uint64_t> full;
+};
+
+} // namespace dfx::api::utils
+
+#endif // DFX_API_UTILS_TLS_SESSION_CACHE_H
@@ -0,0 +1,76 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_API_UTILS_TIMER_WHEEL_H
+#define DFX_API_UTILS_TIMER_WHEEL_H
+
+#include "dfx/api/CloudAPI_Export.hpp"
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace dfx::api::utils
+{
+
+/**
+ * TimerWheel is a hashed timer wheel holding the deadlines of the requests waiting on a response, so
+ * a transport needs a single thread waiting on the earliest deadline rather than a timed wait in every
+ * thread which sent a request.
+ *
+ * Time is cut into ticks and a deadline is hashed into the bucket of the tick it falls in, wrapping
+ * around the wheel. Scheduling and cancelling only touch that one bucket, and expiring visits the
+ * buckets of the ticks which have gone by. Deadlines are rounded up to a whole tick, so a timer never
+ * fires early and at most one tick late.
+ *
+ * Timers are identified by the request sequence and the deadline they were scheduled with. It is not
+ * thread safe, the transports use it under their own mutex.
+ */
+class DFXCLOUD_EXPORT TimerWheel
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    // Spans a little over 10 seconds, the default CloudConfig::timeoutMillis, in one turn of the wheel
+    static constexpr std::chrono::milliseconds DEFAULT_TICK = std::chrono::milliseconds(10);
+    static const size_t DEFAULT_BUCKETS = 1024;
+
+    explicit TimerWheel(std::chrono::milliseconds tick = DEFAULT_TICK, size_t buckets = DEFAULT_BUCKETS);
+
+    void schedule(uint32_t id, Clock::time_point deadline);
+
+    // Removes the timer before it expires, false if there was none (it may have expired already)
+    bool cancel(uint32_t id, Clock::time_point deadline);
+
+    // Removes every timer whose deadline has passed by now and adds its id to expired
+    void expire(Clock::time_point now, std::vector<uint32_t>& expired);
+
+    // When the next timer expires, Clock::time_point::max() if there are none
+    Clock::time_point nextExpiry() const;
+
+    void clear();
+
+    size_t size() const;
+
+private:
+    struct Timer
+    {
+        uint32_t id;
+        uint64_t tick;
+    };
+
+    uint64_t getTick(Clock::time_point deadline) const;
+    std::vector<Timer>& getBucket(uint64_t tick);
+
+    Clock::time_point origin;
+    Clock::duration tickDuration;
+    std::vector<std::vector<Timer>> buckets;
+    uint64_t currentTick; // Every timer due at or before this tick has expired
+    size_t count;
+};
+
+} // namespace dfx::api::utils
+
+#endif // DFX_API_UTILS_TIMER_WHEEL_H
@@ -0,0 +1,153 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/Dequantize.hpp"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define DFX_DEQUANTIZE_X86 // SSE2 is part of x86-64, AVX has to be checked for
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define DFX_DEQUANTIZE_NEON // NEON is part of ARMv8-A
+#include <arm_neon.h>
+#endif
+
+#include <cstring>
+
+namespace
+{
+
+using Kernel = void (*)(const int32_t* data, size_t count, float multiplier, float* output);
+
+struct KernelChoice
+{
+    Kernel kernel;
+    const char* name;
+};
+
+void dequantizeScalar(const int32_t* data, size_t count, float multiplier, float* output)
+{
+    for (size_t index = 0; index < count; index++) {
+        output[index] = static_cast<float>(data[index]) / multiplier;
+    }
+}
+
+#ifdef DFX_DEQUANTIZE_X86
+void dequantizeSSE2(const int32_t* data, size_t count, float multiplier, float* output)
+{
+    const __m128 divisor = _mm_set1_ps(multiplier);
+    size_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+        __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + index));
+        _mm_storeu_ps(output + index, _mm_div_ps(_mm_cvtepi32_ps(values), divisor));
+    }
+    dequantizeScalar(data + index, count - index, multiplier, output + index);
+}
+
+#if defined(__GNUC__) || defined(__clang__)
+__attribute__((target("avx")))
+#endif
+void dequantizeAVX(const int32_t* data, size_t count, float multiplier, float* output)
+{
+    const __m256 divisor = _mm256_set1_ps(multiplier);
+    size_t index = 0;
+    for (; index + 8 <= count; index += 8) {
+        __m256i values = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + index));
+        _mm256_storeu_ps(output + index, _mm256_div_ps(_mm256_cvtepi32_ps(values), divisor));
+    }
+    dequantizeSSE2(data + index, count - index, multiplier, output + index);
+}
+
+bool hasAVX()
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_cpu_supports("avx") != 0; // Includes the OS saving the AVX registers
+#elif defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    const bool osSavesState = (info[2] & (1 << 27)) != 0;
+    const bool cpuHasAVX = (info[2] & (1 << 28)) != 0;
+    return osSavesState && cpuHasAVX && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    return false;
+#endif
+}
+#endif
+
+#ifdef DFX_DEQUANTIZE_NEON
+void dequantizeNEON(const int32_t* data, size_t count, float multiplier, float* output)
+{
+    const float32x4_t divisor = vdupq_n_f32(multiplier);
+    size_t index = 0;
+    for (; index + 4 <= count; index += 4) {
+        vst1q_f32(output + index, vdivq_f32(vcvtq_f32_s32(vld1q_s32(data + index)), divisor));
+    }
+    dequantizeScalar(data + index, count - index, multiplier, output + index);
+}
+#endif
+
+KernelChoice chooseKernel()
+{
+#if defined(DFX_DEQUANTIZE_X86)
+    if (hasAVX()) {
+        return {dequantizeAVX, "avx"};
+    }
+    return {dequantizeSSE2, "sse2"};
+#elif defined(DFX_DEQUANTIZE_NEON)
+    return {dequantizeNEON, "neon"};
+#else
+    return {dequantizeScalar, "scalar"};
+#endif
+}
+
+// The named kernel if this machine can run it, nullptr otherwise
+Kernel findKernel(const char* name)
+{
+    if (strcmp(name, "scalar") == 0) {
+        return dequantizeScalar;
+    }
+#if defined(DFX_DEQUANTIZE_X86)
+    if (strcmp(name, "sse2") == 0) {
+        return dequantizeSSE2;
+    }
+    if (strcmp(name, "avx") == 0 && hasAVX()) {
+        return dequantizeAVX;
+    }
+#elif defined(DFX_DEQUANTIZE_NEON)
+    if (strcmp(name, "neon") == 0) {
+        return dequantizeNEON;
+    }
+#endif
+    return nullptr;
+}
+
+const KernelChoice& getKernel()
+{
+    static const KernelChoice choice = chooseKernel();
+    return choice;
+}
+
+} // namespace
+
+void dfx::api::utils::dequantize(const int32_t* data, size_t count, float multiplier, float* output)
+{
+    getKernel().kernel(data, count, multiplier, output);
+}
+
+const char* dfx::api::utils::getDequantizeKernelName()
+{
+    return getKernel().name;
+}
+
+bool dfx::api::utils::dequantizeWithKernel(
+    const char* kernelName, const int32_t* data, size_t count, float multiplier, float* output)
+{
+    auto kernel = findKernel(kernelName);
+    if (kernel == nullptr) {
+        return false;
+    }
+    kernel(data, count, multiplier, output);
+    return true;
+}
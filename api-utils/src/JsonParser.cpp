@@ -0,0 +1,205 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/JsonParser.hpp"
+
+#ifdef WITH_SIMDJSON
+#include "simdjson.h"
+
+#include <string_view>
+#endif
+
+using dfx::api::utils::JsonStreamResult;
+
+namespace
+{
+
+bool parseNlohmann(const char* data, size_t size, nlohmann::json& json)
+{
+    const bool allowExceptions = false;
+    json = nlohmann::json::parse(data, data + size, nullptr, allowExceptions);
+    return !json.is_discarded();
+}
+
+#ifdef WITH_SIMDJSON
+// Converts any JSON number as nlohmann::json's get<int64_t>() does, so a float is truncated rather than rejected
+template <typename Value>
+bool readInteger(Value&& value, int64_t& integer)
+{
+    simdjson::ondemand::number number;
+    if (std::forward<Value>(value).get_number().get(number) != simdjson::SUCCESS) {
+        return false;
+    }
+    switch (number.get_number_type()) {
+        case simdjson::ondemand::number_type::signed_integer:
+            integer = number.get_int64();
+            return true;
+        case simdjson::ondemand::number_type::unsigned_integer:
+            integer = static_cast<int64_t>(number.get_uint64());
+            return true;
+        case simdjson::ondemand::number_type::floating_point_number:
+            integer = static_cast<int64_t>(number.get_double());
+            return true;
+        default:
+            return false; // Too big for any of them
+    }
+}
+
+bool readChannels(simdjson::ondemand::value channels, JsonStreamResult& result)
+{
+    simdjson::ondemand::object object;
+    if (channels.get_object().get(object) != simdjson::SUCCESS) {
+        return false;
+    }
+    for (auto channelField : object) {
+        simdjson::ondemand::field channel;
+        std::string_view name;
+        simdjson::ondemand::object signal;
+        if (std::move(channelField).get(channel) != simdjson::SUCCESS ||
+            channel.unescaped_key().get(name) != simdjson::SUCCESS ||
+            channel.value().get_object().get(signal) != simdjson::SUCCESS) {
+            return false;
+        }
+
+        result.channels.emplace_back(std::string(name), std::vector<int32_t>());
+        auto& data = result.channels.back().second;
+        for (auto signalField : signal) {
+            simdjson::ondemand::field field;
+            std::string_view key;
+            if (std::move(signalField).get(field) != simdjson::SUCCESS ||
+                field.unescaped_key().get(key) != simdjson::SUCCESS) {
+                return false;
+            }
+            if (key != "Data") {
+                continue; // Skipped without being parsed
+            }
+
+            simdjson::ondemand::array values;
+            if (field.value().get_array().get(values) != simdjson::SUCCESS) {
+                return false;
+            }
+            data.clear(); // Last of a duplicated key wins, as with nlohmann
+            for (auto element : values) {
+                int64_t value;
+                if (!readInteger(element, value)) {
+                    return false;
+                }
+                data.push_back(static_cast<int32_t>(value));
+            }
+        }
+    }
+    return true;
+}
+
+bool readStreamResult(simdjson::ondemand::document& document, JsonStreamResult& result)
+{
+    simdjson::ondemand::object object;
+    if (document.get_object().get(object) != simdjson::SUCCESS) {
+        return false;
+    }
+    for (auto resultField : object) {
+        simdjson::ondemand::field field;
+        std::string_view key;
+        if (std::move(resultField).get(field) != simdjson::SUCCESS ||
+            field.unescaped_key().get(key) != simdjson::SUCCESS) {
+            return false;
+        }
+
+        std::string_view text;
+        bool ok = true;
+        if (key == "Error") {
+            ok = field.value().raw_json().get(text) == simdjson::SUCCESS;
+            result.errorJson = text;
+        } else if (key == "ID") {
+            ok = field.value().get_string().get(text) == simdjson::SUCCESS;
+            result.id = text;
+        } else if (key == "MeasurementDataID") {
+            ok = field.value().get_string().get(text) == simdjson::SUCCESS;
+            result.measurementDataID = text;
+        } else if (key == "Multiplier") {
+            ok = readInteger(field.value(), result.multiplier);
+        } else if (key == "Channels") {
+            result.channels.clear();
+            ok = readChannels(field.value(), result);
+        }
+        if (!ok) {
+            return false;
+        }
+    }
+    return document.at_end();
+}
+#endif
+
+} // namespace
+
+bool dfx::api::utils::parseJson(const char* data, size_t size, nlohmann::json& json)
+{
+    return parseNlohmann(data, size, json);
+}
+
+bool dfx::api::utils::parseStreamResult(const char* data, size_t size, size_t capacity, JsonStreamResult& result)
+{
+    result = JsonStreamResult();
+
+#ifdef WITH_SIMDJSON
+    // The parser keeps its buffers between documents, one per thread as transports parse on several
+    thread_local simdjson::ondemand::parser parser;
+    thread_local simdjson::padded_string copy;
+
+    simdjson::padded_string_view text(data, size, capacity);
+    if (capacity < size + simdjson::SIMDJSON_PADDING) {
+        copy = simdjson::padded_string(data, size);
+        text = copy;
+    }
+
+    simdjson::ondemand::document document;
+    return parser.iterate(text).get(document) == simdjson::SUCCESS && readStreamResult(document, result);
+#else
+    nlohmann::json json;
+    if (!parseNlohmann(data, size, json) || !json.is_object()) {
+        return false;
+    }
+
+    try {
+        if (json.contains("Error")) {
+            result.errorJson = json["Error"].dump();
+        }
+        if (json.contains("ID")) {
+            result.id = json["ID"].get<std::string>();
+        }
+        if (json.contains("MeasurementDataID")) {
+            result.measurementDataID = json["MeasurementDataID"].get<std::string>();
+        }
+        if (json.contains("Multiplier")) {
+            result.multiplier = json["Multiplier"].get<int64_t>();
+        }
+        if (json.contains("Channels")) {
+            if (!json["Channels"].is_object()) {
+                return false;
+            }
+            for (const auto& channel : json["Channels"].items()) {
+                result.channels.emplace_back(channel.key(), std::vector<int32_t>());
+                const auto& signal = channel.value();
+                if (!signal.is_object()) {
+                    return false;
+                }
+                if (signal.contains("Data")) {
+                    result.channels.back().second = signal["Data"].get<std::vector<int32_t>>();
+                }
+            }
+        }
+    } catch (const nlohmann::json::exception&) {
+        return false; // A field did not have the expected type
+    }
+    return true;
+#endif
+}
+
+const char* dfx::api::utils::getJsonParserName()
+{
+#ifdef WITH_SIMDJSON
+    return "simdjson";
+#else
+    return "nlohmann";
+#endif
+}
@@ -0,0 +1,337 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/TLSSessionCache.hpp"
+
+#include <openssl/ssl.h>
+
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <vector>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+using dfx::api::utils::TLSSessionCache;
+using dfx::api::utils::TLSSessionStats;
+
+namespace
+{
+
+// What install() hooked into an SSL_CTX, owned by the context through its ex_data
+struct ContextHooks
+{
+    TLSSessionCache* cache = nullptr;
+    std::string scope;
+    int (*previousNewSession)(SSL*, SSL_SESSION*) = nullptr;
+    void (*previousInfo)(const SSL*, int, int) = nullptr;
+};
+
+void freeContextHooks(
+    void* /*parent*/, void* hooks, CRYPTO_EX_DATA* /*data*/, int /*index*/, long /*argl*/, void* /*argp*/)
+{
+    delete static_cast<ContextHooks*>(hooks);
+}
+
+// Where install() leaves its hooks on the SSL_CTX and the flag marking a connection as counted on the SSL
+int contextIndex()
+{
+    static int index = SSL_CTX_get_ex_new_index(0, nullptr, nullptr, nullptr, &freeContextHooks);
+    return index;
+}
+
+int connectionIndex()
+{
+    static int index = SSL_get_ex_new_index(0, nullptr, nullptr, nullptr, nullptr);
+    return index;
+}
+
+ContextHooks* getContextHooks(const SSL* ssl)
+{
+    return static_cast<ContextHooks*>(SSL_CTX_get_ex_data(SSL_get_SSL_CTX(ssl), contextIndex()));
+}
+
+bool isUsable(SSL_SESSION* session)
+{
+    auto expires = static_cast<time_t>(SSL_SESSION_get_time(session) + SSL_SESSION_get_timeout(session));
+    return SSL_SESSION_is_resumable(session) == 1 && expires > time(nullptr);
+}
+
+void writeLength(std::ofstream& file, uint32_t length)
+{
+    file.write(reinterpret_cast<const char*>(&length), sizeof length);
+}
+
+bool readLength(std::ifstream& file, uint32_t& length)
+{
+    return static_cast<bool>(file.read(reinterpret_cast<char*>(&length), sizeof length)) && length < 64 * 1024;
+}
+
+} // namespace
+
+TLSSessionCache& TLSSessionCache::getShared()
+{
+    // Lives for the remainder of the process, saving to the file (if any) on the way out
+    static TLSSessionCache sharedCache;
+    return sharedCache;
+}
+
+TLSSessionCache::TLSSessionCache() : resumed(0), full(0) {}
+
+TLSSessionCache::~TLSSessionCache()
+{
+    save();
+    for (auto& session : sessions) {
+        SSL_SESSION_free(session.second);
+    }
+}
+
+void TLSSessionCache::install(void* sslContext, const std::string& scope)
+{
+    auto* context = static_cast<SSL_CTX*>(sslContext);
+    if (context == nullptr) {
+        return;
+    }
+
+    // Installing again only changes the scope, the callbacks chained to must stay those from before the first
+    auto* hooks = static_cast<ContextHooks*>(SSL_CTX_get_ex_data(context, contextIndex()));
+    if (hooks == nullptr) {
+        hooks = new ContextHooks();
+        hooks->previousNewSession = SSL_CTX_sess_get_new_cb(context);
+        hooks->previousInfo = SSL_CTX_get_info_callback(context);
+        SSL_CTX_set_ex_data(context, contextIndex(), hooks);
+    }
+    hooks->cache = this;
+    hooks->scope = scope;
+
+    // Sessions are kept here rather than in the context so later contexts with the same scope can resume them
+    SSL_CTX_set_session_cache_mode(context,
+                                   SSL_CTX_get_session_cache_mode(context) | SSL_SESS_CACHE_CLIENT |
+                                       SSL_SESS_CACHE_NO_INTERNAL_STORE);
+    SSL_CTX_sess_set_new_cb(context, &TLSSessionCache::newSessionCallback);
+    SSL_CTX_set_info_callback(context, &TLSSessionCache::infoCallback);
+}
+
+std::string TLSSessionCache::makeScope(const std::string& policy, const std::string& rootCA)
+{
+    // FNV-1a, stable across runs so scopes saved to the file still match after a restart
+    uint64_t hash = 14695981039346656037ULL;
+    for (unsigned char c : rootCA) {
+        hash = (hash ^ c) * 1099511628211ULL;
+    }
+
+    char text[17];
+    snprintf(text, sizeof text, "%016llx", static_cast<unsigned long long>(hash));
+    return policy + "/" + text;
+}
+
+std::string TLSSessionCache::getSessionKey(const SSL* ssl, const std::string& scope)
+{
+    std::string host;
+    const char* serverName = SSL_get_servername(ssl, TLSEXT_NAMETYPE_host_name);
+    if (serverName != nullptr) {
+        host = serverName;
+    }
+
+    // Transports which do their own socket I/O through a BIO (like curl) have no fd, they carry the port
+    // in their scope instead
+    std::string port;
+    int fd = SSL_get_fd(ssl);
+    if (fd >= 0) {
+        sockaddr_storage address{};
+        socklen_t length = sizeof address;
+        if (getpeername(fd, reinterpret_cast<sockaddr*>(&address), &length) == 0) {
+            char text[INET6_ADDRSTRLEN] = {0};
+            if (address.ss_family == AF_INET) {
+                auto* ipv4 = reinterpret_cast<sockaddr_in*>(&address);
+                inet_ntop(AF_INET, &ipv4->sin_addr, text, sizeof text);
+                port = std::to_string(ntohs(ipv4->sin_port));
+            } else if (address.ss_family == AF_INET6) {
+                auto* ipv6 = reinterpret_cast<sockaddr_in6*>(&address);
+                inet_ntop(AF_INET6, &ipv6->sin6_addr, text, sizeof text);
+                port = std::to_string(ntohs(ipv6->sin6_port));
+            }
+            if (host.empty()) {
+                host = text;
+            }
+        }
+    }
+
+    return host.empty() ? std::string() : scope + "|" + host + ":" + port;
+}
+
+int TLSSessionCache::newSessionCallback(SSL* ssl, SSL_SESSION* session)
+{
+    auto* hooks = getContextHooks(ssl);
+    if (hooks == nullptr) {
+        return 0; // Not keeping a reference
+    }
+
+    // A callback already on the context (curl keeps its own cache) still sees the session
+    int previous = hooks->previousNewSession != nullptr ? hooks->previousNewSession(ssl, session) : 0;
+
+    auto key = getSessionKey(ssl, hooks->scope);
+    if (hooks->cache == nullptr || key.empty()) {
+        return previous;
+    }
+    if (previous != 0) {
+        SSL_SESSION_up_ref(session); // It kept the reference we were given, take our own
+    }
+    hooks->cache->store(key, session);
+    return 1;
+}
+
+void TLSSessionCache::infoCallback(const SSL* ssl, int where, int ret)
+{
+    auto* hooks = getContextHooks(ssl);
+    if (hooks == nullptr) {
+        return;
+    }
+    if (hooks->previousInfo != nullptr) {
+        hooks->previousInfo(ssl, where, ret);
+    }
+
+    auto* cache = hooks->cache;
+    if (cache == nullptr || SSL_is_server(ssl) != 0) {
+        return;
+    }
+
+    // TLS 1.3 also signals start and done around post-handshake messages like a NewSessionTicket,
+    // by then the connection has a session and has been counted.
+    auto* connection = const_cast<SSL*>(ssl);
+    if ((where & SSL_CB_HANDSHAKE_START) != 0 && SSL_get_session(ssl) == nullptr) {
+        auto* session = cache->find(getSessionKey(ssl, hooks->scope));
+        if (session != nullptr) {
+            SSL_set_session(connection, session); // Adds its own reference
+            SSL_SESSION_free(session);
+        }
+    } else if ((where & SSL_CB_HANDSHAKE_DONE) != 0 && SSL_get_ex_data(ssl, connectionIndex()) == nullptr) {
+        SSL_set_ex_data(connection, connectionIndex(), cache);
+        if (SSL_session_reused(connection) != 0) {
+            cache->resumed++;
+        } else {
+            cache->full++;
+        }
+    }
+}
+
+void TLSSessionCache::store(const std::string& key, SSL_SESSION* session)
+{
+    std::unique_lock<std::mutex> lock(mutex); // Protect - sessions
+    auto& entry = sessions[key];
+    if (entry != nullptr) {
+        SSL_SESSION_free(entry);
+    }
+    entry = session;
+}
+
+SSL_SESSION* TLSSessionCache::find(const std::string& key)
+{
+    if (key.empty()) {
+        return nullptr;
+    }
+
+    std::unique_lock<std::mutex> lock(mutex); // Protect - sessions
+    auto found = sessions.find(key);
+    if (found == sessions.end()) {
+        return nullptr;
+    }
+    if (!isUsable(found->second)) {
+        SSL_SESSION_free(found->second);
+        sessions.erase(found);
+        return nullptr;
+    }
+    SSL_SESSION_up_ref(found->second);
+    return found->second;
+}
+
+bool TLSSessionCache::setFilePath(const std::string& path)
+{
+    std::unique_lock<std::mutex> lock(mutex); // Protect - sessions, filePath
+    if (path == filePath) {
+        return true;
+    }
+    filePath = path;
+
+    std::ifstream file(filePath, std::ios::binary);
+    if (!file) {
+        return true; // Nothing saved yet
+    }
+
+    // Each record is the key and the DER encoded session, both prefixed by their length
+    uint32_t length;
+    while (readLength(file, length)) {
+        std::string key(length, '\0');
+        std::vector<uint8_t> der;
+        if (!file.read(&key[0], length) || !readLength(file, length)) {
+            return false;
+        }
+        der.resize(length);
+        if (!file.read(reinterpret_cast<char*>(der.data()), length)) {
+            return false;
+        }
+
+        const unsigned char* data = der.data();
+        SSL_SESSION* session = d2i_SSL_SESSION(nullptr, &data, static_cast<long>(der.size()));
+        if (session == nullptr) {
+            continue;
+        }
+        if (!isUsable(session) || sessions.count(key) != 0) {
+            SSL_SESSION_free(session); // Keep what this process negotiated over what was saved
+            continue;
+        }
+        sessions[key] = session;
+    }
+    return file.eof();
+}
+
+bool TLSSessionCache::save()
+{
+    std::unique_lock<std::mutex> lock(mutex); // Protect - sessions, filePath
+    if (filePath.empty()) {
+        return true;
+    }
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return false;
+    }
+
+    std::vector<uint8_t> der;
+    for (auto& session : sessions) {
+        if (!isUsable(session.second)) {
+            continue;
+        }
+        int length = i2d_SSL_SESSION(session.second, nullptr);
+        if (length <= 0) {
+            continue;
+        }
+        der.resize(static_cast<size_t>(length));
+        unsigned char* data = der.data();
+        i2d_SSL_SESSION(session.second, &data);
+
+        writeLength(file, static_cast<uint32_t>(session.first.size()));
+        file.write(session.first.data(), static_cast<std::streamsize>(session.first.size()));
+        writeLength(file, static_cast<uint32_t>(der.size()));
+        file.write(reinterpret_cast<const char*>(der.data()), static_cast<std::streamsize>(der.size()));
+    }
+    return static_cast<bool>(file);
+}
+
+TLSSessionStats TLSSessionCache::getStats()
+{
+    TLSSessionStats stats;
+    stats.resumed = resumed;
+    stats.full = full;
+
+    std::unique_lock<std::mutex> lock(mutex); // Protect - sessions
+    stats.sessions = sessions.size();
+    return stats;
+}
@@ -0,0 +1,109 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/TimerWheel.hpp"
+
+#include <algorithm>
+
+using dfx::api::utils::TimerWheel;
+
+TimerWheel::TimerWheel(std::chrono::milliseconds tick, size_t buckets)
+    : origin(Clock::now()), tickDuration(tick), buckets((std::max)(buckets, size_t(1))), currentTick(0), count(0)
+{
+}
+
+uint64_t TimerWheel::getTick(Clock::time_point deadline) const
+{
+    if (deadline <= origin) {
+        return 0;
+    }
+    // Rounded up so a timer never expires before its deadline
+    auto elapsed = deadline - origin;
+    return static_cast<uint64_t>((elapsed + tickDuration - Clock::duration(1)) / tickDuration);
+}
+
+std::vector<TimerWheel::Timer>& TimerWheel::getBucket(uint64_t tick)
+{
+    return buckets[static_cast<size_t>(tick % buckets.size())];
+}
+
+void TimerWheel::schedule(uint32_t id, Clock::time_point deadline)
+{
+    // A deadline already passed expires on the next call to expire()
+    auto tick = (std::max)(getTick(deadline), currentTick + 1);
+    getBucket(tick).push_back(Timer{id, tick});
+    count++;
+}
+
+bool TimerWheel::cancel(uint32_t id, Clock::time_point deadline)
+{
+    auto tick = (std::max)(getTick(deadline), currentTick + 1);
+    auto& bucket = getBucket(tick);
+    auto iter = std::find_if(
+        bucket.begin(), bucket.end(), [id, tick](const Timer& timer) { return timer.id == id && timer.tick == tick; });
+    if (iter == bucket.end()) {
+        return false;
+    }
+    *iter = bucket.back(); // Order within a bucket does not matter
+    bucket.pop_back();
+    count--;
+    return true;
+}
+
+void TimerWheel::expire(Clock::time_point now, std::vector<uint32_t>& expired)
+{
+    if (now < origin) {
+        return;
+    }
+    auto nowTick = static_cast<uint64_t>((now - origin) / tickDuration);
+    if (nowTick <= currentTick) {
+        return;
+    }
+
+    // Visit the buckets of the ticks gone by, all of them once when a whole turn of the wheel has passed
+    auto ticks = (std::min)(nowTick - currentTick, static_cast<uint64_t>(buckets.size()));
+    for (uint64_t tick = currentTick + 1; tick <= currentTick + ticks && count > 0; tick++) {
+        auto& bucket = getBucket(tick);
+        auto end = std::partition(
+            bucket.begin(), bucket.end(), [nowTick](const Timer& timer) { return timer.tick > nowTick; });
+        for (auto iter = end; iter != bucket.end(); ++iter) {
+            expired.push_back(iter->id);
+        }
+        count -= static_cast<size_t>(bucket.end() - end);
+        bucket.erase(end, bucket.end());
+    }
+    currentTick = nowTick;
+}
+
+TimerWheel::Clock::time_point TimerWheel::nextExpiry() const
+{
+    if (count == 0) {
+        return Clock::time_point::max();
+    }
+
+    // The first bucket holding a timer for this turn of the wheel has the earliest one, failing that
+    // (every timer is a turn or more away) it is the earliest of them all
+    uint64_t earliest = UINT64_MAX;
+    for (uint64_t tick = currentTick + 1; tick <= currentTick + buckets.size(); tick++) {
+        for (const auto& timer : buckets[static_cast<size_t>(tick % buckets.size())]) {
+            earliest = (std::min)(earliest, timer.tick);
+        }
+        if (earliest == tick) {
+            break;
+        }
+    }
+    return origin + tickDuration * static_cast<Clock::rep>(earliest);
+}
+
+void TimerWheel::clear()
+{
+    for (auto& bucket : buckets) {
+        bucket.clear();
+    }
+    count = 0;
+}
+
+size_t TimerWheel::size() const
+{
+    return count;
+}
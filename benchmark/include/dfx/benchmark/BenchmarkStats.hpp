@@ -0,0 +1,58 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_BENCHMARK_STATS_H
+#define DFX_BENCHMARK_STATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+#include <vector>
+
+namespace dfx::benchmark
+{
+
+using Clock = std::chrono::steady_clock;
+
+inline double elapsedMicros(Clock::time_point start, Clock::time_point end = Clock::now())
+{
+    return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+/**
+ * Prints min/median/p99/max/mean of the samples on a single line prefixed by the label.
+ */
+inline void printStats(const char* label, std::vector<double> samples, const char* units = "us")
+{
+    if (samples.empty()) {
+        printf("%-32s no samples\n", label);
+        return;
+    }
+
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&samples](double fraction) {
+        auto index = static_cast<size_t>(fraction * static_cast<double>(samples.size() - 1));
+        return samples[index];
+    };
+    double mean = std::accumulate(samples.begin(), samples.end(), 0.0) / static_cast<double>(samples.size());
+
+    printf("%-32s n=%-6zu min=%10.2f%s  p50=%10.2f%s  p99=%10.2f%s  max=%10.2f%s  mean=%10.2f%s\n",
+           label,
+           samples.size(),
+           samples.front(),
+           units,
+           percentile(0.5),
+           units,
+           percentile(0.99),
+           units,
+           samples.back(),
+           units,
+           mean,
+           units);
+}
+
+} // namespace dfx::benchmark
+
+#endif // DFX_BENCHMARK_STATS_H
@@ -0,0 +1,75 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFX_BENCHMARK_ECHO_SERVER_H
+#define DFX_BENCHMARK_ECHO_SERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <thread>
+#include <vector>
+
+#include <libwebsockets.h>
+
+namespace dfx::benchmark
+{
+
+/**
+ * A plain (ws://) libwebsockets server on an ephemeral loopback port which echoes every
+ * message it receives back to the sender, speaking the same "proto" and "json" protocols
+ * as the DFX servers. Used as a local stand-in so benchmarks measure the client.
+ *
+ * When constructed with deflate it accepts permessage-deflate so compression can be compared.
+ */
+class EchoServer
+{
+public:
+    explicit EchoServer(bool deflate = false);
+
+    ~EchoServer();
+
+    EchoServer(const EchoServer&) = delete;
+    EchoServer& operator=(const EchoServer&) = delete;
+
+    int getPort() const;
+
+    bool isRunning() const;
+
+    // Total message payload bytes received from clients
+    uint64_t getBytesReceived() const;
+
+    // Total bytes read from client connections including framing, 0 where the platform can not tell
+    uint64_t getWireBytesReceived() const;
+
+    static int callback(struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len);
+
+private:
+    struct Session
+    {
+        std::vector<uint8_t> message;
+        std::deque<std::vector<uint8_t>> outgoing;
+        uint64_t wireBytes = 0;
+    };
+
+    // Reads the bytes the connection has received from the kernel and adds any new ones to the total
+    void updateWireBytes(struct lws* wsi, Session& session);
+
+    int handleEvent(struct lws* wsi, enum lws_callback_reasons reason, void* in, size_t len);
+
+    void serviceThreadRunnable();
+
+    struct lws_context* context;
+    int port;
+    std::atomic<bool> stopping;
+    std::atomic<uint64_t> bytesReceived;
+    std::atomic<uint64_t> wireBytesReceived;
+    std::map<struct lws*, Session> sessions; // Only accessed from the service thread
+    std::thread serviceThread;
+};
+
+} // namespace dfx::benchmark
+
+#endif // DFX_BENCHMARK_ECHO_SERVER_H
@@ -0,0 +1,145 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+// Compares the two ways the JSON transport has framed a measurement data request into a send buffer:
+//   - as a nlohmann::json document which is then serialized, as sendChunk() used to
+//   - written directly with the base64 payload encoded in place, as encodeChunkRequest() does
+// reporting the payload bytes copied along the way and the time taken per chunk. Both must produce
+// identical messages.
+//
+// Usage: benchmark-json-chunk [chunks] [payload-bytes]
+
+#include "dfx/benchmark/BenchmarkStats.hpp"
+
+#include "ChunkRequestEncoder.hpp"
+
+#include "dfx/websocket/WebSocketBuffer.hpp"
+
+#include "libbase64.h"
+#include "nlohmann/json.hpp"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dfx::benchmark;
+using dfx::api::websocket::json::encodeChunkRequest;
+using dfx::api::websocket::json::getChunkRequestSize;
+using dfx::websocket::WebSocketSendBuffer;
+
+namespace
+{
+
+const std::string actionID = "0506";
+const std::string requestID = "0506000042";
+const auto header = dfx::api::utils::formatRequestHeader(506, 42); // The same two IDs
+const std::string measurementID = "a4b5c1d2-7e8f-4a0b-9c1d-2e3f4a5b6c7d";
+const uint16_t listLimit = 25;
+const size_t headroom = 16; // Roughly LWS_PRE
+
+// The request as sendChunk() built it before, counting the bytes written at each step
+void encodeDocument(WebSocketSendBuffer& buffer, const std::vector<uint8_t>& chunk, size_t& copied)
+{
+    nlohmann::json request;
+    request["Action"] = "CHUNK::PROCESS";
+
+    std::vector<char> chunkBase64;
+    chunkBase64.resize(chunk.size() * 2);
+    size_t encodedLength = 0;
+    base64_encode(reinterpret_cast<const char*>(chunk.data()), chunk.size(), chunkBase64.data(), &encodedLength, 0);
+    chunkBase64.resize(encodedLength);
+    copied += encodedLength;
+
+    const std::string payload(chunkBase64.begin(), chunkBase64.end());
+    copied += payload.size();
+    request["Payload"] = payload;
+    copied += payload.size();
+
+    nlohmann::json params;
+    params["ID"] = measurementID;
+    params["Limit"] = listLimit;
+    request["Params"] = params;
+
+    auto requestString = to_string(request);
+    copied += requestString.size();
+
+    buffer.clear();
+    buffer.reserve(actionID.size() + requestID.size() + requestString.size());
+    buffer.append(actionID);
+    buffer.append(requestID);
+    buffer.append(requestString);
+    copied += buffer.size();
+}
+
+void encodeDirect(WebSocketSendBuffer& buffer, const std::vector<uint8_t>& chunk, size_t& copied)
+{
+    const char* action = "CHUNK::PROCESS";
+    buffer.clear();
+    buffer.reserve(getChunkRequestSize(header, action, measurementID, chunk.size()));
+    encodeChunkRequest(buffer, header, action, measurementID, listLimit, chunk.data(), chunk.size());
+    copied += buffer.size();
+}
+
+template <typename Encoder>
+std::string run(const char* name, Encoder encoder, const std::vector<std::vector<uint8_t>>& chunks)
+{
+    WebSocketSendBuffer buffer(headroom, std::vector<uint8_t>());
+    size_t copied = 0;
+    size_t payloadBytes = 0;
+    std::vector<double> samples;
+    samples.reserve(chunks.size());
+
+    // Once through first so the buffer has grown to size like a pooled one would have
+    encoder(buffer, chunks.front(), copied);
+    copied = 0;
+
+    for (const auto& chunk : chunks) {
+        auto start = Clock::now();
+        encoder(buffer, chunk, copied);
+        samples.push_back(1000.0 * elapsedMicros(start));
+        payloadBytes += chunk.size();
+    }
+
+    auto count = static_cast<double>(chunks.size());
+    printf("%-32s %10.0f payload bytes/chunk %10.0f bytes copied/chunk (%4.1fx payload)\n",
+           name,
+           static_cast<double>(payloadBytes) / count,
+           static_cast<double>(copied) / count,
+           static_cast<double>(copied) / static_cast<double>(payloadBytes));
+    printStats(name, samples, "ns");
+
+    return std::string(buffer.data(), buffer.data() + buffer.size());
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t chunkCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    size_t payloadSize = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256 * 1024;
+
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<std::vector<uint8_t>> chunks(std::max<size_t>(chunkCount, 1));
+    for (auto& chunk : chunks) {
+        chunk.resize(payloadSize);
+        for (auto& value : chunk) {
+            value = static_cast<uint8_t>(byte(random));
+        }
+    }
+
+    printf("JSON chunk encoding benchmark: %zu chunks, %zu byte payload\n", chunks.size(), payloadSize);
+
+    auto document = run("json document", encodeDocument, chunks);
+    auto direct = run("direct", encodeDirect, chunks);
+    if (document != direct) {
+        fprintf(stderr, "Direct encoding does not match the json document encoding\n");
+        return 1;
+    }
+
+    return 0;
+}
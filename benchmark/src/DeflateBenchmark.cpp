@@ -0,0 +1,218 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+// Compares WebSocket permessage-deflate settings against a local echo server:
+//   - bytes on the wire per chunk, as read by the server from the connection including framing
+//   - CPU per chunk, for the whole process so it includes the echo server (de)compressing as well
+//
+// Chunks are JSON measurement requests carrying a base64 payload like the JSON transport sends.
+//
+// Usage: benchmark-websocket-deflate [chunks] [payload-bytes]
+
+#include "dfx/benchmark/BenchmarkStats.hpp"
+#include "dfx/benchmark/EchoServer.hpp"
+
+#include "dfx/websocket/WebSocketEventLoop.hpp"
+#include "dfx/websocket/WebSocketLibWebSocket.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dfx::benchmark;
+using namespace dfx::websocket;
+
+namespace
+{
+
+struct Connection
+{
+    std::shared_ptr<WebSocketLibWebSocket> socket;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool opened = false;
+    bool failed = false;
+    size_t messages = 0;
+
+    ~Connection()
+    {
+        socket.reset(); // Closes the connection while the members its events use are still around
+    }
+
+    void handleEvent(const WebSocketEvent& event)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        switch (event.type) {
+            case WebSocketEventType::OPEN:
+                opened = true;
+                break;
+            case WebSocketEventType::MESSAGE:
+                messages++;
+                break;
+            case WebSocketEventType::ERROR_EVENT:
+            case WebSocketEventType::CLOSED:
+                failed = true;
+                break;
+            default:
+                break;
+        }
+        cv.notify_all();
+    }
+
+    bool waitOpen()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(10), [this] { return opened || failed; }) && opened;
+    }
+
+    bool waitMessages(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(10), [this, count] { return messages >= count || failed; }) &&
+               messages >= count;
+    }
+};
+
+std::string base64(const std::vector<uint8_t>& data)
+{
+    static const char* alphabet = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    encoded.reserve((data.size() + 2) / 3 * 4);
+    for (size_t index = 0; index < data.size(); index += 3) {
+        uint32_t triple = data[index] << 16;
+        triple |= index + 1 < data.size() ? data[index + 1] << 8 : 0;
+        triple |= index + 2 < data.size() ? data[index + 2] : 0;
+        encoded.push_back(alphabet[(triple >> 18) & 0x3F]);
+        encoded.push_back(alphabet[(triple >> 12) & 0x3F]);
+        encoded.push_back(index + 1 < data.size() ? alphabet[(triple >> 6) & 0x3F] : '=');
+        encoded.push_back(index + 2 < data.size() ? alphabet[triple & 0x3F] : '=');
+    }
+    return encoded;
+}
+
+// A chunk request with a payload of noisy slowly varying samples, roughly what face tracking data looks like
+std::string makeChunk(size_t payloadSize, size_t chunkOrder)
+{
+    std::mt19937 random(static_cast<uint32_t>(chunkOrder));
+    std::normal_distribution<double> noise(0.0, 4.0);
+    std::vector<uint8_t> payload(payloadSize);
+    for (size_t index = 0; index < payloadSize; index++) {
+        auto sample = 128.0 + 60.0 * std::sin(static_cast<double>(index) / 50.0) + noise(random);
+        payload[index] = static_cast<uint8_t>(std::min(255.0, std::max(0.0, sample)));
+    }
+    return R"({"Action":"LAST::PROCESS","ChunkOrder":)" + std::to_string(chunkOrder) +
+           R"(,"StartTime":0,"EndTime":5,"Duration":5,"Payload":")" + base64(payload) + R"("})";
+}
+
+double processCPUMillis()
+{
+    return 1000.0 * static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+bool run(const char* name,
+         const std::shared_ptr<WebSocketEventLoop>& eventLoop,
+         EchoServer& server,
+         const WebSocketCompression& compression,
+         const std::vector<std::string>& chunks)
+{
+    Connection connection;
+    connection.socket = std::make_shared<WebSocketLibWebSocket>(0, nullptr, eventLoop);
+    connection.socket->setCompression(compression);
+    connection.socket->setEventCallback(
+        [](const WebSocketEvent& event, void* userData) { static_cast<Connection*>(userData)->handleEvent(event); },
+        &connection);
+    connection.socket->open("ws://127.0.0.1:" + std::to_string(server.getPort()), "json");
+    if (!connection.waitOpen()) {
+        fprintf(stderr, "Unable to open connection to local echo server\n");
+        return false;
+    }
+
+    // Warm up so the handshake and deflate setup are not part of the measurement
+    connection.socket->sendUTF8(chunks.front());
+    if (!connection.waitMessages(1)) {
+        fprintf(stderr, "Warm up echo did not arrive\n");
+        return false;
+    }
+
+    size_t payloadBytes = 0;
+    auto wireStart = server.getWireBytesReceived();
+    auto cpuStart = processCPUMillis();
+    std::vector<double> roundTrips;
+    roundTrips.reserve(chunks.size());
+    for (size_t index = 0; index < chunks.size(); index++) {
+        auto start = Clock::now();
+        connection.socket->sendUTF8(chunks[index]);
+        if (!connection.waitMessages(index + 2)) {
+            fprintf(stderr, "Echo %zu did not arrive\n", index);
+            return false;
+        }
+        roundTrips.push_back(elapsedMicros(start));
+        payloadBytes += chunks[index].size();
+    }
+    auto cpuMillis = processCPUMillis() - cpuStart;
+    auto wireBytes = server.getWireBytesReceived() - wireStart;
+
+    auto count = static_cast<double>(chunks.size());
+    printf("%-32s %10.0f payload bytes/chunk %10.0f wire bytes/chunk (%5.1f%%) %8.3fms CPU/chunk\n",
+           name,
+           static_cast<double>(payloadBytes) / count,
+           static_cast<double>(wireBytes) / count,
+           payloadBytes > 0 ? 100.0 * static_cast<double>(wireBytes) / static_cast<double>(payloadBytes) : 0.0,
+           cpuMillis / count);
+    printStats(name, roundTrips);
+
+    connection.socket->close();
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t chunkCount = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100;
+    size_t payloadSize = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 256 * 1024;
+
+    EchoServer server(true);
+    if (!server.isRunning()) {
+        fprintf(stderr, "Unable to start local echo server\n");
+        return 1;
+    }
+#ifndef __linux__
+    printf("Wire bytes are only measured on Linux and will read as 0\n");
+#endif
+
+    std::vector<std::string> chunks;
+    chunks.reserve(chunkCount);
+    for (size_t index = 0; index < std::max<size_t>(chunkCount, 1); index++) {
+        chunks.push_back(makeChunk(payloadSize, index));
+    }
+
+    printf("WebSocket deflate benchmark: %zu chunks, %zu byte payload\n", chunks.size(), payloadSize);
+
+    auto eventLoop = std::make_shared<WebSocketEventLoop>(1);
+
+    WebSocketCompression compression;
+    if (!run("uncompressed", eventLoop, server, compression, chunks)) {
+        return 1;
+    }
+
+    compression.enabled = true;
+    if (!run("deflate, 15 window bits", eventLoop, server, compression, chunks)) {
+        return 1;
+    }
+
+    compression.windowBits = 10;
+    if (!run("deflate, 10 window bits", eventLoop, server, compression, chunks)) {
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/benchmark/EchoServer.hpp"
+
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/tcp.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+using dfx::benchmark::EchoServer;
+
+extern "C" {
+static int echo_server_callback(struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len)
+{
+    return EchoServer::callback(wsi, reason, user, in, len);
+}
+}
+
+// NOLINTNEXTLINE(modernize-avoid-c-arrays)  suggests using std::array<>
+static struct lws_protocols echoProtocols[] = {
+    {"proto", ::echo_server_callback, 0, 64 * 1024},
+    {"json", ::echo_server_callback, 0, 64 * 1024},
+    LWS_PROTOCOL_LIST_TERM /* terminator */
+};
+
+// NOLINTNEXTLINE(modernize-avoid-c-arrays)  suggests using std::array<>
+static const struct lws_extension echoExtensions[] = {
+    {"permessage-deflate", lws_extension_callback_pm_deflate, "permessage-deflate"},
+    {nullptr, nullptr, nullptr} /* terminator */
+};
+
+EchoServer::EchoServer(bool deflate)
+    : context(nullptr), port(0), stopping(false), bytesReceived(0), wireBytesReceived(0)
+{
+    struct lws_context_creation_info info
+    {
+    };
+    memset(&info, 0, sizeof info);
+
+    info.port = 0; // Ephemeral, read back from the vhost below
+    info.iface = "127.0.0.1";
+    info.protocols = echoProtocols;
+    info.extensions = deflate ? echoExtensions : nullptr;
+    info.gid = -1;
+    info.uid = -1;
+    info.user = this;
+
+    context = lws_create_context(&info);
+    if (context != nullptr) {
+        // With no explicit vhosts lws creates the "default" one from info and it is the one listening
+        auto* vhost = lws_get_vhost_by_name(context, "default");
+        if (vhost != nullptr) {
+            port = lws_get_vhost_listen_port(vhost);
+        }
+        serviceThread = std::thread(&EchoServer::serviceThreadRunnable, this);
+    }
+}
+
+EchoServer::~EchoServer()
+{
+    stopping = true;
+    if (context != nullptr) {
+        lws_cancel_service(context);
+        if (serviceThread.joinable()) {
+            serviceThread.join();
+        }
+        lws_context_destroy(context);
+    }
+}
+
+int EchoServer::getPort() const
+{
+    return port;
+}
+
+bool EchoServer::isRunning() const
+{
+    return context != nullptr && port > 0;
+}
+
+uint64_t EchoServer::getBytesReceived() const
+{
+    return bytesReceived;
+}
+
+uint64_t EchoServer::getWireBytesReceived() const
+{
+    return wireBytesReceived;
+}
+
+void EchoServer::updateWireBytes(struct lws* wsi, Session& session)
+{
+#ifdef __linux__
+    struct tcp_info info
+    {
+    };
+    socklen_t length = sizeof info;
+    if (getsockopt(lws_get_socket_fd(wsi), IPPROTO_TCP, TCP_INFO, &info, &length) == 0 &&
+        info.tcpi_bytes_received > session.wireBytes) {
+        wireBytesReceived += info.tcpi_bytes_received - session.wireBytes;
+        session.wireBytes = info.tcpi_bytes_received;
+    }
+#endif
+}
+
+int EchoServer::callback(struct lws* wsi, enum lws_callback_reasons reason, void* /*user*/, void* in, size_t len)
+{
+    auto* server = static_cast<EchoServer*>(lws_context_user(lws_get_context(wsi)));
+    if (server == nullptr) {
+        return 0;
+    }
+    return server->handleEvent(wsi, reason, in, len);
+}
+
+int EchoServer::handleEvent(struct lws* wsi, enum lws_callback_reasons reason, void* in, size_t len)
+{
+    switch (reason) {
+        case LWS_CALLBACK_ESTABLISHED: {
+            sessions[wsi] = Session();
+            break;
+        }
+        case LWS_CALLBACK_RECEIVE: {
+            auto& session = sessions[wsi];
+            auto* data = static_cast<uint8_t*>(in);
+            if (lws_is_first_fragment(wsi)) {
+                session.message.assign(LWS_PRE, 0);
+            }
+            session.message.insert(session.message.end(), data, data + len);
+            bytesReceived += len;
+            updateWireBytes(wsi, session);
+
+            if (lws_is_final_fragment(wsi)) {
+                session.outgoing.push_back(std::move(session.message));
+                session.message.clear();
+                lws_callback_on_writable(wsi);
+            }
+            break;
+        }
+        case LWS_CALLBACK_SERVER_WRITEABLE: {
+            auto& session = sessions[wsi];
+            if (!session.outgoing.empty()) {
+                auto& message = session.outgoing.front();
+                lws_write(wsi, message.data() + LWS_PRE, message.size() - LWS_PRE, LWS_WRITE_BINARY);
+                session.outgoing.pop_front();
+                if (!session.outgoing.empty()) {
+                    lws_callback_on_writable(wsi);
+                }
+            }
+            break;
+        }
+        case LWS_CALLBACK_CLOSED: {
+            sessions.erase(wsi);
+            break;
+        }
+        default:
+            break;
+    }
+    return 0;
+}
+
+void EchoServer::serviceThreadRunnable()
+{
+    while (!stopping) {
+        lws_service(context, 0);
+    }
+}
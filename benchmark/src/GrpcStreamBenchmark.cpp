@@ -0,0 +1,329 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+// Measures how concurrent gRPC measurement streams scale with the threads driving their completion
+// queues, against a local stand-in server which answers every chunk with a small result:
+//   - thread per stream, a CompletionQueue and thread of its own for each stream as they used to be
+//   - shared pool, every stream on a CompletionQueuePool of a few poller threads
+// Each stream sends its chunks one at a time, the next once the result for the last has come back,
+// and the chunk round trip, the wall time for all the streams to finish and the CPU used are reported.
+//
+// Usage: benchmark-grpc-stream [streams] [chunks-per-stream] [payload-bytes] [poller-threads]
+
+#include "dfx/benchmark/BenchmarkStats.hpp"
+
+#include "dfx/api/grpc/CompletionQueuePool.hpp"
+
+#include <grpcpp/generic/async_generic_service.h>
+#include <grpcpp/generic/generic_stub.h>
+#include <grpcpp/grpcpp.h>
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace dfx::benchmark;
+using dfx::api::grpc::CompletionQueuePool;
+
+namespace
+{
+
+const char* STREAM_METHOD = "/dfx.measurements.v2.API/Stream";
+const size_t RESULT_SIZE = 512;
+
+::grpc::ByteBuffer makeBuffer(size_t size, char fill)
+{
+    std::string bytes(size, fill);
+    ::grpc::Slice slice(bytes);
+    return ::grpc::ByteBuffer(&slice, 1);
+}
+
+// Stands in for the measurement service, every chunk read is answered with a result
+class ResultReactor : public ::grpc::ServerGenericBidiReactor
+{
+public:
+    ResultReactor() : result(makeBuffer(RESULT_SIZE, 'r'))
+    {
+        StartRead(&chunk);
+    }
+
+    void OnReadDone(bool ok) override
+    {
+        if (!ok) {
+            Finish(::grpc::Status::OK);
+            return;
+        }
+        StartWrite(&result);
+    }
+
+    void OnWriteDone(bool ok) override
+    {
+        if (!ok) {
+            Finish(::grpc::Status::CANCELLED);
+            return;
+        }
+        StartRead(&chunk);
+    }
+
+    void OnDone() override
+    {
+        delete this;
+    }
+
+private:
+    ::grpc::ByteBuffer chunk;
+    ::grpc::ByteBuffer result;
+};
+
+class ResultService : public ::grpc::CallbackGenericService
+{
+public:
+    ::grpc::ServerGenericBidiReactor* CreateReactor(::grpc::GenericCallbackServerContext* context) override
+    {
+        return new ResultReactor();
+    }
+};
+
+// Counts the streams still running so the benchmark can wait on them
+struct Completion
+{
+    std::mutex mutex;
+    std::condition_variable cv;
+    size_t running = 0;
+    size_t failed = 0;
+
+    void finished(bool ok)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        running--;
+        failed += ok ? 0 : 1;
+        cv.notify_all();
+    }
+
+    void wait()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        cv.wait(lock, [this] { return running == 0; });
+    }
+};
+
+// A measurement stream reduced to its traffic, driven by handleEvent() like MeasurementStreamGRPC
+class Stream : public CompletionQueuePool::Handler
+{
+public:
+    Stream(const ::grpc::ByteBuffer& payload, size_t chunks, Completion& completion)
+        : tags{{this, StartDone}, {this, WriteDone}, {this, ReadDone}, {this, WritesDone}, {this, FinishDone}},
+          payload(payload), chunks(chunks), completion(completion)
+    {
+        roundTrips.reserve(chunks);
+    }
+
+    void start(::grpc::GenericStub& stub, CompletionQueuePool& pool)
+    {
+        this->pool = &pool;
+        queue = pool.attach();
+        call = stub.PrepareCall(&context, STREAM_METHOD, queue);
+        call->StartCall(&tags[StartDone]);
+    }
+
+    void handleEvent(int event, bool ok) override
+    {
+        switch (event) {
+            case StartDone:
+                if (!ok) {
+                    call->Finish(&status, &tags[FinishDone]);
+                    return;
+                }
+                sendChunk();
+                call->Read(&result, &tags[ReadDone]);
+                break;
+            case WriteDone:
+                writeDone = true;
+                sendNext();
+                break;
+            case ReadDone:
+                if (!ok) { // The server has finished the stream
+                    call->Finish(&status, &tags[FinishDone]);
+                    return;
+                }
+                roundTrips.push_back(elapsedMicros(sent));
+                answered = true;
+                sendNext();
+                call->Read(&result, &tags[ReadDone]);
+                break;
+            case WritesDone:
+                break;
+            case FinishDone:
+                pool->detach(queue);
+                completion.finished(status.ok() && roundTrips.size() == chunks);
+                break;
+            default:
+                break;
+        }
+    }
+
+    const std::vector<double>& getRoundTrips() const
+    {
+        return roundTrips;
+    }
+
+private:
+    enum Event
+    {
+        StartDone,
+        WriteDone,
+        ReadDone,
+        WritesDone,
+        FinishDone,
+        EventCount
+    };
+
+    void sendChunk()
+    {
+        writeDone = false;
+        answered = false;
+        sentChunks++;
+        sent = Clock::now();
+        call->Write(payload, &tags[WriteDone]);
+    }
+
+    // The next chunk goes once the last is written and answered, after the last chunk we are done writing
+    void sendNext()
+    {
+        if (!writeDone || !answered) {
+            return;
+        }
+        if (sentChunks < chunks) {
+            sendChunk();
+        } else if (!writesDoneSent) {
+            writesDoneSent = true;
+            call->WritesDone(&tags[WritesDone]);
+        }
+    }
+
+    CompletionQueuePool::Tag tags[EventCount];
+    const ::grpc::ByteBuffer& payload;
+    size_t chunks;
+    Completion& completion;
+
+    CompletionQueuePool* pool = nullptr;
+    ::grpc::CompletionQueue* queue = nullptr;
+    ::grpc::ClientContext context;
+    std::unique_ptr<::grpc::GenericClientAsyncReaderWriter> call;
+    ::grpc::ByteBuffer result;
+    ::grpc::Status status;
+
+    size_t sentChunks = 0;
+    bool writeDone = false;
+    bool answered = false;
+    bool writesDoneSent = false;
+    Clock::time_point sent;
+    std::vector<double> roundTrips;
+};
+
+double processCPUMillis()
+{
+    return 1000.0 * static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+// Runs every stream to completion, each on the pool getPool() gives it
+template <typename GetPool>
+void run(const char* label,
+         size_t pollerThreads,
+         const std::shared_ptr<::grpc::Channel>& channel,
+         size_t streams,
+         size_t chunks,
+         const ::grpc::ByteBuffer& payload,
+         GetPool getPool)
+{
+    ::grpc::GenericStub stub(channel);
+    Completion completion;
+    completion.running = streams;
+
+    std::vector<std::unique_ptr<Stream>> running;
+    running.reserve(streams);
+    for (size_t index = 0; index < streams; index++) {
+        running.push_back(std::make_unique<Stream>(payload, chunks, completion));
+    }
+
+    auto cpuStart = processCPUMillis();
+    auto start = Clock::now();
+    for (size_t index = 0; index < streams; index++) {
+        running[index]->start(stub, getPool(index));
+    }
+    completion.wait();
+    auto wallMillis = elapsedMicros(start) / 1000.0;
+    auto cpuMillis = processCPUMillis() - cpuStart;
+
+    std::vector<double> roundTrips;
+    roundTrips.reserve(streams * chunks);
+    for (const auto& stream : running) {
+        roundTrips.insert(roundTrips.end(), stream->getRoundTrips().begin(), stream->getRoundTrips().end());
+    }
+
+    printf("%-32s %zu poller threads, %zu streams (%zu failed) in %.1fms, %.0f chunks/s, %.1fms CPU\n",
+           label,
+           pollerThreads,
+           streams,
+           completion.failed,
+           wallMillis,
+           1000.0 * static_cast<double>(roundTrips.size()) / wallMillis,
+           cpuMillis);
+    printStats(label, roundTrips);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t streams = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 500;
+    size_t chunks = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 20;
+    size_t payloadSize = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 16 * 1024;
+    auto pollerThreads = static_cast<uint16_t>(argc > 4 ? std::strtoul(argv[4], nullptr, 10)
+                                                        : CompletionQueuePool::DEFAULT_POLLER_THREADS);
+
+    ResultService service;
+    int port = 0;
+    ::grpc::ServerBuilder builder;
+    builder.AddListeningPort("127.0.0.1:0", ::grpc::InsecureServerCredentials(), &port);
+    builder.RegisterCallbackGenericService(&service);
+    auto server = builder.BuildAndStart();
+    if (server == nullptr || port == 0) {
+        fprintf(stderr, "Unable to start local stand-in server\n");
+        return 1;
+    }
+
+    // One channel shared by every stream, as CloudGRPC::getChannel() gives them
+    auto channel = ::grpc::CreateChannel("127.0.0.1:" + std::to_string(port), ::grpc::InsecureChannelCredentials());
+    auto payload = makeBuffer(payloadSize, 'c');
+
+    printf("gRPC stream benchmark: %zu streams, %zu chunks each, %zu byte payload, stand-in port %d\n",
+           streams,
+           chunks,
+           payloadSize,
+           port);
+
+    {
+        // Each stream starts its own thread as it is set up, as it used to
+        std::vector<std::unique_ptr<CompletionQueuePool>> pools(streams);
+        auto getPool = [&pools](size_t index) -> CompletionQueuePool& {
+            pools[index] = std::make_unique<CompletionQueuePool>(1);
+            return *pools[index];
+        };
+        run("thread per stream", streams, channel, streams, chunks, payload, getPool);
+    }
+
+    {
+        CompletionQueuePool pool(pollerThreads);
+        auto getPool = [&pool](size_t) -> CompletionQueuePool& { return pool; };
+        run("shared pool", pool.getPollerThreadCount(), channel, streams, chunks, payload, getPool);
+    }
+
+    server->Shutdown();
+    return 0;
+}
@@ -0,0 +1,189 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+// Compares parsing response payloads the way the transports used to, copying them into a std::string
+// for nlohmann::json::parse(), against dfx::api::utils::parseJson() which parses them in place and, for
+// payloads which are objects, dfx::api::utils::parseStreamResult() reading only the fields of a
+// measurement result with whichever parser it was built with (WITH_SIMDJSON). Reports the time per
+// response and MB/s for each corpus.
+//
+// Without files a corpus of generated responses shaped like the ones the server sends is used:
+//   - measurement stream results, a few signals of a few hundred samples each
+//   - a large list response, as returned by the measurement and study list routes
+//   - small acknowledgements and errors
+// Captured response payloads (the JSON following the status code) may be given instead, one per file.
+//
+// Usage: benchmark-json-parse [iterations] [response-files...]
+
+#include "dfx/benchmark/BenchmarkStats.hpp"
+
+#include "dfx/api/utils/JsonParser.hpp"
+
+#include "nlohmann/json.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace dfx::benchmark;
+
+namespace
+{
+
+std::string makeResult(std::mt19937& random, int chunkOrder)
+{
+    std::uniform_int_distribution<int> sample(55000, 95000);
+    nlohmann::json result;
+    result["ID"] = "a4b5c1d2-7e8f-4a0b-9c1d-2e3f4a5b6c7d";
+    result["MeasurementDataID"] = "a4b5c1d2-7e8f-4a0b-9c1d-2e3f4a5b6c7d:" + std::to_string(chunkOrder);
+    result["Multiplier"] = 1000;
+    result["Error"] = {{"Code", "OK"}, {"Errors", nlohmann::json::object()}};
+    for (const auto* signal : {"HR_BPM", "BR_BPM", "SNR", "IHB_COUNT", "MSI", "BP_SYSTOLIC", "BP_DIASTOLIC"}) {
+        std::vector<int> data(300);
+        for (auto& value : data) {
+            value = sample(random);
+        }
+        result["Channels"][signal] = {{"Channel", signal}, {"Data", data}};
+    }
+    return result.dump();
+}
+
+std::string makeList(std::mt19937& random, size_t entries)
+{
+    std::uniform_int_distribution<int> created(1600000000, 1700000000);
+    nlohmann::json list = nlohmann::json::array();
+    for (size_t index = 0; index < entries; index++) {
+        list.push_back({{"ID", "a4b5c1d2-7e8f-4a0b-9c1d-" + std::to_string(100000000000 + index)},
+                        {"StudyID", "2c7f6d3a-55e1-4b8e-8d0b-6d2b8e1f0a47"},
+                        {"Status", "COMPLETE"},
+                        {"Mode", "STREAMING"},
+                        {"Region", "na-east"},
+                        {"DeviceID", nullptr},
+                        {"PartnerID", "benchmark"},
+                        {"Created", created(random)},
+                        {"Updated", created(random)},
+                        {"StatusID", "COMPLETE"},
+                        {"TotalCount", entries}});
+    }
+    return list.dump();
+}
+
+std::vector<std::pair<std::string, std::string>> makeCorpora()
+{
+    std::mt19937 random(1);
+    std::vector<std::pair<std::string, std::string>> corpora;
+    corpora.emplace_back("stream result", makeResult(random, 3));
+    corpora.emplace_back("list of 500", makeList(random, 500));
+    corpora.emplace_back("acknowledgement", R"({"ID":"a4b5c1d2-7e8f-4a0b-9c1d-2e3f4a5b6c7d"})");
+    corpora.emplace_back("error", R"({"Code":"VALIDATION_ERROR","Errors":{"Status":[["VALID_PROPERTIES",)"
+                                  R"(["ACTIVE","INACTIVE"]]]},"Message":""})");
+    return corpora;
+}
+
+bool readFile(const char* path, std::string& contents)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::stringstream stream;
+    stream << file.rdbuf();
+    contents = stream.str();
+    return true;
+}
+
+template <typename Output, typename Parser>
+bool run(const std::string& label, const std::string& payload, size_t iterations, Parser parser)
+{
+    // The transports receive the payload as bytes in a message buffer with some spare capacity
+    std::vector<uint8_t> message;
+    message.reserve(payload.size() + 64);
+    message.assign(payload.begin(), payload.end());
+    const auto* data = reinterpret_cast<const char*>(message.data());
+
+    Output output;
+    if (!parser(data, message.size(), message.capacity(), output)) {
+        fprintf(stderr, "%s did not parse\n", label.c_str());
+        return false;
+    }
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    auto start = Clock::now();
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        auto parseStart = Clock::now();
+        parser(data, message.size(), message.capacity(), output);
+        samples.push_back(elapsedMicros(parseStart));
+    }
+    auto seconds = elapsedMicros(start) / 1e6;
+
+    printf("%-40s %10zu bytes %10.1f MB/s\n",
+           label.c_str(),
+           message.size(),
+           static_cast<double>(message.size() * iterations) / seconds / 1e6);
+    printStats(label.c_str(), samples);
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+
+    std::vector<std::pair<std::string, std::string>> corpora;
+    if (argc > 2) {
+        for (int index = 2; index < argc; index++) {
+            std::string contents;
+            if (!readFile(argv[index], contents)) {
+                fprintf(stderr, "Unable to read %s\n", argv[index]);
+                return 1;
+            }
+            corpora.emplace_back(argv[index], contents);
+        }
+    } else {
+        corpora = makeCorpora();
+    }
+
+    printf("JSON parse benchmark: %zu iterations, parseStreamResult() uses %s\n",
+           iterations,
+           dfx::api::utils::getJsonParserName());
+
+    auto copyAndParse = [](const char* data, size_t size, size_t /*capacity*/, nlohmann::json& json) {
+        std::string payload(data, size);
+        json = nlohmann::json::parse(payload, nullptr, false);
+        return !json.is_discarded();
+    };
+    auto parseJson = [](const char* data, size_t size, size_t /*capacity*/, nlohmann::json& json) {
+        return dfx::api::utils::parseJson(data, size, json);
+    };
+
+    for (const auto& corpus : corpora) {
+        if (!run<nlohmann::json>(corpus.first + ", string + nlohmann", corpus.second, iterations, copyAndParse) ||
+            !run<nlohmann::json>(corpus.first + ", parseJson", corpus.second, iterations, parseJson)) {
+            return 1;
+        }
+        if (corpus.second.front() == '{' &&
+            !run<dfx::api::utils::JsonStreamResult>(
+                corpus.first + ", parseStreamResult", corpus.second, iterations, dfx::api::utils::parseStreamResult)) {
+            return 1;
+        }
+
+        // Both must see the same document
+        nlohmann::json expected;
+        nlohmann::json parsed;
+        copyAndParse(corpus.second.data(), corpus.second.size(), 0, expected);
+        dfx::api::utils::parseJson(corpus.second.data(), corpus.second.size(), parsed);
+        if (expected != parsed || expected.dump() != parsed.dump()) {
+            fprintf(stderr, "%s parsed differently\n", corpus.first.c_str());
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,170 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+// Compares the heap allocations and time of the WebSocket Protobuf measurement hot paths with messages
+// on the stack, as they used to be, against messages in a ProtobufArena reset after each one:
+//   - decoding a SubscribeResultsResponse, a few channels of a few hundred samples each
+//   - building and serializing a DataRequest and the DataResponse it is answered with
+// Allocations are counted by replacing the global operator new.
+//
+// Usage: benchmark-protobuf-arena [iterations] [samples-per-channel]
+
+#include "dfx/benchmark/BenchmarkStats.hpp"
+
+#include "ProtobufArena.hpp"
+
+#include "dfx/proto/measurements.pb.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace dfx::benchmark;
+using dfx::api::websocket::protobuf::ProtobufArena;
+
+namespace
+{
+std::atomic<size_t> allocations(0);
+}
+
+void* operator new(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept
+{
+    std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    std::free(memory);
+}
+
+namespace
+{
+
+const std::string measurementID = "a4b5c1d2-7e8f-4a0b-9c1d-2e3f4a5b6c7d";
+
+std::string makeResponse(size_t samplesPerChannel)
+{
+    std::mt19937 random(1);
+    std::uniform_int_distribution<int> sample(55000, 95000);
+
+    dfx::proto::measurements::SubscribeResultsResponse response;
+    response.set_measurementid(measurementID);
+    response.set_measurementdataid(measurementID + ":3");
+    response.set_multiplier(1000);
+    response.mutable_error()->set_code("OK");
+    for (const auto* signal : {"HR_BPM", "BR_BPM", "SNR", "IHB_COUNT", "MSI", "BP_SYSTOLIC", "BP_DIASTOLIC"}) {
+        auto& channel = (*response.mutable_channels())[signal];
+        channel.set_channel(signal);
+        for (size_t index = 0; index < samplesPerChannel; index++) {
+            channel.add_data(sample(random));
+        }
+    }
+    return response.SerializeAsString();
+}
+
+// What handleStreamResponse() reads from a response
+size_t consume(const dfx::proto::measurements::SubscribeResultsResponse& response)
+{
+    size_t values = response.measurementdataid().size();
+    for (const auto& channel : response.channels()) {
+        values += static_cast<size_t>(channel.second.data_size());
+    }
+    return values;
+}
+
+// What sendChunk() builds for a chunk, sendMessage() serializing the request and parsing the response
+size_t buildChunk(dfx::proto::measurements::DataRequest& request,
+                  dfx::proto::measurements::DataResponse& response,
+                  const std::string& responseBytes,
+                  std::vector<uint8_t>& buffer)
+{
+    request.mutable_params()->set_id(measurementID);
+    request.set_action("CHUNK::PROCESS");
+    buffer.resize(request.ByteSizeLong());
+    request.SerializeToArray(buffer.data(), static_cast<int>(buffer.size()));
+    response.ParseFromString(responseBytes);
+    return buffer.size();
+}
+
+template <typename Step>
+void run(const char* label, size_t iterations, Step step)
+{
+    size_t checksum = step(); // Once through first so anything reused has grown to size
+
+    std::vector<double> samples;
+    samples.reserve(iterations);
+    auto before = allocations.load();
+    for (size_t iteration = 0; iteration < iterations; iteration++) {
+        auto start = Clock::now();
+        checksum += step();
+        samples.push_back(1000.0 * elapsedMicros(start));
+    }
+    auto allocated = allocations.load() - before;
+
+    printf("%-32s %8.1f allocations/message (checksum %zu)\n",
+           label,
+           static_cast<double>(allocated) / static_cast<double>(iterations),
+           checksum);
+    printStats(label, samples, "ns");
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+    size_t samplesPerChannel = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 300;
+
+    const auto resultBytes = makeResponse(samplesPerChannel);
+    dfx::proto::measurements::DataResponse dataResponse;
+    dataResponse.set_id(measurementID + ":3");
+    const auto dataResponseBytes = dataResponse.SerializeAsString();
+
+    printf("Protobuf arena benchmark: %zu iterations, %zu byte results response\n", iterations, resultBytes.size());
+
+    run("result decode, stack", iterations, [&resultBytes]() {
+        dfx::proto::measurements::SubscribeResultsResponse response;
+        response.ParseFromString(resultBytes);
+        return consume(response);
+    });
+
+    ProtobufArena resultArena;
+    run("result decode, arena", iterations, [&resultBytes, &resultArena]() {
+        auto* response = resultArena.create<dfx::proto::measurements::SubscribeResultsResponse>();
+        response->ParseFromString(resultBytes);
+        auto values = consume(*response);
+        resultArena.reset();
+        return values;
+    });
+
+    std::vector<uint8_t> buffer;
+    run("chunk request, stack", iterations, [&dataResponseBytes, &buffer]() {
+        dfx::proto::measurements::DataRequest request;
+        dfx::proto::measurements::DataResponse response;
+        return buildChunk(request, response, dataResponseBytes, buffer);
+    });
+
+    ProtobufArena chunkArena;
+    run("chunk request, arena", iterations, [&dataResponseBytes, &buffer, &chunkArena]() {
+        auto* request = chunkArena.create<dfx::proto::measurements::DataRequest>();
+        auto* response = chunkArena.create<dfx::proto::measurements::DataResponse>();
+        auto size = buildChunk(*request, *response, dataResponseBytes, buffer);
+        chunkArena.reset();
+        return size;
+    });
+
+    return 0;
+}
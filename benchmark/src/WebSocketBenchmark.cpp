@@ -0,0 +1,168 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+// Measures the WebSocket layer against a local echo server:
+//   - open time
+//   - send-to-wire latency, as the round trip of a message through the loopback echo server
+//   - CPU used by idle open connections
+//   - close() (shutdown) time
+//
+// Usage: benchmark-websocket [iterations] [payload-bytes] [idle-connections]
+
+#include "dfx/benchmark/BenchmarkStats.hpp"
+#include "dfx/benchmark/EchoServer.hpp"
+
+#include "dfx/websocket/WebSocketEventLoop.hpp"
+#include "dfx/websocket/WebSocketLibWebSocket.hpp"
+
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace dfx::benchmark;
+using namespace dfx::websocket;
+
+namespace
+{
+
+// Tracks the events of one client connection so the benchmark can wait on them
+struct Connection
+{
+    std::shared_ptr<WebSocketLibWebSocket> socket;
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool opened = false;
+    bool failed = false;
+    size_t messages = 0;
+
+    void handleEvent(const WebSocketEvent& event)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        switch (event.type) {
+            case WebSocketEventType::OPEN:
+                opened = true;
+                break;
+            case WebSocketEventType::MESSAGE:
+                messages++;
+                break;
+            case WebSocketEventType::ERROR_EVENT:
+            case WebSocketEventType::CLOSED:
+                failed = true;
+                break;
+            default:
+                break;
+        }
+        cv.notify_all();
+    }
+
+    bool waitOpen()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(10), [this] { return opened || failed; }) && opened;
+    }
+
+    bool waitMessages(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(10), [this, count] { return messages >= count || failed; }) &&
+               messages >= count;
+    }
+};
+
+std::unique_ptr<Connection> openConnection(const std::shared_ptr<WebSocketEventLoop>& eventLoop, int port)
+{
+    auto connection = std::make_unique<Connection>();
+    connection->socket = std::make_shared<WebSocketLibWebSocket>(0, nullptr, eventLoop);
+    connection->socket->setEventCallback(
+        [](const WebSocketEvent& event, void* userData) { static_cast<Connection*>(userData)->handleEvent(event); },
+        connection.get());
+    connection->socket->open("ws://127.0.0.1:" + std::to_string(port), "proto");
+    return connection;
+}
+
+double processCPUMillis()
+{
+    return 1000.0 * static_cast<double>(std::clock()) / CLOCKS_PER_SEC;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    size_t iterations = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000;
+    size_t payloadSize = argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 1024;
+    size_t idleConnections = argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 50;
+
+    EchoServer server;
+    if (!server.isRunning()) {
+        fprintf(stderr, "Unable to start local echo server\n");
+        return 1;
+    }
+
+    auto eventLoop = std::make_shared<WebSocketEventLoop>();
+    printf("WebSocket benchmark: %zu iterations, %zu byte payload, %u service threads, echo port %d\n",
+           iterations,
+           payloadSize,
+           eventLoop->getServiceThreadCount(),
+           server.getPort());
+
+    // Open
+    auto start = Clock::now();
+    auto connection = openConnection(eventLoop, server.getPort());
+    if (!connection->waitOpen()) {
+        fprintf(stderr, "Unable to open connection to local echo server\n");
+        return 1;
+    }
+    printStats("open", {elapsedMicros(start)});
+
+    // Send-to-wire latency
+    std::vector<uint8_t> payload(payloadSize, 0x5A);
+    std::vector<double> roundTrips;
+    roundTrips.reserve(iterations);
+    for (size_t index = 0; index < iterations; index++) {
+        start = Clock::now();
+        connection->socket->sendBinary(payload);
+        if (!connection->waitMessages(index + 1)) {
+            fprintf(stderr, "Echo %zu did not arrive\n", index);
+            return 1;
+        }
+        roundTrips.push_back(elapsedMicros(start));
+    }
+    printStats("send round trip", roundTrips);
+
+    // Idle CPU with a number of open connections
+    std::vector<std::unique_ptr<Connection>> idle;
+    for (size_t index = 0; index < idleConnections; index++) {
+        idle.push_back(openConnection(eventLoop, server.getPort()));
+    }
+    for (auto& idleConnection : idle) {
+        idleConnection->waitOpen();
+    }
+
+    const int idleSeconds = 2;
+    auto cpuStart = processCPUMillis();
+    std::this_thread::sleep_for(std::chrono::seconds(idleSeconds));
+    printf("%-32s %zu connections used %.2fms CPU over %ds\n",
+           "idle",
+           eventLoop->getConnectionCount(),
+           processCPUMillis() - cpuStart,
+           idleSeconds);
+
+    // Shutdown
+    std::vector<double> closeTimes;
+    idle.push_back(std::move(connection));
+    for (auto& idleConnection : idle) {
+        start = Clock::now();
+        idleConnection->socket->close();
+        closeTimes.push_back(elapsedMicros(start));
+    }
+    printStats("close", closeTimes);
+
+    return 0;
+}
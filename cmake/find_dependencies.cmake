@@ -6,6 +6,10 @@ find_package(googleapis CONFIG REQUIRED) # googleapis::googleapis
 
 find_package(nlohmann_json CONFIG REQUIRED) # nlohmann_json::nlohmann_json
 
+if(WITH_SIMDJSON)
+  find_package(simdjson CONFIG REQUIRED) # simdjson::simdjson
+endif(WITH_SIMDJSON)
+
 # find_package(cmake CONFIG)
 find_package(fmt CONFIG REQUIRED) # fmt::fmt
 find_package(protobuf CONFIG REQUIRED) # protobuf::protobuf
@@ -16,8 +20,14 @@ if(NOT TARGET yaml-cpp::yaml-cpp)
   endif()
 endif()
 
-if(WITH_GRPC)
+# gRPC, curl and libwebsockets all use OpenSSL, api-utils' TLSSessionCache uses it directly for the latter two
+if(WITH_GRPC
+   OR WITH_CURL
+   OR ((WITH_WEBSOCKET_JSON OR WITH_WEBSOCKET_PROTOBUF) AND NOT EMSCRIPTEN))
   find_package(OpenSSL CONFIG REQUIRED) # OpenSSL::openssl
+endif()
+
+if(WITH_GRPC)
   find_package(re2 CONFIG REQUIRED) # re2::re2
   find_package(c-ares CONFIG REQUIRED) # c-ares::c-ares
 
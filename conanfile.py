@@ -50,6 +50,7 @@ class dfxcloud(ConanFile):
         "with_docs": [True, False],
         "doc_language": ["english", "chinese"],
         "with_tests": [True, False],
+        "with_benchmarks": [True, False],
         "with_dfxcli": [True, False],
         "with_clang_format": [True, False],
         "enable_checks": [True, False]
@@ -69,6 +70,7 @@ class dfxcloud(ConanFile):
         "with_docs": False,
         "doc_language": "english",
         "with_tests": True,
+        "with_benchmarks": False,
         "with_dfxcli": True,
         "with_clang_format": True,
         "enable_checks": False
@@ -98,6 +100,7 @@ class dfxcloud(ConanFile):
             self.options["libcurl"].with_ssl = "openssl"
 
         self.options["libwebsockets"].with_zlib="zlib"
+        self.options["libwebsockets"].enable_extensions=True  # permessage-deflate
 
         if self.settings.os == "Emscripten":
             self.options.with_curl = False
@@ -105,11 +108,13 @@ class dfxcloud(ConanFile):
             self.options.with_rest = False
             self.options.with_docs = False
             self.options.with_tests = False
+            self.options.with_benchmarks = False
             self.options.with_yaml = False
 
         if cross_building(self):
             self.options.with_docs = False
             self.options.with_tests = False
+            self.options.with_benchmarks = False
             self.options.with_dfxcli = False
 
     def system_requirements(self):
@@ -212,6 +217,7 @@ class dfxcloud(ConanFile):
         toolchain.variables["WITH_VALIDATORS"] = "ON" if self.options.with_validators else "OFF"
         toolchain.variables["WITH_YAML"] = "ON" if self.options.with_yaml else "OFF"
         toolchain.variables["WITH_TESTS"] = "ON" if self.options.with_tests else "OFF"
+        toolchain.variables["WITH_BENCHMARKS"] = "ON" if self.options.with_benchmarks else "OFF"
         toolchain.variables["WITH_DFXCLI"] = "ON" if self.options.with_dfxcli else "OFF"
         toolchain.variables["WITH_DOCS"] = "ON" if self.options.with_docs else "OFF"
         toolchain.variables["WITH_CLANG_FORMAT"] = "True" if self.options.with_clang_format else "False"
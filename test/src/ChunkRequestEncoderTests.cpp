@@ -0,0 +1,117 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "ChunkRequestEncoder.hpp"
+
+#include "libbase64.h"
+#include "nlohmann/json.hpp"
+
+#include <gtest/gtest.h>
+
+#include <string>
+#include <vector>
+
+using dfx::api::utils::formatRequestHeader;
+using dfx::api::websocket::json::encodeChunkRequest;
+using dfx::api::websocket::json::getChunkRequestSize;
+using dfx::websocket::WebSocketSendBuffer;
+
+namespace
+{
+
+const uint32_t actionID = 506;
+const uint32_t sequence = 42;
+const char* action = "CHUNK::PROCESS";
+
+// The request as sendChunk() and sendMessageJsonAsync() built it before, serialized from a document
+std::string encodeDocument(const std::string& measurementID, uint16_t limit, const std::vector<uint8_t>& chunk)
+{
+    nlohmann::json request;
+    request["Action"] = action;
+
+    std::vector<char> chunkBase64(chunk.size() * 2 + 4);
+    size_t encodedLength = 0;
+    base64_encode(reinterpret_cast<const char*>(chunk.data()), chunk.size(), chunkBase64.data(), &encodedLength, 0);
+    request["Payload"] = std::string(chunkBase64.data(), encodedLength);
+
+    nlohmann::json params;
+    params["ID"] = measurementID;
+    if (limit > 0) {
+        params["Limit"] = limit;
+    }
+    request["Params"] = params;
+
+    auto header = formatRequestHeader(actionID, sequence);
+    return std::string(header.begin(), header.end()) + to_string(request);
+}
+
+std::string encodeDirect(const std::string& measurementID, uint16_t limit, const std::vector<uint8_t>& chunk)
+{
+    auto header = formatRequestHeader(actionID, sequence);
+    WebSocketSendBuffer buffer(16, std::vector<uint8_t>());
+    auto expectedSize = getChunkRequestSize(header, action, measurementID, chunk.size());
+    buffer.reserve(expectedSize);
+    encodeChunkRequest(buffer, header, action, measurementID, limit, chunk.data(), chunk.size());
+    EXPECT_LE(buffer.size(), expectedSize);
+    return std::string(buffer.data(), buffer.data() + buffer.size());
+}
+
+std::vector<uint8_t> makeChunk(size_t size)
+{
+    std::vector<uint8_t> chunk(size);
+    for (size_t index = 0; index < size; index++) {
+        chunk[index] = static_cast<uint8_t>(index * 131 + 7);
+    }
+    return chunk;
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// CHUNK REQUEST ENCODER TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(ChunkRequestEncoderTests, MatchesDocumentWithLimit)
+{
+    const std::string measurementID = "a4b5c1d2-7e8f-4a0b-9c1d-2e3f4a5b6c7d";
+    for (uint16_t limit : {1, 25, 65535}) {
+        auto chunk = makeChunk(1000);
+        EXPECT_EQ(encodeDirect(measurementID, limit, chunk), encodeDocument(measurementID, limit, chunk));
+    }
+}
+
+TEST(ChunkRequestEncoderTests, MatchesDocumentWithoutLimit)
+{
+    const std::string measurementID = "a4b5c1d2-7e8f-4a0b-9c1d-2e3f4a5b6c7d";
+    auto chunk = makeChunk(1000);
+    auto direct = encodeDirect(measurementID, 0, chunk);
+    EXPECT_EQ(direct, encodeDocument(measurementID, 0, chunk));
+    EXPECT_EQ(direct.find("Limit"), std::string::npos);
+}
+
+TEST(ChunkRequestEncoderTests, MatchesDocumentForPayloadSizes)
+{
+    const std::string measurementID = "a4b5c1d2-7e8f-4a0b-9c1d-2e3f4a5b6c7d";
+    for (size_t size : {0, 1, 2, 3, 4, 5, 255, 256 * 1024 + 1}) {
+        auto chunk = makeChunk(size);
+        EXPECT_EQ(encodeDirect(measurementID, 25, chunk), encodeDocument(measurementID, 25, chunk)) << size;
+    }
+}
+
+TEST(ChunkRequestEncoderTests, MatchesDocumentWhenIDNeedsEscaping)
+{
+    auto chunk = makeChunk(100);
+    const std::vector<std::string> measurementIDs = {"quote\"id", "back\\slash", std::string("control\n\t\x01", 10)};
+    for (const auto& measurementID : measurementIDs) {
+        EXPECT_EQ(encodeDirect(measurementID, 25, chunk), encodeDocument(measurementID, 25, chunk));
+        EXPECT_EQ(encodeDirect(measurementID, 0, chunk), encodeDocument(measurementID, 0, chunk));
+    }
+}
+
+TEST(ChunkRequestEncoderTests, Layout)
+{
+    EXPECT_EQ(encodeDirect("id", 0, makeChunk(3)),
+              R"(05060506000042{"Action":"CHUNK::PROCESS","Params":{"ID":"id"},"Payload":"B4oN"})");
+    EXPECT_EQ(encodeDirect("id", 25, makeChunk(3)),
+              R"(05060506000042{"Action":"CHUNK::PROCESS","Params":{"ID":"id","Limit":25},"Payload":"B4oN"})");
+}
@@ -0,0 +1,115 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/Dequantize.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <limits>
+#include <string>
+#include <vector>
+
+using dfx::api::utils::dequantize;
+using dfx::api::utils::dequantizeWithKernel;
+using dfx::api::utils::getDequantizeKernelName;
+
+namespace
+{
+
+const char* kernelNames[] = {"scalar", "sse2", "avx", "neon"};
+const float multipliers[] = {1.0f, 1000.0f, 3.0f, -7.0f, 0.5f};
+const float sentinel = -12345.0f;
+
+std::vector<int32_t> makeData(size_t count)
+{
+    std::vector<int32_t> data(count);
+    for (size_t index = 0; index < count; index++) {
+        data[index] = static_cast<int32_t>(index * 2654435761u); // Spread over the whole range
+    }
+    if (count > 2) {
+        data[0] = std::numeric_limits<int32_t>::min();
+        data[1] = std::numeric_limits<int32_t>::max();
+        data[2] = 0;
+    }
+    return data;
+}
+
+// Exactly what the decoders computed before the kernels
+std::vector<float> dequantizeReference(const std::vector<int32_t>& data, size_t offset, float multiplier)
+{
+    std::vector<float> output;
+    for (size_t index = offset; index < data.size(); index++) {
+        output.push_back(static_cast<float>(data[index]) / multiplier);
+    }
+    return output;
+}
+
+// Bit for bit, so a kernel which multiplies by the reciprocal is caught
+bool isIdentical(const float* output, const std::vector<float>& expected)
+{
+    return expected.empty() || memcmp(output, expected.data(), expected.size() * sizeof(float)) == 0;
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// DEQUANTIZE TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(DequantizeTests, ChosenKernelIsAvailable)
+{
+    std::string chosen = getDequantizeKernelName();
+    int32_t value = 10;
+    float output = 0;
+    EXPECT_TRUE(dequantizeWithKernel(chosen.c_str(), &value, 1, 4.0f, &output)) << chosen;
+    EXPECT_EQ(output, 2.5f);
+
+    EXPECT_TRUE(dequantizeWithKernel("scalar", &value, 1, 4.0f, &output));
+    EXPECT_FALSE(dequantizeWithKernel("unknown", &value, 1, 4.0f, &output));
+}
+
+TEST(DequantizeTests, KernelsMatchScalar)
+{
+    std::vector<size_t> counts;
+    for (size_t count = 0; count <= 40; count++) {
+        counts.push_back(count); // Every tail length of the 4 and 8 wide kernels
+    }
+    counts.insert(counts.end(), {1023, 1024, 1025, 4097});
+
+    for (const char* kernelName : kernelNames) {
+        for (size_t count : counts) {
+            // Starting one value in as well, so the loads and stores are not aligned
+            for (size_t offset : {0, 1}) {
+                auto data = makeData(count + offset);
+                for (float multiplier : multipliers) {
+                    SCOPED_TRACE(std::string(kernelName) + " count " + std::to_string(count) + " offset " +
+                                 std::to_string(offset) + " multiplier " + std::to_string(multiplier));
+                    auto expected = dequantizeReference(data, offset, multiplier);
+
+                    std::vector<float> output(count + offset + 1, sentinel);
+                    float* start = output.data() + offset;
+                    if (!dequantizeWithKernel(kernelName, data.data() + offset, count, multiplier, start)) {
+                        continue; // Not on this machine
+                    }
+                    EXPECT_TRUE(isIdentical(start, expected));
+                    if (offset > 0) {
+                        EXPECT_EQ(output.front(), sentinel);
+                    }
+                    EXPECT_EQ(output.back(), sentinel); // Nothing written past count
+                }
+            }
+        }
+    }
+}
+
+TEST(DequantizeTests, DequantizeMatchesScalar)
+{
+    auto data = makeData(1001);
+    for (float multiplier : multipliers) {
+        auto expected = dequantizeReference(data, 0, multiplier);
+        std::vector<float> output(data.size());
+        dequantize(data.data(), data.size(), multiplier, output.data());
+        EXPECT_TRUE(isIdentical(output.data(), expected)) << multiplier;
+    }
+}
@@ -0,0 +1,215 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/JsonParser.hpp"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+using dfx::api::utils::JsonStreamResult;
+using dfx::api::utils::parseJson;
+using dfx::api::utils::parseStreamResult;
+
+namespace
+{
+
+// What the transport read from a stream result when it parsed the whole message with nlohmann::json
+struct ExpectedStreamResult
+{
+    bool valid = false;
+    nlohmann::json error;
+    std::string id;
+    std::string measurementDataID;
+    int64_t multiplier = 1;
+    std::map<std::string, std::vector<int32_t>> channels;
+};
+
+ExpectedStreamResult readWithNlohmann(const std::string& text)
+{
+    ExpectedStreamResult expected;
+    auto json = nlohmann::json::parse(text, nullptr, false);
+    if (json.is_discarded() || !json.is_object()) {
+        return expected;
+    }
+
+    try {
+        if (json.contains("Error")) {
+            expected.error = json["Error"];
+        }
+        if (json.contains("ID")) {
+            expected.id = json["ID"].get<std::string>();
+        }
+        if (json.contains("MeasurementDataID")) {
+            expected.measurementDataID = json["MeasurementDataID"].get<std::string>();
+        }
+        if (json.contains("Multiplier")) {
+            expected.multiplier = json["Multiplier"].get<int64_t>();
+        }
+        if (json.contains("Channels")) {
+            if (!json["Channels"].is_object()) {
+                return expected; // Rather than reading an array's elements as channels "0", "1"...
+            }
+            for (const auto& channel : json["Channels"].items()) {
+                if (!channel.value().is_object()) {
+                    return expected;
+                }
+                auto& data = expected.channels[channel.key()];
+                if (channel.value().contains("Data")) {
+                    data = channel.value()["Data"].get<std::vector<int32_t>>();
+                }
+            }
+        }
+    } catch (const nlohmann::json::exception&) {
+        return expected;
+    }
+    expected.valid = true;
+    return expected;
+}
+
+// Compares against the nlohmann reading both in place with padding behind the text and from a copy
+void expectSameAsNlohmann(const std::string& text)
+{
+    SCOPED_TRACE(text);
+    auto expected = readWithNlohmann(text);
+
+    std::string padded = text + std::string(64, ' ');
+    for (size_t capacity : {text.size(), padded.size()}) {
+        JsonStreamResult result;
+        result.id = "left over";
+        bool parsed = parseStreamResult(padded.data(), text.size(), capacity, result);
+        ASSERT_EQ(parsed, expected.valid);
+        if (!parsed) {
+            continue;
+        }
+
+        if (expected.error.is_null()) {
+            EXPECT_TRUE(result.errorJson.empty());
+        } else {
+            EXPECT_EQ(nlohmann::json::parse(result.errorJson), expected.error);
+        }
+        EXPECT_EQ(result.id, expected.id);
+        EXPECT_EQ(result.measurementDataID, expected.measurementDataID);
+        EXPECT_EQ(result.multiplier, expected.multiplier);
+
+        // Duplicated channels are dispatched by name, the last one wins
+        std::map<std::string, std::vector<int32_t>> channels;
+        for (const auto& channel : result.channels) {
+            channels[channel.first] = channel.second;
+        }
+        EXPECT_EQ(channels, expected.channels);
+    }
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// PARSE JSON TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(JsonParserTests, ParseJsonMatchesNlohmann)
+{
+    const std::vector<std::string> texts = {
+        R"({"a":1,"b":[true,false,null],"c":{"d":"eé\n"}})",
+        R"([0,-0,1,-1,2147483648,-2147483649,9223372036854775807,18446744073709551615,-9223372036854775808])",
+        R"([1.0,-2.5,1e3,1E-3,0.1,123456789012345678901234567890,1.7976931348623157e308])",
+        R"({"Key":1,"Key":2,"Other":{"Key":"a","Key":"b"}})",
+        R"(  "text"  )",
+        R"(42)",
+    };
+    for (const auto& text : texts) {
+        SCOPED_TRACE(text);
+        nlohmann::json json;
+        ASSERT_TRUE(parseJson(text.data(), text.size(), json));
+        EXPECT_EQ(json, nlohmann::json::parse(text));
+        EXPECT_EQ(json.dump(), nlohmann::json::parse(text).dump());
+    }
+}
+
+TEST(JsonParserTests, ParseJsonRejectsInvalid)
+{
+    const std::vector<std::string> texts = {"", " ", "{", R"({"a":})", R"({"a":1,})", "[1,2", "{} {}", "nul", "01",
+                                            R"({'a':1})", "\"unterminated", "[1e]"};
+    for (const auto& text : texts) {
+        SCOPED_TRACE(text);
+        nlohmann::json json = {{"left", "over"}};
+        EXPECT_FALSE(parseJson(text.data(), text.size(), json));
+        EXPECT_TRUE(json.is_discarded());
+        EXPECT_TRUE(nlohmann::json::parse(text, nullptr, false).is_discarded());
+    }
+}
+
+TEST(JsonParserTests, ParseJsonReadsOnlySize)
+{
+    const std::string text = R"({"a":1}garbage)";
+    nlohmann::json json;
+    ASSERT_TRUE(parseJson(text.data(), 7, json));
+    EXPECT_EQ(json["a"], 1);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// PARSE STREAM RESULT TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(JsonParserTests, StreamResult)
+{
+    expectSameAsNlohmann(
+        R"({"ID":"meas","MeasurementDataID":"meas:3","Multiplier":1000,"Extra":{"Nested":[1,{"x":null}]},)"
+        R"("Channels":{"HR_BPM":{"Data":[72000,-5,0],"Notes":"skipped"},"SNR":{"Data":[]},"Empty":{}},)"
+        R"("Error":{"Code":"OK","Errors":{}}})");
+    expectSameAsNlohmann(R"({})");
+    expectSameAsNlohmann(R"({"Channels":{}})");
+    expectSameAsNlohmann(R"({"ID":"esc\"apedé\\"})");
+    expectSameAsNlohmann(" \n{ \"ID\" : \"spaced\" , \"Multiplier\" : 7 }\n ");
+}
+
+TEST(JsonParserTests, StreamResultNumbers)
+{
+    expectSameAsNlohmann(R"({"Multiplier":-1})");
+    expectSameAsNlohmann(R"({"Multiplier":0})");
+    expectSameAsNlohmann(R"({"Multiplier":9223372036854775807})");
+    expectSameAsNlohmann(R"({"Multiplier":2.0})");
+    expectSameAsNlohmann(R"({"Multiplier":2.75})");
+    expectSameAsNlohmann(R"({"Multiplier":1e3})");
+    expectSameAsNlohmann(R"({"Channels":{"A":{"Data":[2147483647,-2147483648,0,-0,1]}}})");
+    expectSameAsNlohmann(R"({"Channels":{"A":{"Data":[1.0,-2.5,3e2,4E0]}}})");
+    expectSameAsNlohmann(R"({"Channels":{"A":{"Data":[4294967296,-4294967297]}}})");
+}
+
+TEST(JsonParserTests, StreamResultDuplicateKeys)
+{
+    expectSameAsNlohmann(R"({"ID":"first","ID":"second"})");
+    expectSameAsNlohmann(R"({"Multiplier":1,"Multiplier":100})");
+    expectSameAsNlohmann(R"({"Channels":{"A":{"Data":[1]}},"Channels":{"B":{"Data":[2]}}})");
+    expectSameAsNlohmann(R"({"Channels":{"A":{"Data":[1,2]},"A":{"Data":[3]}}})");
+    expectSameAsNlohmann(R"({"Channels":{"A":{"Data":[1,2],"Data":[3,4,5]}}})");
+    expectSameAsNlohmann(R"({"Error":{"Code":"A"},"Error":{"Code":"B"}})");
+}
+
+TEST(JsonParserTests, StreamResultInvalid)
+{
+    const std::vector<std::string> texts = {
+        "",
+        "[]",
+        R"("text")",
+        R"({"ID":"meas")",
+        R"({"ID":"meas"} trailing)",
+        R"({"ID":"meas",})",
+        R"({"ID":42})",
+        R"({"MeasurementDataID":null})",
+        R"({"Multiplier":"1000"})",
+        R"({"Channels":[]})",
+        R"({"Channels":{"A":[1,2]}})",
+        R"({"Channels":{"A":{"Data":{}}}})",
+        R"({"Channels":{"A":{"Data":[1,"2"]}}})",
+        R"({"Channels":{"A":{"Data":[1,null]}}})",
+        R"({"Channels":{"A":{"Data":[1,2}}})",
+    };
+    for (const auto& text : texts) {
+        expectSameAsNlohmann(text);
+        JsonStreamResult result;
+        EXPECT_FALSE(parseStreamResult(text.data(), text.size(), text.size(), result)) << text;
+    }
+}
@@ -0,0 +1,185 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/RequestSlotTable.hpp"
+
+#include <gtest/gtest.h>
+
+#include <map>
+#include <string>
+
+using dfx::api::utils::formatRequestHeader;
+using dfx::api::utils::MAX_REQUEST_SEQUENCE;
+using dfx::api::utils::parseRequestID;
+using dfx::api::utils::RequestSlotTable;
+
+///////////////////////////////////////////////////////////////////////////////
+// REQUEST HEADER TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(RequestSlotTableTests, RequestHeaderRoundTrip)
+{
+    auto header = formatRequestHeader(506, 42);
+    EXPECT_EQ(std::string(header.begin(), header.end()), "05060506000042");
+
+    uint32_t actionID = 0;
+    uint32_t sequence = 0;
+    ASSERT_TRUE(parseRequestID(header.data() + 4, actionID, sequence));
+    EXPECT_EQ(actionID, 506u);
+    EXPECT_EQ(sequence, 42u);
+
+    header = formatRequestHeader(9999, MAX_REQUEST_SEQUENCE);
+    ASSERT_TRUE(parseRequestID(header.data() + 4, actionID, sequence));
+    EXPECT_EQ(actionID, 9999u);
+    EXPECT_EQ(sequence, MAX_REQUEST_SEQUENCE);
+}
+
+TEST(RequestSlotTableTests, ParseRejectsStreamID)
+{
+    uint32_t actionID = 0;
+    uint32_t sequence = 0;
+    EXPECT_FALSE(parseRequestID("STRM000001", actionID, sequence));
+    EXPECT_FALSE(parseRequestID("05060000a1", actionID, sequence));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// REQUEST SLOT TABLE TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(RequestSlotTableTests, AcquireFindRelease)
+{
+    RequestSlotTable<int> table(8);
+    EXPECT_EQ(table.size(), 0u);
+
+    auto first = table.acquire();
+    auto second = table.acquire();
+    EXPECT_EQ(first, 1u);
+    EXPECT_EQ(second, 2u);
+    EXPECT_EQ(table.size(), 2u);
+
+    *table.find(first) = 10;
+    *table.find(second) = 20;
+    EXPECT_EQ(*table.find(first), 10);
+    EXPECT_EQ(*table.find(second), 20);
+
+    EXPECT_TRUE(table.release(first));
+    EXPECT_EQ(table.find(first), nullptr);
+    EXPECT_EQ(*table.find(second), 20);
+    EXPECT_EQ(table.size(), 1u);
+
+    EXPECT_EQ(table.find(0), nullptr);
+    EXPECT_EQ(table.find(3), nullptr); // Never acquired
+    EXPECT_EQ(table.find(MAX_REQUEST_SEQUENCE + 1), nullptr);
+}
+
+TEST(RequestSlotTableTests, FullTable)
+{
+    RequestSlotTable<int> table(4);
+    for (uint32_t expected = 1; expected <= 4; expected++) {
+        EXPECT_EQ(table.acquire(), expected);
+    }
+    EXPECT_EQ(table.size(), 4u);
+    EXPECT_EQ(table.acquire(), 0u);
+    EXPECT_EQ(table.size(), 4u);
+
+    // Freeing any slot makes room, the next sequence lands in the one free slot
+    EXPECT_TRUE(table.release(2));
+    auto sequence = table.acquire();
+    EXPECT_NE(sequence, 0u);
+    EXPECT_EQ(sequence % 4, 2u);
+    EXPECT_EQ(table.acquire(), 0u);
+}
+
+TEST(RequestSlotTableTests, LateOrDuplicateResponse)
+{
+    RequestSlotTable<int> table(4);
+    auto timedOut = table.acquire();
+    *table.find(timedOut) = 1;
+    EXPECT_TRUE(table.release(timedOut)); // As when the request times out
+
+    // Go round until a later request takes the same slot
+    uint32_t later = 0;
+    do {
+        later = table.acquire();
+        if (later % 4 != timedOut % 4) {
+            table.release(later);
+            later = 0;
+        }
+    } while (later == 0);
+    ASSERT_NE(later, timedOut);
+    *table.find(later) = 2;
+
+    // The late response to the released request does not match the later one sharing its slot
+    EXPECT_EQ(table.find(timedOut), nullptr);
+    EXPECT_FALSE(table.release(timedOut));
+    EXPECT_EQ(*table.find(later), 2);
+
+    // A duplicated response finds the request released by the first
+    EXPECT_TRUE(table.release(later));
+    EXPECT_FALSE(table.release(later));
+    EXPECT_EQ(table.find(later), nullptr);
+    EXPECT_EQ(table.size(), 0u);
+}
+
+TEST(RequestSlotTableTests, Wraparound)
+{
+    RequestSlotTable<int> table(4);
+
+    // Held across the wrap, sequence 1 is still outstanding when the sequences come round again
+    auto held = table.acquire();
+    EXPECT_EQ(held, 1u);
+    *table.find(held) = 7;
+
+    // Counts up, skipping the sequences which would land in the held slot
+    uint32_t last = held;
+    while (last != MAX_REQUEST_SEQUENCE) {
+        auto sequence = table.acquire();
+        ASSERT_GT(sequence, last);
+        ASSERT_NE(sequence % 4, held % 4);
+        ASSERT_TRUE(table.release(sequence));
+        last = sequence;
+    }
+
+    // Wraps back to 1, which is taken so is skipped
+    auto wrapped = table.acquire();
+    EXPECT_EQ(wrapped, 2u);
+    EXPECT_EQ(*table.find(held), 7);
+    EXPECT_TRUE(table.release(held));
+    EXPECT_TRUE(table.release(wrapped));
+
+    // Once released it comes round again after another lap
+    for (uint32_t expected = 3; expected <= MAX_REQUEST_SEQUENCE; expected++) {
+        ASSERT_EQ(table.acquire(), expected);
+        ASSERT_TRUE(table.release(expected));
+    }
+    EXPECT_EQ(table.acquire(), 1u);
+}
+
+TEST(RequestSlotTableTests, WraparoundSkipsTakenSlots)
+{
+    RequestSlotTable<int> table(4);
+
+    // Fill all but one slot then go round, only sequences landing in the free slot can be handed out
+    for (int index = 0; index < 3; index++) {
+        table.acquire();
+    }
+    for (int index = 0; index < 100; index++) {
+        auto sequence = table.acquire();
+        ASSERT_NE(sequence, 0u);
+        EXPECT_EQ(sequence % 4, 0u);
+        EXPECT_TRUE(table.release(sequence));
+    }
+}
+
+TEST(RequestSlotTableTests, ForEach)
+{
+    RequestSlotTable<int> table(8);
+    for (int index = 0; index < 5; index++) {
+        *table.find(table.acquire()) = index * 10;
+    }
+    table.release(3);
+
+    std::map<uint32_t, int> visited;
+    table.forEach([&visited](uint32_t sequence, int& value) { visited[sequence] = value; });
+    EXPECT_EQ(visited, (std::map<uint32_t, int>{{1, 0}, {2, 10}, {4, 30}, {5, 40}}));
+}
@@ -0,0 +1,241 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/TLSSessionCache.hpp"
+
+#include <gtest/gtest.h>
+
+#include <openssl/evp.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <string>
+
+using dfx::api::utils::TLSSessionCache;
+
+namespace
+{
+
+// Handshakes in memory over a BIO pair, no sockets involved
+class TLSSessionCacheTests : public ::testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        filePath = ::testing::TempDir() + "dfx-tls-session-cache-test.bin";
+        std::remove(filePath.c_str());
+
+        key = generateKey();
+        ASSERT_NE(key, nullptr);
+        certificate = generateCertificate(key);
+        ASSERT_NE(certificate, nullptr);
+
+        // The one server context for every handshake, so the tickets it issues stay valid
+        serverContext = SSL_CTX_new(TLS_server_method());
+        ASSERT_NE(serverContext, nullptr);
+        ASSERT_EQ(SSL_CTX_use_certificate(serverContext, certificate), 1);
+        ASSERT_EQ(SSL_CTX_use_PrivateKey(serverContext, key), 1);
+    }
+
+    void TearDown() override
+    {
+        SSL_CTX_free(serverContext);
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+        std::remove(filePath.c_str());
+    }
+
+    static EVP_PKEY* generateKey()
+    {
+        EVP_PKEY* generated = nullptr;
+        EVP_PKEY_CTX* context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, nullptr);
+        if (context != nullptr && EVP_PKEY_keygen_init(context) == 1 &&
+            EVP_PKEY_CTX_set_ec_paramgen_curve_nid(context, NID_X9_62_prime256v1) == 1) {
+            EVP_PKEY_keygen(context, &generated);
+        }
+        EVP_PKEY_CTX_free(context);
+        return generated;
+    }
+
+    static X509* generateCertificate(EVP_PKEY* key)
+    {
+        X509* generated = X509_new();
+        X509_set_version(generated, 2);
+        ASN1_INTEGER_set(X509_get_serialNumber(generated), 1);
+        X509_gmtime_adj(X509_getm_notBefore(generated), 0);
+        X509_gmtime_adj(X509_getm_notAfter(generated), 60 * 60);
+        X509_set_pubkey(generated, key);
+
+        X509_NAME* name = X509_get_subject_name(generated);
+        X509_NAME_add_entry_by_txt(
+            name, "CN", MBSTRING_ASC, reinterpret_cast<const unsigned char*>("localhost"), -1, -1, 0);
+        X509_set_issuer_name(generated, name);
+        if (X509_sign(generated, key, EVP_sha256()) == 0) {
+            X509_free(generated);
+            return nullptr;
+        }
+        return generated;
+    }
+
+    static SSL_CTX* createClientContext(TLSSessionCache& cache, const std::string& scope)
+    {
+        SSL_CTX* context = SSL_CTX_new(TLS_client_method());
+        SSL_CTX_set_verify(context, SSL_VERIFY_NONE, nullptr); // The certificate is self-signed
+        cache.install(context, scope);
+        return context;
+    }
+
+    // Connects a client made from clientContext to the server, true if the session was resumed
+    bool connect(SSL_CTX* clientContext)
+    {
+        SSL* client = SSL_new(clientContext);
+        SSL* server = SSL_new(serverContext);
+        BIO* clientBio = nullptr;
+        BIO* serverBio = nullptr;
+        BIO_new_bio_pair(&clientBio, 0, &serverBio, 0);
+        SSL_set_bio(client, clientBio, clientBio);
+        SSL_set_bio(server, serverBio, serverBio);
+        SSL_set_tlsext_host_name(client, "localhost");
+        SSL_set_connect_state(client);
+        SSL_set_accept_state(server);
+
+        bool connected = false;
+        for (int attempt = 0; attempt < 100 && !connected; attempt++) {
+            int clientResult = SSL_do_handshake(client);
+            int serverResult = SSL_do_handshake(server);
+            connected = clientResult == 1 && serverResult == 1;
+        }
+        EXPECT_TRUE(connected);
+
+        // TLS 1.3 sends the session tickets after the handshake, reading the data behind them stores them
+        char byte = 'x';
+        EXPECT_EQ(SSL_write(server, &byte, 1), 1);
+        bool received = false;
+        for (int attempt = 0; attempt < 100 && !received; attempt++) {
+            received = SSL_read(client, &byte, 1) == 1;
+        }
+        EXPECT_TRUE(received);
+
+        bool resumed = SSL_session_reused(client) != 0;
+        SSL_shutdown(client);
+        SSL_shutdown(server);
+        SSL_free(client);
+        SSL_free(server);
+        return resumed;
+    }
+
+    std::string filePath;
+    EVP_PKEY* key = nullptr;
+    X509* certificate = nullptr;
+    SSL_CTX* serverContext = nullptr;
+};
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// TLS SESSION CACHE TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(TLSSessionCacheScopeTests, MakeScope)
+{
+    auto scope = TLSSessionCache::makeScope("verify", "ROOT CA");
+    EXPECT_EQ(scope, TLSSessionCache::makeScope("verify", "ROOT CA")); // Stable, it is saved to files
+    EXPECT_EQ(scope.rfind("verify/", 0), 0u);
+    EXPECT_NE(scope, TLSSessionCache::makeScope("noverify", "ROOT CA"));
+    EXPECT_NE(scope, TLSSessionCache::makeScope("verify", "OTHER CA"));
+}
+
+TEST_F(TLSSessionCacheTests, ResumesCachedSession)
+{
+    TLSSessionCache cache;
+    SSL_CTX* clientContext = createClientContext(cache, "test");
+
+    EXPECT_FALSE(connect(clientContext));
+    EXPECT_TRUE(connect(clientContext));
+
+    auto stats = cache.getStats();
+    EXPECT_EQ(stats.full, 1u);
+    EXPECT_EQ(stats.resumed, 1u);
+    EXPECT_EQ(stats.sessions, 1u);
+
+    // A new context with the same scope resumes from the same cache
+    SSL_CTX* otherContext = createClientContext(cache, "test");
+    EXPECT_TRUE(connect(otherContext));
+
+    SSL_CTX_free(otherContext);
+    SSL_CTX_free(clientContext);
+}
+
+TEST_F(TLSSessionCacheTests, FileRoundTrip)
+{
+    {
+        TLSSessionCache cache;
+        EXPECT_TRUE(cache.setFilePath(filePath)); // Nothing saved yet
+        SSL_CTX* clientContext = createClientContext(cache, "test");
+        EXPECT_FALSE(connect(clientContext));
+        EXPECT_TRUE(cache.save());
+        SSL_CTX_free(clientContext);
+    }
+
+    // As after a restart
+    TLSSessionCache cache;
+    EXPECT_TRUE(cache.setFilePath(filePath));
+    EXPECT_EQ(cache.getStats().sessions, 1u);
+
+    SSL_CTX* clientContext = createClientContext(cache, "test");
+    EXPECT_TRUE(connect(clientContext));
+
+    auto stats = cache.getStats();
+    EXPECT_EQ(stats.full, 0u);
+    EXPECT_EQ(stats.resumed, 1u);
+    SSL_CTX_free(clientContext);
+}
+
+TEST_F(TLSSessionCacheTests, OtherScopeDoesNotResume)
+{
+    {
+        TLSSessionCache cache;
+        cache.setFilePath(filePath);
+        SSL_CTX* clientContext = createClientContext(cache, TLSSessionCache::makeScope("noverify", ""));
+        connect(clientContext);
+        SSL_CTX_free(clientContext);
+    } // Saved as it goes away
+
+    TLSSessionCache cache;
+    EXPECT_TRUE(cache.setFilePath(filePath));
+    EXPECT_EQ(cache.getStats().sessions, 1u);
+
+    SSL_CTX* clientContext = createClientContext(cache, TLSSessionCache::makeScope("verify", ""));
+    EXPECT_FALSE(connect(clientContext));
+    EXPECT_EQ(cache.getStats().sessions, 2u);
+    SSL_CTX_free(clientContext);
+}
+
+TEST_F(TLSSessionCacheTests, TruncatedFileFailsToLoad)
+{
+    {
+        TLSSessionCache cache;
+        cache.setFilePath(filePath);
+        SSL_CTX* clientContext = createClientContext(cache, "test");
+        connect(clientContext);
+        SSL_CTX_free(clientContext);
+    }
+
+    std::string saved;
+    {
+        std::ifstream file(filePath, std::ios::binary);
+        saved.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    ASSERT_GT(saved.size(), 16u);
+    {
+        std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+        file.write(saved.data(), static_cast<std::streamsize>(saved.size() - 16));
+    }
+
+    TLSSessionCache cache;
+    EXPECT_FALSE(cache.setFilePath(filePath));
+    EXPECT_EQ(cache.getStats().sessions, 0u);
+}
@@ -0,0 +1,168 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/TimerWheel.hpp"
+
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using dfx::api::utils::TimerWheel;
+using Clock = TimerWheel::Clock;
+
+namespace
+{
+
+// A small wheel so timers a turn or more away are easy to reach. The times passed to it are in
+// whole ticks from its origin rather than the real time, which it never reads after construction.
+class TimerWheelTests : public ::testing::Test
+{
+protected:
+    TimerWheelTests() : wheel(tick, 4) {}
+
+    void SetUp() override
+    {
+        // A deadline already passed is due on the first tick, which gives away where the wheel starts
+        wheel.schedule(0, Clock::time_point::min());
+        origin = wheel.nextExpiry() - tick;
+        ASSERT_TRUE(wheel.cancel(0, Clock::time_point::min()));
+    }
+
+    Clock::time_point at(int ticks) const
+    {
+        return origin + tick * ticks;
+    }
+
+    std::vector<uint32_t> expire(Clock::time_point now)
+    {
+        std::vector<uint32_t> expired;
+        wheel.expire(now, expired);
+        std::sort(expired.begin(), expired.end());
+        return expired;
+    }
+
+    const std::chrono::milliseconds tick = std::chrono::milliseconds(10);
+    TimerWheel wheel;
+    Clock::time_point origin;
+};
+
+using Expired = std::vector<uint32_t>;
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// TIMER WHEEL TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_F(TimerWheelTests, Empty)
+{
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_EQ(wheel.nextExpiry(), Clock::time_point::max());
+    EXPECT_EQ(expire(at(100)), Expired());
+}
+
+TEST_F(TimerWheelTests, NeverExpiresEarly)
+{
+    // Rounded up to the end of the tick it falls in
+    wheel.schedule(1, at(2) + std::chrono::microseconds(1));
+    EXPECT_EQ(wheel.size(), 1u);
+    EXPECT_EQ(wheel.nextExpiry(), at(3));
+
+    EXPECT_EQ(expire(at(2) + std::chrono::microseconds(1)), Expired());
+    EXPECT_EQ(expire(at(3) - std::chrono::microseconds(1)), Expired());
+    EXPECT_EQ(expire(at(3)), Expired({1}));
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_EQ(wheel.nextExpiry(), Clock::time_point::max());
+}
+
+TEST_F(TimerWheelTests, PassedDeadlineExpiresOnNextTick)
+{
+    expire(at(5));
+    wheel.schedule(1, at(2));
+    EXPECT_EQ(wheel.nextExpiry(), at(6));
+    EXPECT_EQ(expire(at(5)), Expired());
+    EXPECT_EQ(expire(at(6)), Expired({1}));
+}
+
+TEST_F(TimerWheelTests, Cancel)
+{
+    wheel.schedule(1, at(3));
+    wheel.schedule(2, at(3));
+    wheel.schedule(3, at(7)); // Same bucket, the next turn
+    EXPECT_EQ(wheel.size(), 3u);
+
+    EXPECT_FALSE(wheel.cancel(1, at(7))); // Not with that deadline
+    EXPECT_FALSE(wheel.cancel(4, at(3)));
+    EXPECT_TRUE(wheel.cancel(1, at(3)));
+    EXPECT_FALSE(wheel.cancel(1, at(3)));
+    EXPECT_EQ(wheel.size(), 2u);
+
+    EXPECT_EQ(expire(at(3)), Expired({2}));
+    EXPECT_FALSE(wheel.cancel(2, at(3))); // Already expired
+
+    EXPECT_TRUE(wheel.cancel(3, at(7)));
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_EQ(expire(at(20)), Expired());
+}
+
+TEST_F(TimerWheelTests, ExpiresAfterFullTurn)
+{
+    wheel.schedule(1, at(10)); // Two and a half turns of the 4 bucket wheel away
+    wheel.schedule(2, at(2));  // Shares its bucket
+
+    EXPECT_EQ(expire(at(3)), Expired({2}));
+    EXPECT_EQ(wheel.size(), 1u);
+    EXPECT_EQ(expire(at(6)), Expired()); // Its bucket is visited again, too early still
+    EXPECT_EQ(expire(at(9)), Expired());
+    EXPECT_EQ(expire(at(10)), Expired({1}));
+    EXPECT_EQ(wheel.size(), 0u);
+}
+
+TEST_F(TimerWheelTests, ExpiresWhenSkippingTurns)
+{
+    wheel.schedule(1, at(1));
+    wheel.schedule(2, at(4));
+    wheel.schedule(3, at(6));
+    wheel.schedule(4, at(50));
+
+    // Many turns at once visits every bucket once
+    EXPECT_EQ(expire(at(21)), Expired({1, 2, 3}));
+    EXPECT_EQ(wheel.size(), 1u);
+    EXPECT_EQ(wheel.nextExpiry(), at(50));
+    EXPECT_EQ(expire(at(49)), Expired());
+    EXPECT_EQ(expire(at(60)), Expired({4}));
+}
+
+TEST_F(TimerWheelTests, NextExpiry)
+{
+    wheel.schedule(1, at(7));
+    wheel.schedule(2, at(3));
+    wheel.schedule(3, at(14));
+    EXPECT_EQ(wheel.nextExpiry(), at(3));
+
+    EXPECT_EQ(expire(at(3)), Expired({2}));
+    EXPECT_EQ(wheel.nextExpiry(), at(7));
+
+    EXPECT_TRUE(wheel.cancel(1, at(7)));
+    EXPECT_EQ(wheel.nextExpiry(), at(14));
+}
+
+TEST_F(TimerWheelTests, NextExpiryAllTurnsAway)
+{
+    // None is due within this turn of the wheel, the first bucket visited holds a later one
+    wheel.schedule(1, at(9));
+    wheel.schedule(2, at(6));
+    wheel.schedule(3, at(13));
+    EXPECT_EQ(wheel.nextExpiry(), at(6));
+}
+
+TEST_F(TimerWheelTests, Clear)
+{
+    wheel.schedule(1, at(1));
+    wheel.schedule(2, at(100));
+    wheel.clear();
+    EXPECT_EQ(wheel.size(), 0u);
+    EXPECT_EQ(wheel.nextExpiry(), Clock::time_point::max());
+    EXPECT_EQ(expire(at(200)), Expired());
+}
@@ -0,0 +1,132 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/websocket/WebSocketBuffer.hpp"
+
+#include <gtest/gtest.h>
+
+#include <cstring>
+
+using dfx::websocket::WebSocketBufferPool;
+using dfx::websocket::WebSocketSendBuffer;
+
+///////////////////////////////////////////////////////////////////////////////
+// WEBSOCKET BUFFER POOL TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(WebSocketBufferPoolTests, SizeClasses)
+{
+    EXPECT_EQ(WebSocketBufferPool::getSizeClass(0), 1024u); // MIN_SIZE_CLASS
+    EXPECT_EQ(WebSocketBufferPool::getSizeClass(1), 1024u);
+    EXPECT_EQ(WebSocketBufferPool::getSizeClass(1024), 1024u);
+    EXPECT_EQ(WebSocketBufferPool::getSizeClass(1025), 2048u);
+    EXPECT_EQ(WebSocketBufferPool::getSizeClass(300 * 1024), 512u * 1024);
+}
+
+TEST(WebSocketBufferPoolTests, AcquireReservesSizeClass)
+{
+    WebSocketBufferPool pool;
+    auto buffer = pool.acquire(1500);
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_GE(buffer.capacity(), 2048u);
+    EXPECT_EQ(pool.getPooledCount(), 0u);
+}
+
+TEST(WebSocketBufferPoolTests, ReleasedBufferIsReused)
+{
+    WebSocketBufferPool pool;
+    auto buffer = pool.acquire(4096);
+    buffer.assign(100, 0xAB);
+    const auto* memory = buffer.data();
+
+    pool.release(std::move(buffer));
+    EXPECT_EQ(pool.getPooledCount(), 1u);
+
+    auto reused = pool.acquire(1000);
+    EXPECT_EQ(reused.data(), memory);
+    EXPECT_TRUE(reused.empty()); // Contents are discarded
+    EXPECT_EQ(pool.getPooledCount(), 0u);
+}
+
+TEST(WebSocketBufferPoolTests, AcquirePicksSmallestThatFits)
+{
+    WebSocketBufferPool pool;
+    auto small = pool.acquire(1024);
+    auto medium = pool.acquire(8192);
+    auto large = pool.acquire(64 * 1024);
+    const auto* mediumMemory = medium.data();
+    const auto* largeMemory = large.data();
+
+    pool.release(std::move(large));
+    pool.release(std::move(small));
+    pool.release(std::move(medium));
+
+    auto fits = pool.acquire(5000);
+    EXPECT_EQ(fits.data(), mediumMemory);
+
+    // Nothing left fits, the largest is grown rather than a small one
+    auto grown = pool.acquire(1024 * 1024);
+    EXPECT_NE(grown.data(), largeMemory);
+    EXPECT_GE(grown.capacity(), 1024u * 1024);
+    EXPECT_EQ(pool.getPooledCount(), 1u);
+}
+
+TEST(WebSocketBufferPoolTests, PoolIsBounded)
+{
+    WebSocketBufferPool pool(2, 16 * 1024);
+
+    pool.release(pool.acquire(32 * 1024)); // Over the maximum capacity
+    EXPECT_EQ(pool.getPooledCount(), 0u);
+
+    pool.release(std::vector<uint8_t>()); // Nothing worth keeping
+    EXPECT_EQ(pool.getPooledCount(), 0u);
+
+    std::vector<std::vector<uint8_t>> buffers;
+    for (int index = 0; index < 3; index++) {
+        buffers.push_back(pool.acquire(1024));
+    }
+    for (auto& buffer : buffers) {
+        pool.release(std::move(buffer));
+    }
+    EXPECT_EQ(pool.getPooledCount(), 2u);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WEBSOCKET SEND BUFFER TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(WebSocketSendBufferTests, PayloadFollowsHeadroom)
+{
+    const size_t headroom = 16;
+    WebSocketSendBuffer buffer(headroom, std::vector<uint8_t>());
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.size(), 0u);
+    EXPECT_EQ(buffer.getHeadroom(), headroom);
+    EXPECT_EQ(buffer.getStorage().size(), headroom);
+
+    buffer.append(std::string("hello "));
+    buffer.append("world", 5);
+    EXPECT_EQ(buffer.size(), 11u);
+    EXPECT_EQ(buffer.getStorage().size(), headroom + 11);
+    EXPECT_EQ(buffer.data(), buffer.getStorage().data() + headroom);
+    EXPECT_EQ(memcmp(buffer.data(), "hello world", 11), 0);
+
+    buffer.resize(5);
+    EXPECT_EQ(memcmp(buffer.data(), "hello", 5), 0);
+
+    buffer.clear();
+    EXPECT_TRUE(buffer.empty());
+    EXPECT_EQ(buffer.getStorage().size(), headroom);
+}
+
+TEST(WebSocketSendBufferTests, ReusesPooledStorage)
+{
+    WebSocketBufferPool pool;
+    auto storage = pool.acquire(4096);
+    const auto* memory = storage.data();
+
+    WebSocketSendBuffer buffer(16, std::move(storage));
+    buffer.reserve(1000);
+    buffer.append(std::string(1000, 'x'));
+    EXPECT_EQ(buffer.getStorage().data(), memory);
+}
@@ -0,0 +1,188 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/websocket/WebSocketEventDispatcher.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <vector>
+
+using dfx::websocket::WebSocketDispatchTarget;
+using dfx::websocket::WebSocketEvent;
+using dfx::websocket::WebSocketEventDispatcher;
+using dfx::websocket::WebSocketEventRing;
+using dfx::websocket::WebSocketEventType;
+
+namespace
+{
+
+// Records the error codes it is called with, holding up the dispatcher until released
+class RecordingTarget
+{
+public:
+    RecordingTarget() : target(std::make_shared<WebSocketDispatchTarget>())
+    {
+        target->callback = [this](const WebSocketEvent& event, void*) {
+            std::unique_lock<std::mutex> lock(mutex);
+            codes.push_back(event.error.code);
+            cv.notify_all();
+            cv.wait(lock, [this] { return released; });
+        };
+    }
+
+    bool waitForCount(size_t count)
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return cv.wait_for(lock, std::chrono::seconds(10), [&] { return codes.size() >= count; });
+    }
+
+    void release()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        released = true;
+        cv.notify_all();
+    }
+
+    std::vector<int> getCodes()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        return codes;
+    }
+
+    std::shared_ptr<WebSocketDispatchTarget> target;
+
+private:
+    std::mutex mutex; // Protect - codes, released
+    std::condition_variable cv;
+    std::vector<int> codes;
+    bool released = false;
+};
+
+WebSocketEvent makeErrorEvent(int code)
+{
+    WebSocketEvent event;
+    event.type = WebSocketEventType::ERROR_EVENT;
+    event.error.code = code;
+    return event;
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// WEBSOCKET EVENT RING TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(WebSocketEventRingTests, FullRingRejectsPush)
+{
+    WebSocketEventRing<int> ring(3); // Rounded up to 4
+    for (int value = 0; value < 4; value++) {
+        EXPECT_TRUE(ring.tryPush(int(value)));
+    }
+    EXPECT_FALSE(ring.tryPush(4));
+
+    int value = -1;
+    EXPECT_TRUE(ring.tryPop(value));
+    EXPECT_EQ(value, 0);
+    EXPECT_TRUE(ring.tryPush(4)); // Room again after a pop, in the next lap
+
+    for (int expected = 1; expected <= 4; expected++) {
+        EXPECT_TRUE(ring.tryPop(value));
+        EXPECT_EQ(value, expected);
+    }
+    EXPECT_TRUE(ring.empty());
+    EXPECT_FALSE(ring.tryPop(value));
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// WEBSOCKET EVENT DISPATCHER TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(WebSocketEventDispatcherTests, DispatchesPayload)
+{
+    WebSocketEvent event;
+    event.type = WebSocketEventType::MESSAGE;
+    event.message.data = std::make_shared<std::vector<uint8_t>>(3, 7);
+    event.message.isText = true;
+
+    std::mutex mutex; // Protect - received
+    std::condition_variable cv;
+    bool received = false;
+
+    WebSocketEventDispatcher dispatcher;
+    auto target = std::make_shared<WebSocketDispatchTarget>();
+    target->callback = [&](const WebSocketEvent& dispatched, void* userData) {
+        EXPECT_EQ(dispatched.type, WebSocketEventType::MESSAGE);
+        EXPECT_EQ(dispatched.message.data, event.message.data);
+        EXPECT_TRUE(dispatched.message.isText);
+        EXPECT_EQ(userData, &dispatcher);
+        EXPECT_TRUE(dispatcher.isDispatcherThread());
+        std::unique_lock<std::mutex> lock(mutex);
+        received = true;
+        cv.notify_all();
+    };
+    target->userData = &dispatcher;
+
+    dispatcher.post(target, event);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    EXPECT_TRUE(cv.wait_for(lock, std::chrono::seconds(10), [&] { return received; }));
+    EXPECT_FALSE(dispatcher.isDispatcherThread());
+}
+
+TEST(WebSocketEventDispatcherTests, OverflowKeepsOrder)
+{
+    const int ringCapacity = 4;
+    const int eventCount = 100; // Far more than the ring holds while the callback is held up
+
+    RecordingTarget recorder; // Outlives the dispatcher thread
+    WebSocketEventDispatcher dispatcher(ringCapacity);
+
+    // The dispatcher takes the first event and stays in its callback, everything after fills the
+    // ring and then spills into the overflow
+    dispatcher.post(recorder.target, makeErrorEvent(0));
+    ASSERT_TRUE(recorder.waitForCount(1));
+    for (int code = 1; code < eventCount; code++) {
+        dispatcher.post(recorder.target, makeErrorEvent(code));
+    }
+
+    // Posted once the dispatcher has started on the ring, these must still follow the overflow
+    recorder.release();
+    for (int code = eventCount; code < 2 * eventCount; code++) {
+        dispatcher.post(recorder.target, makeErrorEvent(code));
+    }
+
+    ASSERT_TRUE(recorder.waitForCount(2 * eventCount));
+    auto codes = recorder.getCodes();
+    ASSERT_EQ(codes.size(), size_t(2 * eventCount));
+    for (int code = 0; code < 2 * eventCount; code++) {
+        EXPECT_EQ(codes[code], code);
+    }
+}
+
+TEST(WebSocketEventDispatcherTests, InactiveTargetIsSkipped)
+{
+    RecordingTarget held;
+    RecordingTarget dropped;
+    WebSocketEventDispatcher dispatcher(2);
+
+    dispatcher.post(held.target, makeErrorEvent(0));
+    ASSERT_TRUE(held.waitForCount(1));
+
+    for (int code = 1; code < 10; code++) {
+        dispatcher.post(dropped.target, makeErrorEvent(code));
+    }
+    {
+        std::unique_lock<std::recursive_mutex> lock(dropped.target->mutex); // Protect - active
+        dropped.target->active = false;
+    }
+    dispatcher.post(held.target, makeErrorEvent(10));
+
+    held.release();
+    dropped.release();
+    ASSERT_TRUE(held.waitForCount(2));
+    EXPECT_EQ(held.getCodes(), std::vector<int>({0, 10}));
+    EXPECT_TRUE(dropped.getCodes().empty());
+}
@@ -0,0 +1,159 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/api/utils/TimerWheel.hpp"
+#include "dfx/websocket/WebSocket.hpp"
+
+#include <gtest/gtest.h>
+
+#include <chrono>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using dfx::api::utils::TimerWheel;
+using dfx::websocket::Status;
+using dfx::websocket::WebSocket;
+using dfx::websocket::WebSocketSendBuffer;
+using dfx::websocket::WebSocketState;
+
+namespace
+{
+
+// Holds on to what is sent until the test writes or discards it, like a connection on a stalled uplink
+class QueueingWebSocket : public WebSocket
+{
+public:
+    QueueingWebSocket()
+    {
+        setState(WebSocketState::OPEN);
+    }
+
+    void setRootCertificate(const std::string&) override {}
+    void setLogLevel(uint8_t, dfx::websocket::LogCallback) override {}
+    void open(const std::string&, const std::string&) override {}
+    void close() override {}
+    void sendUTF8(const std::string&) override {}
+    void sendBinary(const std::vector<uint8_t>&) override {}
+
+    size_t queued()
+    {
+        std::unique_lock<std::mutex> lock(mutex); // Protect - queue
+        return queue.size();
+    }
+
+    void writeNext()
+    {
+        releaseSendBuffer(takeNext(), true);
+    }
+
+    void discardNext()
+    {
+        releaseSendBuffer(takeNext());
+    }
+
+protected:
+    void enqueueSend(std::unique_ptr<WebSocketSendBuffer> buffer) override
+    {
+        std::unique_lock<std::mutex> lock(mutex); // Protect - queue
+        queue.push_back(std::move(buffer));
+    }
+
+private:
+    std::unique_ptr<WebSocketSendBuffer> takeNext()
+    {
+        std::unique_lock<std::mutex> lock(mutex); // Protect - queue
+        auto buffer = std::move(queue.front());
+        queue.pop_front();
+        return buffer;
+    }
+
+    std::mutex mutex; // Protect - queue
+    std::deque<std::unique_ptr<WebSocketSendBuffer>> queue;
+};
+
+std::unique_ptr<WebSocketSendBuffer> makeRequest(WebSocket& socket, int& written)
+{
+    auto buffer = socket.acquireSendBuffer(16);
+    buffer->append("05060506000042{}");
+    buffer->setWrittenCallback([&written]() { written++; });
+    return buffer;
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// WEBSOCKET SEND QUEUE TESTS
+///////////////////////////////////////////////////////////////////////////////
+
+TEST(WebSocketSendQueueTests, WrittenCallbackRunsOnceWritten)
+{
+    QueueingWebSocket socket;
+    int written = 0;
+    socket.send(makeRequest(socket, written));
+    EXPECT_EQ(written, 0); // Queued is not written
+    EXPECT_EQ(socket.getSendQueueStatus().messages, 1u);
+
+    socket.writeNext();
+    EXPECT_EQ(written, 1);
+    EXPECT_EQ(socket.getSendQueueStatus().messages, 0u);
+}
+
+TEST(WebSocketSendQueueTests, DiscardedIsNotWritten)
+{
+    QueueingWebSocket socket;
+    int written = 0;
+    auto buffer = makeRequest(socket, written);
+    ASSERT_EQ(socket.trySend(buffer, 0), Status::OK);
+    socket.discardNext(); // As when the connection closes with it still queued
+    EXPECT_EQ(written, 0);
+    EXPECT_EQ(socket.getSendQueueStatus().messages, 0u);
+}
+
+TEST(WebSocketSendQueueTests, QueuedLongerThanRequestTimeout)
+{
+    // The transports start a request's timeout from its written callback, as here
+    const auto timeout = std::chrono::milliseconds(20);
+    TimerWheel timers(std::chrono::milliseconds(1), 64);
+    std::mutex timersMutex; // Protect - timers
+    auto schedule = [&timers, &timersMutex, timeout](uint32_t sequence) {
+        std::unique_lock<std::mutex> lock(timersMutex); // Protect - timers
+        timers.schedule(sequence, TimerWheel::Clock::now() + timeout);
+    };
+    auto expire = [&timers, &timersMutex]() {
+        std::unique_lock<std::mutex> lock(timersMutex); // Protect - timers
+        std::vector<uint32_t> expired;
+        timers.expire(TimerWheel::Clock::now(), expired);
+        return expired;
+    };
+
+    QueueingWebSocket socket;
+    socket.setSendQueueLimits(0, 1);
+
+    auto first = socket.acquireSendBuffer(16);
+    first->append("first");
+    first->setWrittenCallback([&schedule]() { schedule(1); });
+    ASSERT_EQ(socket.trySend(first, 0), Status::OK);
+
+    // The second waits for room behind the first, far longer than the timeout, and then sits queued
+    auto second = socket.acquireSendBuffer(16);
+    second->append("second");
+    second->setWrittenCallback([&schedule]() { schedule(2); });
+    auto blocked = std::async(std::launch::async, [&socket, &second]() { return socket.trySend(second, 10 * 1000); });
+    std::this_thread::sleep_for(timeout * 3);
+    EXPECT_TRUE(expire().empty());
+
+    socket.writeNext();
+    ASSERT_EQ(blocked.get(), Status::OK);
+    EXPECT_EQ(socket.queued(), 1u);
+    std::this_thread::sleep_for(timeout * 3);
+
+    // Only the one written has been waiting on its response long enough to time out
+    EXPECT_EQ(expire(), std::vector<uint32_t>({1}));
+    socket.writeNext();
+    EXPECT_TRUE(expire().empty());
+    std::this_thread::sleep_for(timeout * 3);
+    EXPECT_EQ(expire(), std::vector<uint32_t>({2}));
+}
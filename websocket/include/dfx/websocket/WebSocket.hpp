@@ -5,6 +5,10 @@
 #ifndef DFXAPI_WEBSOCKET_HPP
 #define DFXAPI_WEBSOCKET_HPP
 
+#include "dfx/websocket/WebSocketBuffer.hpp"
+
+#include <chrono>
+#include <condition_variable>
 #include <cstdint>
 #include <deque>
 #include <functional>
@@ -17,6 +21,8 @@ namespace dfx::websocket
 {
 
 class WebSocket;
+class WebSocketEventDispatcher;
+struct WebSocketDispatchTarget;
 
 enum class WebSocketState
 {
@@ -35,7 +41,10 @@ enum class WebSocketEventType
     CONNECTION,  // Connection event notification (for servers).
     MESSAGE,     // Message received, event contains WebSocketMessageEvent.
 
-    CLOSED
+    CLOSED,
+
+    SEND_QUEUE_HIGH, // Queued send bytes reached the high water mark.
+    SEND_QUEUE_LOW   // Queued send bytes drained back to the low water mark.
 };
 
 // Status of the method call.
@@ -43,7 +52,8 @@ enum class Status
 {
     OK,
     FAILURE,
-    TIMEOUT
+    TIMEOUT,
+    WOULD_BLOCK // Send queue is full
 };
 
 struct WebSocketErrorEvent
@@ -69,6 +79,19 @@ struct WebSocketEvent
     WebSocketMessageEvent message;
 };
 
+struct WebSocketSendQueueStatus
+{
+    size_t messages = 0;       // Messages queued and not yet written to the connection
+    size_t bytes = 0;          // Payload bytes of the queued messages
+    uint64_t oldestMillis = 0; // How long the oldest queued message has waited
+};
+
+struct WebSocketCompression
+{
+    bool enabled = false;    // Offer permessage-deflate when connecting
+    uint8_t windowBits = 15; // LZ77 window size for either direction, 9 to 15
+};
+
 typedef std::function<void(const WebSocketEvent&, void*)> WebSocketEventCallback;
 
 typedef std::function<void(uint8_t, const char*)> LogCallback;
@@ -87,18 +110,37 @@ public:
      */
     static std::shared_ptr<WebSocket> create(int logLevel, LogCallback callback);
 
-    virtual ~WebSocket() = default;
+    virtual ~WebSocket();
 
     /**
      * Asynchronously get notified of events as they are received by setting up a callback.
+     *
+     * Without an event dispatcher the callback runs on the thread which received the event, for the
+     * libwebsocket implementation that is a service thread shared with every other connection of the
+     * event loop. Anything it runs, including request completions, holds up all of those connections
+     * so it should be quick or the events should be routed through setEventDispatcher.
      */
     void setEventCallback(const WebSocketEventCallback& callback, void* userData);
 
     /**
-     * Synchronously poll events, waiting for timeout. 0 is indefinite.
+     * Run the event callback from the dispatcher's thread rather than the thread which received the
+     * event, so a slow callback does not hold up network I/O. Must be called before setEventCallback,
+     * nullptr (the default) calls the callback directly.
+     */
+    void setEventDispatcher(std::shared_ptr<WebSocketEventDispatcher> dispatcher);
+
+    /**
+     * Synchronously poll events, waiting up to timeout milliseconds for one to arrive. 0 is indefinite.
+     * Returns TIMEOUT if no event arrived in time.
      */
     Status getEvent(WebSocketEvent& event, uint32_t timeout);
 
+    /**
+     * Like getEvent() but appends up to maxEvents of the events already queued to events in one go,
+     * waiting up to timeout milliseconds only if none are queued. Returns TIMEOUT if none arrived.
+     */
+    Status getEvents(std::vector<WebSocketEvent>& events, size_t maxEvents, uint32_t timeout);
+
     void setState(WebSocketState state);
 
     WebSocketState getState();
@@ -110,6 +152,25 @@ public:
 
     virtual void setLogLevel(uint8_t level, LogCallback function) = 0;
 
+    /**
+     * Compression to negotiate with the server, must be set before open(). The server may decline it.
+     */
+    virtual void setCompression(const WebSocketCompression& compression);
+
+    /**
+     * Size of the buffer the transport reads each connection's frames into, must be set before open().
+     * Zero, the default, starts with a small buffer and reassembles larger messages from the pieces
+     * read so idle connections hold little memory. A fixed size suits connections which always
+     * receive messages of a known large size.
+     */
+    virtual void setReceiveBufferSize(uint32_t size);
+
+    /**
+     * File the process wide TLS session cache is loaded from and saved to so connections after a
+     * restart can resume their session, rather than only those made by this process.
+     */
+    virtual void setTLSSessionFile(const std::string& filePath);
+
     virtual void open(const std::string& uri, const std::string& protocol) = 0;
 
     virtual void close() = 0;
@@ -119,8 +180,58 @@ public:
     // Sends the given block of raw memory data out to the connected server.
     virtual void sendBinary(const std::vector<uint8_t>& data) = 0;
 
+    /**
+     * Lease a buffer to build an outgoing message in place, sizeHint is the expected payload size.
+     * Once filled pass it to send(), the memory is returned to a pool after it has been written.
+     */
+    std::unique_ptr<WebSocketSendBuffer> acquireSendBuffer(size_t sizeHint = 0);
+
+    // Sends a buffer from acquireSendBuffer() out to the connected server without copying it.
+    void send(std::unique_ptr<WebSocketSendBuffer> buffer);
+
+    /**
+     * Sends a buffer like send() but honours the send queue limits. If the queue is full it waits
+     * up to timeoutMillis for room, 0 does not wait, and returns WOULD_BLOCK leaving the buffer with
+     * the caller. FAILURE is returned if the connection closes while waiting.
+     */
+    Status trySend(std::unique_ptr<WebSocketSendBuffer>& buffer, uint32_t timeoutMillis);
+
+    /**
+     * Limits the messages trySend() will queue, 0 is unlimited. send() always queues but what it
+     * queues counts toward the limits.
+     */
+    void setSendQueueLimits(size_t maxBytes, size_t maxMessages);
+
+    /**
+     * A SEND_QUEUE_HIGH event is raised when the queued bytes reach highBytes and a SEND_QUEUE_LOW
+     * event once they drain back to lowBytes. A highBytes of 0 disables the notifications.
+     */
+    void setSendQueueWaterMarks(size_t highBytes, size_t lowBytes);
+
+    WebSocketSendQueueStatus getSendQueueStatus();
+
 protected:
-    WebSocket();
+    /**
+     * @param sendHeadroom bytes the implementation needs in front of each outgoing payload.
+     */
+    explicit WebSocket(size_t sendHeadroom = 0);
+
+    // Queue a buffer for the implementation to write to the connection.
+    virtual void enqueueSend(std::unique_ptr<WebSocketSendBuffer> buffer) = 0;
+
+    // Return a buffer once the implementation has finished writing or has discarded it, written runs
+    // its written callback.
+    void releaseSendBuffer(std::unique_ptr<WebSocketSendBuffer> buffer, bool written = false);
+
+    // Spare capacity left after a received message so parsers which read ahead of the end, like simdjson,
+    // can read it in place
+    static const size_t RECEIVE_PADDING = 64;
+
+    // An empty buffer to reassemble an incoming message into, sizeHint is the expected message size.
+    std::vector<uint8_t> acquireReceiveBuffer(size_t sizeHint);
+
+    // Hands a reassembled message to the event, the memory returns to the pool once the last reference is dropped.
+    std::shared_ptr<std::vector<uint8_t>> shareReceiveBuffer(std::vector<uint8_t>&& buffer);
 
     /**
      * Helper for the implementation to pass received events from the server back to
@@ -150,8 +261,41 @@ private:
     WebSocketEventCallback onEventCallback;
     void* eventUserData;
 
-    std::mutex pendingEventsMutex;
+    std::shared_ptr<WebSocketEventDispatcher> eventDispatcher;
+    std::shared_ptr<WebSocketDispatchTarget> dispatchTarget; // Where events go when there is a dispatcher
+
+    // Stops any events already handed to the dispatcher from reaching the current callback
+    void deactivateDispatchTarget();
+
+    std::mutex pendingEventsMutex; // Protect - pendingEvents
+    std::condition_variable cvPendingEvents;
     std::deque<WebSocketEvent> pendingEvents;
+
+    // Waits for pendingEvents to have something, lock must hold pendingEventsMutex
+    bool waitPendingEvents(std::unique_lock<std::mutex>& lock, uint32_t timeout);
+
+    // Account for a message entering the send queue, returns true if it took the queue over the high water
+    // mark. The lock must hold sendQueueMutex so a caller can reserve the room it checked for.
+    bool sendQueued(std::unique_lock<std::mutex>& lock, size_t bytes);
+
+    // Let the client know the send queue went over the high water mark, the lock must not be held
+    void notifySendQueueHigh();
+
+    size_t sendHeadroom;
+    WebSocketBufferPool bufferPool;
+
+    std::mutex sendQueueMutex; // Protect - sendQueueStatus, sendQueueTimes, limits, water marks
+    std::condition_variable cvSendQueue;
+    WebSocketSendQueueStatus sendQueueStatus;
+    std::deque<std::chrono::steady_clock::time_point> sendQueueTimes; // When each queued message was queued
+    size_t sendQueueMaxBytes;
+    size_t sendQueueMaxMessages;
+    size_t sendQueueHighWaterMark;
+    size_t sendQueueLowWaterMark;
+    bool sendQueueAboveHighWaterMark;
+
+    // Received messages may outlive the socket, their deleter holds a weak reference to the pool
+    std::shared_ptr<WebSocketBufferPool> receivePool;
 };
 
 } // namespace dfx::websocket
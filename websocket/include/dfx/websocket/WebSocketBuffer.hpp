@@ -0,0 +1,105 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFXAPI_WEBSOCKETBUFFER_HPP
+#define DFXAPI_WEBSOCKETBUFFER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace dfx::websocket
+{
+
+/**
+ * A small pool of byte vectors so the memory behind frequently sent and received messages is
+ * reused rather than allocated per message. Capacities are rounded up to power of two size
+ * classes so messages of similar size share buffers. Vectors larger than the maximum capacity
+ * are not kept, and at most maxBuffers are held at any time.
+ */
+class WebSocketBufferPool
+{
+public:
+    static const size_t DEFAULT_MAX_BUFFERS = 8;
+    static const size_t DEFAULT_MAX_BUFFER_CAPACITY = 4 * 1024 * 1024;
+    static const size_t MIN_SIZE_CLASS = 1024;
+
+    explicit WebSocketBufferPool(size_t maxBuffers = DEFAULT_MAX_BUFFERS,
+                                 size_t maxBufferCapacity = DEFAULT_MAX_BUFFER_CAPACITY);
+
+    /**
+     * An empty vector with at least capacity bytes reserved.
+     */
+    std::vector<uint8_t> acquire(size_t capacity);
+
+    /**
+     * Return a vector for reuse, its contents are discarded.
+     */
+    void release(std::vector<uint8_t>&& buffer);
+
+    size_t getPooledCount();
+
+    // The capacity a buffer for size bytes is allocated with
+    static size_t getSizeClass(size_t size);
+
+private:
+    const size_t maxBuffers;
+    const size_t maxBufferCapacity;
+
+    std::mutex mutex; // Protect - buffers
+    std::vector<std::vector<uint8_t>> buffers;
+};
+
+/**
+ * An outgoing message leased from a WebSocket with acquireSendBuffer().
+ *
+ * Space the WebSocket implementation needs ahead of the payload (LWS_PRE for libwebsockets) is
+ * reserved so transports can serialize the message directly into data() and hand the buffer to
+ * WebSocket::send() which writes it in place, returning the memory to the pool afterwards.
+ */
+class WebSocketSendBuffer
+{
+public:
+    WebSocketSendBuffer(size_t headroom, std::vector<uint8_t>&& storage);
+
+    // The payload, starting after the headroom
+    uint8_t* data();
+    const uint8_t* data() const;
+    size_t size() const;
+    bool empty() const;
+
+    void reserve(size_t size);
+    void resize(size_t size);
+    void clear();
+
+    void append(const void* bytes, size_t length);
+    void append(const std::string& bytes);
+
+    size_t getHeadroom() const;
+
+    /**
+     * Called once the message has been written to the connection, not while it waits in the send
+     * queue nor if it is discarded unwritten. Runs on the thread doing the write so should be quick.
+     */
+    void setWrittenCallback(std::function<void()> callback);
+
+    // Headroom followed by payload, used by the WebSocket implementation
+    std::vector<uint8_t>& getStorage();
+
+    // Runs the written callback if there is one, used by the WebSocket implementation
+    void notifyWritten();
+
+private:
+    size_t headroom;
+    std::vector<uint8_t> storage;
+    std::function<void()> writtenCallback;
+};
+
+} // namespace dfx::websocket
+
+#endif // DFXAPI_WEBSOCKETBUFFER_HPP
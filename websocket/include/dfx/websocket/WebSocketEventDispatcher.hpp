@@ -0,0 +1,188 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFXAPI_WEBSOCKETEVENTDISPATCHER_HPP
+#define DFXAPI_WEBSOCKETEVENTDISPATCHER_HPP
+
+#include "dfx/websocket/WebSocket.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <variant>
+
+namespace dfx::websocket
+{
+
+/**
+ * Bounded multi-producer single-consumer ring, producers never take a lock. Each cell carries a
+ * sequence number which tells a producer the cell is free for its position and the consumer that
+ * the value has been published. Capacity is rounded up to a power of two.
+ */
+template <typename T>
+class WebSocketEventRing
+{
+public:
+    explicit WebSocketEventRing(size_t capacity) : enqueuePosition(0), dequeuePosition(0)
+    {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask = size - 1;
+        cells = std::make_unique<Cell[]>(size);
+        for (size_t index = 0; index < size; index++) {
+            cells[index].sequence.store(index, std::memory_order_relaxed);
+        }
+    }
+
+    WebSocketEventRing(const WebSocketEventRing&) = delete;
+    WebSocketEventRing& operator=(const WebSocketEventRing&) = delete;
+
+    // Any thread, false if the ring is full
+    bool tryPush(T&& value)
+    {
+        Cell* cell;
+        size_t position = enqueuePosition.load(std::memory_order_relaxed);
+        while (true) {
+            cell = &cells[position & mask];
+            auto sequence = cell->sequence.load(std::memory_order_acquire);
+            auto difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                return false; // Cell still holds a value from the previous lap
+            } else {
+                position = enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+        cell->value = std::move(value);
+        cell->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer thread only, false if the ring is empty
+    bool tryPop(T& value)
+    {
+        Cell& cell = cells[dequeuePosition & mask];
+        auto sequence = cell.sequence.load(std::memory_order_acquire);
+        if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeuePosition + 1) < 0) {
+            return false;
+        }
+        value = std::move(cell.value);
+        cell.sequence.store(dequeuePosition + mask + 1, std::memory_order_release);
+        dequeuePosition++;
+        return true;
+    }
+
+    // Consumer thread only
+    bool empty() const
+    {
+        const Cell& cell = cells[dequeuePosition & mask];
+        auto sequence = cell.sequence.load(std::memory_order_acquire);
+        return static_cast<intptr_t>(sequence) - static_cast<intptr_t>(dequeuePosition + 1) < 0;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence;
+        T value;
+    };
+
+    std::unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) std::atomic<size_t> enqueuePosition;
+    alignas(64) size_t dequeuePosition;
+};
+
+/**
+ * The callback a socket dispatches its events to. The socket deactivates it when the callback
+ * changes or the socket goes away so events still in flight are dropped, mutex is held while
+ * the callback runs so deactivating waits out a callback in progress on another thread.
+ */
+struct WebSocketDispatchTarget
+{
+    std::recursive_mutex mutex; // Protect - active, recursive as a callback may destroy its own socket
+    WebSocketEventCallback callback;
+    void* userData = nullptr;
+    bool active = true;
+};
+
+/**
+ * WebSocketEventDispatcher runs socket event callbacks from its own thread rather than the
+ * service thread which received them, so a slow application callback does not hold up network
+ * I/O for every connection on that service thread.
+ *
+ * Service threads push a compact copy of each event into a lock-free ring. Should the ring fill
+ * up because the callbacks can not keep up, events spill into an overflow list rather than
+ * blocking the service thread and are dispatched in order once the ring has drained. Events of
+ * a socket are always dispatched in the order they were received.
+ *
+ * A process wide instance is available from getShared(), a socket uses it once
+ * WebSocket::setEventDispatcher() has been called. Callbacks must not destroy the dispatcher
+ * running them.
+ */
+class WebSocketEventDispatcher
+{
+public:
+    static const size_t DEFAULT_CAPACITY = 1024;
+
+    explicit WebSocketEventDispatcher(size_t capacity = DEFAULT_CAPACITY);
+
+    ~WebSocketEventDispatcher();
+
+    WebSocketEventDispatcher(const WebSocketEventDispatcher&) = delete;
+    WebSocketEventDispatcher& operator=(const WebSocketEventDispatcher&) = delete;
+
+    /**
+     * The process wide dispatcher, created on first use.
+     */
+    static std::shared_ptr<WebSocketEventDispatcher> getShared();
+
+    /**
+     * Queue the event for the target's callback, called from the thread which received it.
+     */
+    void post(const std::shared_ptr<WebSocketDispatchTarget>& target, const WebSocketEvent& event);
+
+    // True when called from a callback this dispatcher is running
+    bool isDispatcherThread() const;
+
+private:
+    // Only the payload the event type needs, rather than both as WebSocketEvent carries
+    struct DispatchedEvent
+    {
+        std::shared_ptr<WebSocketDispatchTarget> target;
+        WebSocketEventType type = WebSocketEventType::CLOSED;
+        std::variant<std::monostate, WebSocketErrorEvent, WebSocketMessageEvent> payload;
+    };
+
+    void dispatch(DispatchedEvent& dispatched);
+
+    void dispatcherThreadRunnable();
+
+    WebSocketEventRing<DispatchedEvent> ring;
+
+    std::mutex overflowMutex; // Protect - overflow
+    std::deque<DispatchedEvent> overflow;
+    std::atomic<bool> overflowing; // Producers use overflow until the dispatcher has emptied it
+
+    std::mutex mutex; // Protect - waiting on cvWake
+    std::condition_variable cvWake;
+    std::atomic<bool> sleeping;
+    std::atomic<bool> stopping;
+
+    std::thread dispatcherThread;
+};
+
+} // namespace dfx::websocket
+
+#endif // DFXAPI_WEBSOCKETEVENTDISPATCHER_HPP
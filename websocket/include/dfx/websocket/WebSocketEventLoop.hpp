@@ -0,0 +1,163 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#pragma once
+#ifndef DFXAPI_WEBSOCKETEVENTLOOP_HPP
+#define DFXAPI_WEBSOCKETEVENTLOOP_HPP
+
+#include "dfx/websocket/WebSocket.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <libwebsockets.h>
+
+struct x509_store_st; // OpenSSL X509_STORE
+
+namespace dfx::websocket
+{
+
+class WebSocketLibWebSocket;
+
+/**
+ * WebSocketEventLoop drives every WebSocketLibWebSocket connection registered with it from a
+ * small fixed pool of service threads, rather than each connection creating its own lws_context
+ * and service thread.
+ *
+ * libwebsockets is built without LWS_MAX_SMP so a context may only ever be serviced by a single
+ * thread. Each service thread therefore owns one lws_context and a connection is bound to the
+ * least loaded service thread when it is opened. All libwebsocket calls for a connection are
+ * made from the thread it is bound to, other threads post commands which wake the service thread
+ * with lws_cancel_service. Service threads block in lws_service until there is network activity,
+ * a lws timer or a posted command so idle connections cost no CPU.
+ *
+ * Event callbacks of the connections run on their service thread unless they use a
+ * WebSocketEventDispatcher, so a slow callback stalls every connection bound to the same thread.
+ * A connection's final CLOSED or ERROR_EVENT is delivered before close() is released, once close()
+ * returns no further callback for it will run.
+ *
+ * Root certificates are parsed once per event loop into a trust store which the SSL_CTX of every
+ * vhost using them shares, connections never touch the disk for them.
+ *
+ * A process wide instance is available from getShared() which is what WebSocket::create()
+ * uses, applications which want to own the threads can construct their own and provide it to
+ * the WebSocketLibWebSocket constructor.
+ */
+class WebSocketEventLoop
+{
+public:
+    static const uint16_t DEFAULT_SERVICE_THREADS = 2;
+
+    explicit WebSocketEventLoop(uint16_t serviceThreads = DEFAULT_SERVICE_THREADS);
+
+    ~WebSocketEventLoop();
+
+    WebSocketEventLoop(const WebSocketEventLoop&) = delete;
+    WebSocketEventLoop& operator=(const WebSocketEventLoop&) = delete;
+
+    /**
+     * The process wide event loop, created on first use.
+     */
+    static std::shared_ptr<WebSocketEventLoop> getShared();
+
+    uint16_t getServiceThreadCount() const;
+
+    /**
+     * The number of connections currently bound to a service thread of this event loop.
+     */
+    size_t getConnectionCount() const;
+
+    // Installs the trust store for the vhost wsi belongs to and the TLS session cache into the SSL_CTX lws is
+    // setting up for it
+    static void loadVerifyCerts(struct lws* wsi, void* sslContext);
+
+private:
+    friend class WebSocketLibWebSocket;
+
+    enum class CommandType
+    {
+        CONNECT,  // Create the lws client connection for the socket.
+        WRITABLE, // Socket has queued data, ask lws for a writeable callback.
+        CLOSE,    // Start a close of the socket connection.
+        DESTROY   // Socket is being destroyed, detach it from any remaining connection.
+    };
+
+    struct Command
+    {
+        CommandType type;
+        WebSocketLibWebSocket* socket;
+    };
+
+    struct VHost
+    {
+        std::string name;
+        std::string deflateOffer;
+        std::string sessionScope; // TLSSessionCache scope of the vhost's SSL_CTX
+        std::array<struct lws_extension, 2> extensions; // permessage-deflate when offered, then terminator
+        std::array<struct lws_protocols, 3> protocols;  // proto and json with the vhost's rx buffer, then terminator
+        struct x509_store_st* trustStore = nullptr;     // Owned by trustStores
+        struct lws_vhost* vhost = nullptr;
+    };
+
+    struct ServiceThread
+    {
+        WebSocketEventLoop* eventLoop = nullptr;
+        struct lws_context* context = nullptr;
+        std::thread thread;
+        std::atomic<bool> stopping{false};
+        std::atomic<size_t> connections{0};
+
+        std::mutex mutex; // Protect - pendingCommands
+        std::deque<Command> pendingCommands;
+
+        // Only accessed from the service thread itself, lws keeps a reference to the vhost name, extensions and
+        // protocols
+        std::map<std::string, VHost> vhosts;
+    };
+
+    // Binds a socket to the least loaded service thread
+    ServiceThread* attach();
+
+    // Releases the binding made by attach
+    void detach(ServiceThread* serviceThread);
+
+    // Queue a command for the service thread to run against the socket and wake the thread
+    void post(ServiceThread* serviceThread, CommandType type, WebSocketLibWebSocket* socket);
+
+    // Drops any queued commands for the socket
+    void cancel(ServiceThread* serviceThread, WebSocketLibWebSocket* socket);
+
+    // Runs any queued commands, must be called from the service thread
+    void runPendingCommands(ServiceThread* serviceThread);
+
+    // The vhost for connections using the provided PEM root CA, compression and rx buffer size (0 for the
+    // adaptive default), must be called from the service thread
+    struct lws_vhost* getVHost(ServiceThread* serviceThread,
+                               const std::string& rootCA,
+                               const WebSocketCompression& compression,
+                               uint32_t receiveBufferSize);
+
+    // The parsed rootCA shared by all service threads, nullptr if it holds no certificates
+    struct x509_store_st* getTrustStore(const std::string& rootCA);
+
+    bool isServiceThread(const ServiceThread* serviceThread) const;
+
+    void serviceThreadRunnable(ServiceThread* serviceThread);
+
+    std::vector<std::unique_ptr<ServiceThread>> serviceThreads;
+
+    std::mutex trustStoresMutex; // Protect - trustStores
+    std::map<std::string, struct x509_store_st*> trustStores;
+};
+
+} // namespace dfx::websocket
+
+#endif // DFXAPI_WEBSOCKETEVENTLOOP_HPP
@@ -6,7 +6,9 @@
 #define DFXAPI_WEBSOCKETLIBWEBSOCKET_HPP
 
 #include "dfx/websocket/WebSocket.hpp"
+#include "dfx/websocket/WebSocketEventLoop.hpp"
 
+#include <atomic>
 #include <condition_variable>
 #include <cstdint>
 #include <deque>
@@ -24,12 +26,20 @@ class WebSocketLibWebSocket : public WebSocket
 public:
     WebSocketLibWebSocket(int logLevel, LogCallback callback);
 
+    WebSocketLibWebSocket(int logLevel, LogCallback callback, std::shared_ptr<WebSocketEventLoop> eventLoop);
+
     ~WebSocketLibWebSocket() override;
 
     void setLogLevel(uint8_t level, LogCallback function) override;
 
     void setRootCertificate(const std::string& rootCA) override;
 
+    void setCompression(const WebSocketCompression& compression) override;
+
+    void setReceiveBufferSize(uint32_t size) override;
+
+    void setTLSSessionFile(const std::string& filePath) override;
+
     void open(const std::string& inputURL, const std::string& protocol) override;
 
     void close() override;
@@ -44,24 +54,56 @@ public:
     static void
     dfx_wss_log_callback(struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len);
 
+protected:
+    void enqueueSend(std::unique_ptr<WebSocketSendBuffer> buffer) override;
+
 private:
-    void sendFormattedBinaryBuffer(std::shared_ptr<std::vector<uint8_t>> buffer);
+    friend class WebSocketEventLoop;
 
     int handleEvent(struct lws* wsi, enum lws_callback_reasons reason, void* in, size_t len);
 
-    void serviceThreadRunnable();
+    // Run by the event loop on the service thread this socket is bound to
+    void connectOnServiceThread();
+    void writableOnServiceThread();
+    void closeOnServiceThread();
+    void destroyOnServiceThread();
 
-    std::mutex mutex;
-    std::unique_ptr<std::thread> serviceThread;
+    // Connection is gone, mark closed, deliver the final event if any and then release the binding to the
+    // service thread which lets close() return
+    void releaseConnection(const WebSocketEvent* event = nullptr);
 
-    std::mutex shutdownMutex;
-    bool serviceThreadJoined;
+    std::shared_ptr<WebSocketEventLoop> eventLoop;
+    WebSocketEventLoop::ServiceThread* serviceThread;
 
-    std::string certFilePath;
+    std::mutex mutex; // Protect - pendingSendData
 
-    std::deque<std::shared_ptr<std::vector<uint8_t>>> pendingSendData;
-    struct lws_context* context;
+    std::mutex shutdownMutex; // Protect - attached, destroyed
+    std::condition_variable cvShutdown;
+    bool attached;
+    bool destroyed;
+
+    std::string rootCertificate; // PEM root CA bundle, empty uses the system trust store
+
+    // Connection details parsed by open() for the service thread to connect with
+    std::string address;
+    std::string path;
+    std::string protocolName;
+    int port;
+    bool useSSL;
+    WebSocketCompression compression;
+    uint32_t receiveBufferSize; // lws rx buffer, 0 for the adaptive default
+
+    std::deque<std::unique_ptr<WebSocketSendBuffer>> pendingSendData;
+    std::atomic<bool> writableRequested; // A WRITABLE command is already queued
+
+    // Only accessed from the service thread
     struct lws* wsi;
+    bool established;
+
+    // Message being reassembled from its fragments, only accessed from the service thread
+    std::vector<uint8_t> receiveBuffer;
+    bool receiveIsText;
+    size_t receiveSizeHint; // Size of the last message which arrived over several callbacks
 };
 
 } // namespace dfx::websocket
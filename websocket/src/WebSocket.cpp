@@ -2,12 +2,19 @@
 // See LICENSE.txt in the project root for license information.
 
 #include "dfx/websocket/WebSocket.hpp"
+#include "dfx/websocket/WebSocketEventDispatcher.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <iterator>
 #include <memory>
 #include <stdarg.h> // va_start, va_end
 
 using dfx::websocket::WebSocket;
+using dfx::websocket::WebSocketBufferPool;
+using dfx::websocket::WebSocketCompression;
 using dfx::websocket::WebSocketEvent;
+using dfx::websocket::WebSocketEventType;
 using dfx::websocket::WebSocketState;
 
 #ifndef __EMSCRIPTEN__
@@ -26,7 +33,168 @@ std::shared_ptr<WebSocket> WebSocket::create(int logLevel, LogCallback callback)
 uint8_t WebSocket::logLevel = 0;
 dfx::websocket::LogCallback WebSocket::logCallback = nullptr;
 
-WebSocket::WebSocket() : state(WebSocketState::CREATED), onEventCallback(nullptr), eventUserData(nullptr) {}
+WebSocket::WebSocket(size_t sendHeadroom)
+    : state(WebSocketState::CREATED), onEventCallback(nullptr), eventUserData(nullptr), sendHeadroom(sendHeadroom),
+      sendQueueMaxBytes(0), sendQueueMaxMessages(0), sendQueueHighWaterMark(0), sendQueueLowWaterMark(0),
+      sendQueueAboveHighWaterMark(false), receivePool(std::make_shared<WebSocketBufferPool>())
+{
+}
+
+WebSocket::~WebSocket()
+{
+    deactivateDispatchTarget();
+}
+
+std::unique_ptr<dfx::websocket::WebSocketSendBuffer> WebSocket::acquireSendBuffer(size_t sizeHint)
+{
+    return std::make_unique<WebSocketSendBuffer>(sendHeadroom, bufferPool.acquire(sendHeadroom + sizeHint));
+}
+
+void WebSocket::send(std::unique_ptr<WebSocketSendBuffer> buffer)
+{
+    bool reachedHighWaterMark;
+    {
+        std::unique_lock<std::mutex> lock(sendQueueMutex); // Protect - sendQueueStatus
+        reachedHighWaterMark = sendQueued(lock, buffer->size());
+    }
+    if (reachedHighWaterMark) {
+        notifySendQueueHigh();
+    }
+    enqueueSend(std::move(buffer));
+}
+
+dfx::websocket::Status WebSocket::trySend(std::unique_ptr<WebSocketSendBuffer>& buffer, uint32_t timeoutMillis)
+{
+    const auto bytes = buffer->size();
+    bool closed = false;
+    auto hasRoom = [this, bytes, &closed] {
+        auto state = getState();
+        closed = state == WebSocketState::CLOSING || state == WebSocketState::CLOSED;
+
+        // A message larger than the byte limit is let through once the queue is empty
+        bool bytesFit = sendQueueMaxBytes == 0 || sendQueueStatus.messages == 0 ||
+                        sendQueueStatus.bytes + bytes <= sendQueueMaxBytes;
+        bool messagesFit = sendQueueMaxMessages == 0 || sendQueueStatus.messages < sendQueueMaxMessages;
+        return closed || (bytesFit && messagesFit);
+    };
+
+    bool reachedHighWaterMark;
+    {
+        std::unique_lock<std::mutex> lock(sendQueueMutex); // Protect - sendQueueStatus
+        if (!hasRoom()) {
+            if (timeoutMillis == 0 ||
+                !cvSendQueue.wait_for(lock, std::chrono::milliseconds(timeoutMillis), hasRoom)) {
+                return Status::WOULD_BLOCK;
+            }
+        }
+        if (closed) {
+            return Status::FAILURE;
+        }
+
+        // Take the room while still holding the lock, another producer could otherwise claim it as well
+        reachedHighWaterMark = sendQueued(lock, bytes);
+    }
+
+    if (reachedHighWaterMark) {
+        notifySendQueueHigh();
+    }
+    enqueueSend(std::move(buffer));
+    return Status::OK;
+}
+
+void WebSocket::setSendQueueLimits(size_t maxBytes, size_t maxMessages)
+{
+    std::unique_lock<std::mutex> lock(sendQueueMutex); // Protect - limits
+    sendQueueMaxBytes = maxBytes;
+    sendQueueMaxMessages = maxMessages;
+    cvSendQueue.notify_all();
+}
+
+void WebSocket::setSendQueueWaterMarks(size_t highBytes, size_t lowBytes)
+{
+    std::unique_lock<std::mutex> lock(sendQueueMutex); // Protect - water marks
+    sendQueueHighWaterMark = highBytes;
+    sendQueueLowWaterMark = std::min(lowBytes, highBytes);
+}
+
+dfx::websocket::WebSocketSendQueueStatus WebSocket::getSendQueueStatus()
+{
+    std::unique_lock<std::mutex> lock(sendQueueMutex); // Protect - sendQueueStatus
+    auto status = sendQueueStatus;
+    if (!sendQueueTimes.empty()) {
+        auto waited = std::chrono::steady_clock::now() - sendQueueTimes.front();
+        status.oldestMillis = std::chrono::duration_cast<std::chrono::milliseconds>(waited).count();
+    }
+    return status;
+}
+
+bool WebSocket::sendQueued(std::unique_lock<std::mutex>& /*lock*/, size_t bytes)
+{
+    sendQueueStatus.messages++;
+    sendQueueStatus.bytes += bytes;
+    sendQueueTimes.push_back(std::chrono::steady_clock::now());
+    if (sendQueueHighWaterMark > 0 && !sendQueueAboveHighWaterMark && sendQueueStatus.bytes >= sendQueueHighWaterMark) {
+        sendQueueAboveHighWaterMark = true;
+        return true;
+    }
+    return false;
+}
+
+void WebSocket::notifySendQueueHigh()
+{
+    WebSocketEvent event;
+    event.type = WebSocketEventType::SEND_QUEUE_HIGH;
+    notifyClient(event);
+}
+
+void WebSocket::releaseSendBuffer(std::unique_ptr<WebSocketSendBuffer> buffer, bool written)
+{
+    if (!buffer) {
+        return;
+    }
+
+    bool reachedLowWaterMark = false;
+    {
+        std::unique_lock<std::mutex> lock(sendQueueMutex); // Protect - sendQueueStatus
+        sendQueueStatus.messages--;
+        sendQueueStatus.bytes -= buffer->size();
+        if (!sendQueueTimes.empty()) {
+            sendQueueTimes.pop_front(); // Written in the order they were queued
+        }
+        if (sendQueueAboveHighWaterMark && sendQueueStatus.bytes <= sendQueueLowWaterMark) {
+            sendQueueAboveHighWaterMark = false;
+            reachedLowWaterMark = true;
+        }
+        cvSendQueue.notify_all();
+    }
+
+    if (written) {
+        buffer->notifyWritten();
+    }
+    bufferPool.release(std::move(buffer->getStorage()));
+
+    if (reachedLowWaterMark) {
+        WebSocketEvent event;
+        event.type = WebSocketEventType::SEND_QUEUE_LOW;
+        notifyClient(event);
+    }
+}
+
+std::vector<uint8_t> WebSocket::acquireReceiveBuffer(size_t sizeHint)
+{
+    return receivePool->acquire(sizeHint + RECEIVE_PADDING);
+}
+
+std::shared_ptr<std::vector<uint8_t>> WebSocket::shareReceiveBuffer(std::vector<uint8_t>&& buffer)
+{
+    std::weak_ptr<WebSocketBufferPool> pool = receivePool;
+    return {new std::vector<uint8_t>(std::move(buffer)), [pool](std::vector<uint8_t>* data) {
+                if (auto receivePool = pool.lock()) {
+                    receivePool->release(std::move(*data));
+                }
+                delete data;
+            }};
+}
 
 void WebSocket::setState(WebSocketState state)
 {
@@ -46,6 +214,14 @@ void dfx::websocket::WebSocket::setEventCallback(const WebSocketEventCallback& c
     onEventCallback = callback;
     eventUserData = userData;
 
+    deactivateDispatchTarget();
+    if (eventDispatcher && callback) {
+        auto target = std::make_shared<WebSocketDispatchTarget>();
+        target->callback = callback;
+        target->userData = userData;
+        dispatchTarget = std::move(target);
+    }
+
     if (callback) {
         std::unique_lock<std::mutex> lock(pendingEventsMutex); // Protect - pendingEvents
         // Drain pending events now that we have an event handler
@@ -56,14 +232,32 @@ void dfx::websocket::WebSocket::setEventCallback(const WebSocketEventCallback& c
     }
 }
 
+void WebSocket::setEventDispatcher(std::shared_ptr<WebSocketEventDispatcher> dispatcher)
+{
+    eventDispatcher = std::move(dispatcher);
+}
+
+void WebSocket::deactivateDispatchTarget()
+{
+    if (dispatchTarget) {
+        // Waits for a callback in progress on the dispatcher thread, unless that is us
+        std::unique_lock<std::recursive_mutex> lock(dispatchTarget->mutex); // Protect - active
+        dispatchTarget->active = false;
+    }
+    dispatchTarget.reset();
+}
+
 // Called by websocket thread
 void WebSocket::notifyClient(const WebSocketEvent& event)
 {
-    if (onEventCallback) {
+    if (dispatchTarget) {
+        eventDispatcher->post(dispatchTarget, event);
+    } else if (onEventCallback) {
         onEventCallback(event, eventUserData);
     } else {
         std::unique_lock<std::mutex> lock(pendingEventsMutex); // Protect - pendingEvents
         pendingEvents.push_back(event);
+        cvPendingEvents.notify_one();
     }
 }
 
@@ -71,15 +265,43 @@ void WebSocket::setLogLevel(uint8_t level, LogCallback function) {}
 
 void WebSocket::setRootCertificate(const std::string& rootCA) {}
 
-dfx::websocket::Status WebSocket::getEvent(WebSocketEvent& event, uint32_t /*timeout*/)
+void WebSocket::setCompression(const WebSocketCompression& compression) {}
+
+void WebSocket::setReceiveBufferSize(uint32_t size) {}
+
+void WebSocket::setTLSSessionFile(const std::string& filePath) {}
+
+bool WebSocket::waitPendingEvents(std::unique_lock<std::mutex>& lock, uint32_t timeout)
+{
+    auto hasEvents = [this] { return !pendingEvents.empty(); };
+    if (timeout == 0) {
+        cvPendingEvents.wait(lock, hasEvents);
+        return true;
+    }
+    return cvPendingEvents.wait_for(lock, std::chrono::milliseconds(timeout), hasEvents);
+}
+
+dfx::websocket::Status WebSocket::getEvent(WebSocketEvent& event, uint32_t timeout)
+{
+    std::unique_lock<std::mutex> lock(pendingEventsMutex); // Protect - pendingEvents
+    if (!waitPendingEvents(lock, timeout)) {
+        return Status::TIMEOUT;
+    }
+    event = std::move(pendingEvents.front());
+    pendingEvents.pop_front();
+    return Status::OK;
+}
+
+dfx::websocket::Status WebSocket::getEvents(std::vector<WebSocketEvent>& events, size_t maxEvents, uint32_t timeout)
 {
-    // More elegant would be to use the timeout to wait until a result comes in
-    // or timeout but hopefully this is sufficient.
     std::unique_lock<std::mutex> lock(pendingEventsMutex); // Protect - pendingEvents
-    if (!pendingEvents.empty()) {
-        event = pendingEvents.front();
-        pendingEvents.pop_front();
+    if (!waitPendingEvents(lock, timeout)) {
+        return Status::TIMEOUT;
     }
+    auto count = std::min(maxEvents, pendingEvents.size());
+    auto end = pendingEvents.begin() + static_cast<std::ptrdiff_t>(count);
+    events.insert(events.end(), std::make_move_iterator(pendingEvents.begin()), std::make_move_iterator(end));
+    pendingEvents.erase(pendingEvents.begin(), end);
     return Status::OK;
 }
 
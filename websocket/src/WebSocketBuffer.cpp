@@ -0,0 +1,152 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/websocket/WebSocketBuffer.hpp"
+
+#include <cstring>
+
+using dfx::websocket::WebSocketBufferPool;
+using dfx::websocket::WebSocketSendBuffer;
+
+WebSocketBufferPool::WebSocketBufferPool(size_t maxBuffers, size_t maxBufferCapacity)
+    : maxBuffers(maxBuffers), maxBufferCapacity(maxBufferCapacity)
+{
+}
+
+std::vector<uint8_t> WebSocketBufferPool::acquire(size_t capacity)
+{
+    std::vector<uint8_t> buffer;
+    {
+        std::unique_lock<std::mutex> lock(mutex); // Protect - buffers
+
+        // Smallest buffer which already fits, otherwise the largest to grow from
+        auto best = buffers.end();
+        for (auto iter = buffers.begin(); iter != buffers.end(); ++iter) {
+            if (best == buffers.end()) {
+                best = iter;
+            } else if (iter->capacity() >= capacity) {
+                if (best->capacity() < capacity || iter->capacity() < best->capacity()) {
+                    best = iter;
+                }
+            } else if (best->capacity() < capacity && iter->capacity() > best->capacity()) {
+                best = iter;
+            }
+        }
+
+        if (best != buffers.end()) {
+            buffer = std::move(*best);
+            buffers.erase(best);
+        }
+    }
+
+    if (buffer.capacity() < capacity) {
+        buffer.reserve(getSizeClass(capacity));
+    }
+    return buffer;
+}
+
+void WebSocketBufferPool::release(std::vector<uint8_t>&& buffer)
+{
+    if (buffer.capacity() == 0 || buffer.capacity() > maxBufferCapacity) {
+        return; // Let it go
+    }
+
+    buffer.clear();
+
+    std::unique_lock<std::mutex> lock(mutex); // Protect - buffers
+    if (buffers.size() < maxBuffers) {
+        buffers.push_back(std::move(buffer));
+    }
+}
+
+size_t WebSocketBufferPool::getPooledCount()
+{
+    std::unique_lock<std::mutex> lock(mutex); // Protect - buffers
+    return buffers.size();
+}
+
+size_t WebSocketBufferPool::getSizeClass(size_t size)
+{
+    size_t sizeClass = MIN_SIZE_CLASS;
+    while (sizeClass < size && sizeClass <= (SIZE_MAX >> 1)) {
+        sizeClass <<= 1;
+    }
+    return sizeClass < size ? size : sizeClass;
+}
+
+WebSocketSendBuffer::WebSocketSendBuffer(size_t headroom, std::vector<uint8_t>&& storage)
+    : headroom(headroom), storage(std::move(storage))
+{
+    this->storage.resize(headroom);
+}
+
+uint8_t* WebSocketSendBuffer::data()
+{
+    return storage.data() + headroom;
+}
+
+const uint8_t* WebSocketSendBuffer::data() const
+{
+    return storage.data() + headroom;
+}
+
+size_t WebSocketSendBuffer::size() const
+{
+    return storage.size() - headroom;
+}
+
+bool WebSocketSendBuffer::empty() const
+{
+    return storage.size() == headroom;
+}
+
+void WebSocketSendBuffer::reserve(size_t size)
+{
+    storage.reserve(headroom + size);
+}
+
+void WebSocketSendBuffer::resize(size_t size)
+{
+    storage.resize(headroom + size);
+}
+
+void WebSocketSendBuffer::clear()
+{
+    storage.resize(headroom);
+}
+
+void WebSocketSendBuffer::append(const void* bytes, size_t length)
+{
+    auto offset = storage.size();
+    storage.resize(offset + length);
+    if (length > 0) {
+        memcpy(storage.data() + offset, bytes, length);
+    }
+}
+
+void WebSocketSendBuffer::append(const std::string& bytes)
+{
+    append(bytes.data(), bytes.size());
+}
+
+size_t WebSocketSendBuffer::getHeadroom() const
+{
+    return headroom;
+}
+
+void WebSocketSendBuffer::setWrittenCallback(std::function<void()> callback)
+{
+    writtenCallback = std::move(callback);
+}
+
+std::vector<uint8_t>& WebSocketSendBuffer::getStorage()
+{
+    return storage;
+}
+
+void WebSocketSendBuffer::notifyWritten()
+{
+    if (writtenCallback) {
+        writtenCallback();
+    }
+}
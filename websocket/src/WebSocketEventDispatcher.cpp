@@ -0,0 +1,130 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/websocket/WebSocketEventDispatcher.hpp"
+
+using dfx::websocket::WebSocketDispatchTarget;
+using dfx::websocket::WebSocketEvent;
+using dfx::websocket::WebSocketEventDispatcher;
+
+WebSocketEventDispatcher::WebSocketEventDispatcher(size_t capacity)
+    : ring(capacity), overflowing(false), sleeping(false), stopping(false)
+{
+    dispatcherThread = std::thread(&WebSocketEventDispatcher::dispatcherThreadRunnable, this);
+}
+
+WebSocketEventDispatcher::~WebSocketEventDispatcher()
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopping = true;
+        sleeping = false;
+    }
+    cvWake.notify_one();
+
+    if (dispatcherThread.joinable()) {
+        dispatcherThread.join();
+    }
+}
+
+std::shared_ptr<WebSocketEventDispatcher> WebSocketEventDispatcher::getShared()
+{
+    // Lives for the remainder of the process, like the shared WebSocketEventLoop
+    static std::shared_ptr<WebSocketEventDispatcher> sharedDispatcher = std::make_shared<WebSocketEventDispatcher>();
+    return sharedDispatcher;
+}
+
+bool WebSocketEventDispatcher::isDispatcherThread() const
+{
+    return dispatcherThread.get_id() == std::this_thread::get_id();
+}
+
+void WebSocketEventDispatcher::post(const std::shared_ptr<WebSocketDispatchTarget>& target,
+                                    const WebSocketEvent& event)
+{
+    DispatchedEvent dispatched;
+    dispatched.target = target;
+    dispatched.type = event.type;
+    switch (event.type) {
+        case WebSocketEventType::ERROR_EVENT:
+            dispatched.payload = event.error;
+            break;
+        case WebSocketEventType::MESSAGE:
+            dispatched.payload = event.message;
+            break;
+        default:
+            break;
+    }
+
+    // Once anything has spilled every producer uses the overflow until the dispatcher empties it,
+    // otherwise a later event could reach the ring and be dispatched ahead of an earlier one.
+    if (overflowing.load() || !ring.tryPush(std::move(dispatched))) {
+        std::unique_lock<std::mutex> lock(overflowMutex); // Protect - overflow
+        overflow.push_back(std::move(dispatched));
+        overflowing = true;
+    }
+
+    // Only pay for the mutex when the dispatcher has gone to sleep, the fence pairs with the one in
+    // dispatcherThreadRunnable so either we see it sleeping or it sees the event.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping.exchange(false)) {
+        std::unique_lock<std::mutex> lock(mutex);
+        cvWake.notify_one();
+    }
+}
+
+void WebSocketEventDispatcher::dispatch(DispatchedEvent& dispatched)
+{
+    auto& target = *dispatched.target;
+    std::unique_lock<std::recursive_mutex> lock(target.mutex); // Protect - active
+    if (!target.active || !target.callback) {
+        return;
+    }
+
+    WebSocketEvent event;
+    event.type = dispatched.type;
+    if (auto* error = std::get_if<WebSocketErrorEvent>(&dispatched.payload)) {
+        event.error = std::move(*error);
+    } else if (auto* message = std::get_if<WebSocketMessageEvent>(&dispatched.payload)) {
+        event.message = std::move(*message);
+    }
+    target.callback(event, target.userData);
+}
+
+void WebSocketEventDispatcher::dispatcherThreadRunnable()
+{
+    DispatchedEvent dispatched;
+    while (true) {
+        if (ring.tryPop(dispatched)) {
+            dispatch(dispatched);
+            dispatched.target.reset();
+            continue;
+        }
+
+        // Ring is drained, anything which spilled was posted after what was in it
+        if (overflowing.load()) {
+            std::deque<DispatchedEvent> spilled;
+            {
+                std::unique_lock<std::mutex> lock(overflowMutex); // Protect - overflow
+                spilled.swap(overflow);
+                overflowing = false;
+            }
+            for (auto& event : spilled) {
+                dispatch(event);
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopping) {
+            break;
+        }
+        sleeping = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (!ring.empty() || overflowing.load()) {
+            sleeping = false;
+            continue;
+        }
+        cvWake.wait(lock, [this] { return !sleeping; });
+    }
+}
@@ -0,0 +1,366 @@
+// Copyright (c) Nuralogix. All rights reserved. Licensed under the MIT license.
+// See LICENSE.txt in the project root for license information.
+
+#include "dfx/websocket/WebSocketEventLoop.hpp"
+#include "dfx/websocket/WebSocketLibWebSocket.hpp"
+
+#include "dfx/api/utils/TLSSessionCache.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509.h>
+
+using dfx::websocket::WebSocketCompression;
+using dfx::websocket::WebSocketEventLoop;
+using dfx::websocket::WebSocketLibWebSocket;
+
+const uint32_t DFX_MAX_PAYLOAD_SIZE = 10 * 1024 * 1024;
+
+// Connections read into a buffer this size unless told otherwise, larger messages are reassembled
+const uint32_t DFX_ADAPTIVE_RX_BUFFER_SIZE = 16 * 1024;
+
+extern "C" {
+static int dfx_wss_callback(struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len)
+{
+    return WebSocketLibWebSocket::dfx_wss_callback(wsi, reason, user, in, len);
+}
+}
+
+// The context only services vhosts, which each have their own copy with the rx buffer size they use.
+// Sends are not limited by the rx buffer, lws would otherwise split writes at its size.
+// NOLINTNEXTLINE(modernize-avoid-c-arrays)  suggests using std::array<>
+static struct lws_protocols protocols[] = {
+    {
+        "proto",
+        ::dfx_wss_callback,
+        0,
+        DFX_ADAPTIVE_RX_BUFFER_SIZE,
+        0,
+        nullptr,
+        DFX_MAX_PAYLOAD_SIZE,
+    },
+    {
+        "json",
+        ::dfx_wss_callback,
+        0,
+        DFX_ADAPTIVE_RX_BUFFER_SIZE,
+        0,
+        nullptr,
+        DFX_MAX_PAYLOAD_SIZE,
+    },
+    LWS_PROTOCOL_LIST_TERM /* terminator */
+};
+
+const uint32_t retry_ms_table[] = {1000, 2000, 3000, 4000, 5000};
+static lws_retry_bo_t retry_bo = {
+    retry_ms_table,                 /* base delay in ms */
+    LWS_ARRAY_SIZE(retry_ms_table), /* entries in table */
+    LWS_ARRAY_SIZE(retry_ms_table), /* max retries to conceal */
+    30,                             /* idle before PING issued */
+    120,                            /* idle before hangup conn */
+    20                              /* % additional random jitter */
+};
+
+WebSocketEventLoop::WebSocketEventLoop(uint16_t numberServiceThreads)
+{
+    numberServiceThreads = std::max<uint16_t>(numberServiceThreads, 1);
+
+    for (uint16_t index = 0; index < numberServiceThreads; index++) {
+        auto serviceThread = std::make_unique<ServiceThread>();
+        serviceThread->eventLoop = this;
+
+        // Each service thread gets its own context, connections are created in vhosts added on
+        // demand from the service thread so there is no default vhost.
+        struct lws_context_creation_info ctxCreationInfo
+        {
+        };
+        memset(&ctxCreationInfo, 0, sizeof ctxCreationInfo);
+
+        ctxCreationInfo.options = LWS_SERVER_OPTION_EXPLICIT_VHOSTS | LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT;
+        ctxCreationInfo.port = CONTEXT_PORT_NO_LISTEN; // We don't want this client to listen
+        ctxCreationInfo.protocols = protocols;
+        ctxCreationInfo.gid = -1;
+        ctxCreationInfo.uid = -1;
+        ctxCreationInfo.timeout_secs = 30;
+        ctxCreationInfo.user = serviceThread.get(); // Context user is the owning service thread
+
+        serviceThread->context = lws_create_context(&ctxCreationInfo);
+        if (serviceThread->context == nullptr) {
+            WebSocketLibWebSocket::log(WebSocketLibWebSocket::LOG_LEVEL_ERROR,
+                                       "WebSocket: Failure to create service context %d\n",
+                                       static_cast<int>(index));
+            continue;
+        }
+
+        serviceThread->thread = std::thread(&WebSocketEventLoop::serviceThreadRunnable, this, serviceThread.get());
+        serviceThreads.push_back(std::move(serviceThread));
+    }
+}
+
+WebSocketEventLoop::~WebSocketEventLoop()
+{
+    for (auto& serviceThread : serviceThreads) {
+        serviceThread->stopping = true;
+        lws_cancel_service(serviceThread->context); // Wake it up to notice
+    }
+
+    for (auto& serviceThread : serviceThreads) {
+        if (serviceThread->thread.joinable()) {
+            serviceThread->thread.join();
+        }
+        lws_context_destroy(serviceThread->context); // Can not call while lws_service() in play
+    }
+
+    // Each SSL_CTX holds its own reference, they are gone with the contexts
+    for (auto& trustStore : trustStores) {
+        X509_STORE_free(trustStore.second);
+    }
+}
+
+std::shared_ptr<WebSocketEventLoop> WebSocketEventLoop::getShared()
+{
+    // Lives for the remainder of the process, sockets hold a reference so any still open during
+    // static destruction keep it alive until they are done with it.
+    static std::shared_ptr<WebSocketEventLoop> sharedEventLoop = std::make_shared<WebSocketEventLoop>();
+    return sharedEventLoop;
+}
+
+uint16_t WebSocketEventLoop::getServiceThreadCount() const
+{
+    return static_cast<uint16_t>(serviceThreads.size());
+}
+
+size_t WebSocketEventLoop::getConnectionCount() const
+{
+    size_t connections = 0;
+    for (const auto& serviceThread : serviceThreads) {
+        connections += serviceThread->connections;
+    }
+    return connections;
+}
+
+WebSocketEventLoop::ServiceThread* WebSocketEventLoop::attach()
+{
+    if (serviceThreads.empty()) {
+        return nullptr;
+    }
+
+    auto leastLoaded = std::min_element(
+        serviceThreads.begin(), serviceThreads.end(), [](const auto& lhs, const auto& rhs) {
+            return lhs->connections < rhs->connections;
+        });
+
+    auto* serviceThread = leastLoaded->get();
+    serviceThread->connections++;
+    return serviceThread;
+}
+
+void WebSocketEventLoop::detach(ServiceThread* serviceThread)
+{
+    serviceThread->connections--;
+}
+
+void WebSocketEventLoop::post(ServiceThread* serviceThread, CommandType type, WebSocketLibWebSocket* socket)
+{
+    {
+        std::unique_lock<std::mutex> lock(serviceThread->mutex); // Protect - pendingCommands
+        serviceThread->pendingCommands.push_back({type, socket});
+    }
+
+    // Thread safe, breaks the service thread out of its wait so the command runs right away
+    if (!isServiceThread(serviceThread)) {
+        lws_cancel_service(serviceThread->context);
+    }
+}
+
+void WebSocketEventLoop::cancel(ServiceThread* serviceThread, WebSocketLibWebSocket* socket)
+{
+    std::unique_lock<std::mutex> lock(serviceThread->mutex); // Protect - pendingCommands
+    auto& commands = serviceThread->pendingCommands;
+    commands.erase(std::remove_if(commands.begin(),
+                                  commands.end(),
+                                  [socket](const Command& command) { return command.socket == socket; }),
+                   commands.end());
+}
+
+void WebSocketEventLoop::runPendingCommands(ServiceThread* serviceThread)
+{
+    // Commands are run in the order they were posted, a socket posts DESTROY from its destructor
+    // and waits for it so every earlier command for the socket has completed by then. They are taken
+    // one at a time since running one may destroy a socket which cancels any others it has queued.
+    while (true) {
+        Command command{};
+        {
+            std::unique_lock<std::mutex> lock(serviceThread->mutex); // Protect - pendingCommands
+            if (serviceThread->pendingCommands.empty()) {
+                break;
+            }
+            command = serviceThread->pendingCommands.front();
+            serviceThread->pendingCommands.pop_front();
+        }
+
+        switch (command.type) {
+            case CommandType::CONNECT:
+                command.socket->connectOnServiceThread();
+                break;
+            case CommandType::WRITABLE:
+                command.socket->writableOnServiceThread();
+                break;
+            case CommandType::CLOSE:
+                command.socket->closeOnServiceThread();
+                break;
+            case CommandType::DESTROY:
+                command.socket->destroyOnServiceThread();
+                break;
+        }
+    }
+}
+
+X509_STORE* WebSocketEventLoop::getTrustStore(const std::string& rootCA)
+{
+    std::unique_lock<std::mutex> lock(trustStoresMutex); // Protect - trustStores
+    auto found = trustStores.find(rootCA);
+    if (found != trustStores.end()) {
+        return found->second;
+    }
+
+    // A bundle holds many certificates, read them all rather than only the first
+    X509_STORE* store = X509_STORE_new();
+    size_t certificates = 0;
+    BIO* bio = BIO_new_mem_buf(rootCA.data(), static_cast<int>(rootCA.size()));
+    if (store != nullptr && bio != nullptr) {
+        X509* certificate;
+        while ((certificate = PEM_read_bio_X509(bio, nullptr, nullptr, nullptr)) != nullptr) {
+            if (X509_STORE_add_cert(store, certificate) == 1) {
+                certificates++;
+            }
+            X509_free(certificate);
+        }
+    }
+    BIO_free(bio);
+    ERR_clear_error(); // Reading stops with an end of data error
+
+    if (certificates == 0) {
+        WebSocketLibWebSocket::log(WebSocketLibWebSocket::LOG_LEVEL_ERROR,
+                                   "WebSocket: No certificates found in the root certificate\n");
+        X509_STORE_free(store);
+        store = nullptr;
+    }
+
+    trustStores[rootCA] = store; // Remember failures too, no point parsing again
+    return store;
+}
+
+void WebSocketEventLoop::loadVerifyCerts(struct lws* wsi, void* sslContext)
+{
+    auto* vhost = lws_get_vhost(wsi);
+    auto* serviceThread = static_cast<ServiceThread*>(lws_context_user(lws_get_context(wsi)));
+    if (vhost == nullptr || serviceThread == nullptr || sslContext == nullptr) {
+        return;
+    }
+
+    const char* vhostName = lws_get_vhost_name(vhost);
+    for (auto& entry : serviceThread->vhosts) {
+        if (entry.second.name == vhostName) {
+            // Reconnects resume the TLS session rather than doing a full handshake
+            dfx::api::utils::TLSSessionCache::getShared().install(sslContext, entry.second.sessionScope);
+            if (entry.second.trustStore != nullptr) {
+                SSL_CTX_set1_cert_store(static_cast<SSL_CTX*>(sslContext), entry.second.trustStore);
+            }
+            break;
+        }
+    }
+}
+
+struct lws_vhost* WebSocketEventLoop::getVHost(ServiceThread* serviceThread,
+                                               const std::string& rootCA,
+                                               const WebSocketCompression& compression,
+                                               uint32_t receiveBufferSize)
+{
+    // Extensions are negotiated from the vhost, so the offer is part of what connections must share
+    std::string deflateOffer;
+    if (compression.enabled) {
+        auto windowBits = std::to_string(std::clamp<int>(compression.windowBits, 9, 15));
+        deflateOffer = "permessage-deflate; client_max_window_bits=" + windowBits +
+                       "; server_max_window_bits=" + windowBits;
+    }
+
+    // The rx buffer size is a property of the protocol and protocols belong to the vhost
+    auto rxBufferSize = receiveBufferSize == 0 ? DFX_ADAPTIVE_RX_BUFFER_SIZE : receiveBufferSize;
+
+    auto key = rootCA + "\n" + deflateOffer + "\n" + std::to_string(rxBufferSize);
+    auto found = serviceThread->vhosts.find(key);
+    if (found != serviceThread->vhosts.end()) {
+        return found->second.vhost;
+    }
+
+    // Connections which share a root certificate share a vhost and so the SSL_CTX built from it, the
+    // certificates themselves are shared with the other service threads through the trust store.
+    auto& entry = serviceThread->vhosts[key];
+    entry.name = "dfx-" + std::to_string(serviceThread->vhosts.size());
+    entry.trustStore = rootCA.empty() ? nullptr : getTrustStore(rootCA);
+    // Connections accept self-signed certificates and skip the host name check, keep their sessions apart
+    entry.sessionScope = dfx::api::utils::TLSSessionCache::makeScope("websocket-selfsigned-anyhost", rootCA);
+    entry.deflateOffer = deflateOffer;
+    entry.extensions[0] = {"permessage-deflate", lws_extension_callback_pm_deflate, entry.deflateOffer.c_str()};
+    entry.extensions[1] = {nullptr, nullptr, nullptr};
+    std::copy(std::begin(protocols), std::end(protocols), entry.protocols.begin());
+    for (auto& protocol : entry.protocols) {
+        if (protocol.name != nullptr) {
+            protocol.rx_buffer_size = rxBufferSize;
+        }
+    }
+
+    struct lws_context_creation_info vhostCreationInfo
+    {
+    };
+    memset(&vhostCreationInfo, 0, sizeof vhostCreationInfo);
+
+    vhostCreationInfo.port = CONTEXT_PORT_NO_LISTEN; // We don't want this client to listen
+    vhostCreationInfo.protocols = entry.protocols.data();
+    vhostCreationInfo.gid = -1;
+    vhostCreationInfo.uid = -1;
+    vhostCreationInfo.extensions = compression.enabled ? entry.extensions.data() : nullptr;
+    vhostCreationInfo.vhost_name = entry.name.c_str();
+
+    vhostCreationInfo.ssl_ca_filepath = nullptr; // The trust store is installed by loadVerifyCerts()
+    vhostCreationInfo.ssl_cert_filepath = nullptr;
+    vhostCreationInfo.ssl_private_key_filepath = nullptr;
+    vhostCreationInfo.options = LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT | LWS_SERVER_OPTION_CREATE_VHOST_SSL_CTX;
+
+    // timeout and retry policy
+    vhostCreationInfo.keepalive_timeout = 30;
+    vhostCreationInfo.ka_time = 20;
+    vhostCreationInfo.ka_probes = 3;
+    vhostCreationInfo.ka_interval = 1;
+    vhostCreationInfo.timeout_secs = 30;
+    vhostCreationInfo.retry_and_idle_policy = &retry_bo;
+
+    entry.vhost = lws_create_vhost(serviceThread->context, &vhostCreationInfo);
+    if (entry.vhost == nullptr) {
+        serviceThread->vhosts.erase(key);
+        return nullptr;
+    }
+    return entry.vhost;
+}
+
+bool WebSocketEventLoop::isServiceThread(const ServiceThread* serviceThread) const
+{
+    return serviceThread->thread.get_id() == std::this_thread::get_id();
+}
+
+void WebSocketEventLoop::serviceThreadRunnable(ServiceThread* serviceThread)
+{
+    while (!serviceThread->stopping) {
+        // LWS' function to run the message loop, it waits until there is socket activity, a lws timer
+        // is due or lws_cancel_service() is called by post(). The timeout is ignored by lws 4.x.
+        lws_service(serviceThread->context, 0);
+
+        runPendingCommands(serviceThread);
+    }
+}
@@ -3,34 +3,19 @@
 
 #include "dfx/websocket/WebSocketLibWebSocket.hpp"
 
-#include <chrono> // std::chrono::seconds
+#include "dfx/api/utils/TLSSessionCache.hpp"
+
+#include <algorithm>
 #include <cstdio>
-#include <filesystem>
-#include <fstream>
+#include <cstring>
+#include <iterator>
 #include <sstream>
-#include <thread> // std::this_thread::sleep_for
-
-#ifdef __APPLE__
-#include <TargetConditionals.h>
-#endif
-
-namespace fs = std::filesystem;
-
-// https://github.com/iamscottmoyers/simple-libwebsockets-example/blob/master/client.c
-
-const uint32_t DFX_MAX_PAYLOAD_SIZE = 10 * 1024 * 1024;
 
 using dfx::websocket::WebSocket;
+using dfx::websocket::WebSocketEventLoop;
 using dfx::websocket::WebSocketLibWebSocket;
 using dfx::websocket::WebSocketState;
 
-extern "C" {
-static int dfx_wss_callback(struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len)
-{
-    return WebSocketLibWebSocket::dfx_wss_callback(wsi, reason, user, in, len);
-}
-}
-
 int WebSocketLibWebSocket::dfx_wss_callback(
     struct lws* wsi, enum lws_callback_reasons reason, void* user, void* in, size_t len)
 {
@@ -50,6 +35,8 @@ int WebSocketLibWebSocket::dfx_wss_callback(
             case LWS_CALLBACK_EVENT_WAIT_CANCELLED:
                 break;
             case LWS_CALLBACK_OPENSSL_LOAD_EXTRA_CLIENT_VERIFY_CERTS:
+                // Called against the vhost while its client SSL_CTX is set up, user is the SSL_CTX
+                WebSocketEventLoop::loadVerifyCerts(wsi, user);
                 break;
             case LWS_CALLBACK_PROTOCOL_INIT:
                 break;
@@ -64,35 +51,17 @@ int WebSocketLibWebSocket::dfx_wss_callback(
     return 0;
 }
 
-// NOLINTNEXTLINE(modernize-avoid-c-arrays)  suggests using std::array<>
-static struct lws_protocols protocols[] = {
-    {
-        "proto",
-        ::dfx_wss_callback,
-        0,
-        DFX_MAX_PAYLOAD_SIZE,
-    },
-    {
-        "json",
-        ::dfx_wss_callback,
-        0,
-        DFX_MAX_PAYLOAD_SIZE,
-    },
-    LWS_PROTOCOL_LIST_TERM /* terminator */
-};
-
-const uint32_t retry_ms_table[] = {1000, 2000, 3000, 4000, 5000};
-static lws_retry_bo_t retry_bo = {
-    retry_ms_table,	   /* base delay in ms */
-	LWS_ARRAY_SIZE(retry_ms_table),                 /* entries in table */
-	LWS_ARRAY_SIZE(retry_ms_table),		           /* max retries to conceal */
-	30,                /* idle before PING issued */
-	120,                /* idle before hangup conn */
-	20		           /* % additional random jitter */
-};
-
 WebSocketLibWebSocket::WebSocketLibWebSocket(int logLevel, LogCallback callback)
-    : context(nullptr), serviceThreadJoined(true)
+    : WebSocketLibWebSocket(logLevel, callback, WebSocketEventLoop::getShared())
+{
+}
+
+WebSocketLibWebSocket::WebSocketLibWebSocket(int logLevel,
+                                             LogCallback callback,
+                                             std::shared_ptr<WebSocketEventLoop> eventLoop)
+    : WebSocket(LWS_PRE), eventLoop(std::move(eventLoop)), serviceThread(nullptr), attached(false), destroyed(false),
+      port(0), useSSL(false), receiveBufferSize(0), writableRequested(false), wsi(nullptr), established(false),
+      receiveIsText(false), receiveSizeHint(0)
 {
     setLogLevel(logLevel, callback);
 }
@@ -101,9 +70,19 @@ WebSocketLibWebSocket::~WebSocketLibWebSocket()
 {
     close();
 
-    // If it was initialized, it is a temporary path and so we should try to delete the file on exit.
-    if (!certFilePath.empty()) {
-        remove(certFilePath.c_str());
+    std::unique_lock<std::mutex> lock(shutdownMutex);
+    if (serviceThread != nullptr) {
+        // Commands for this instance may still be queued and close() does not wait when called from
+        // the service thread, so the connection may still be live. Detach it from this instance before
+        // the memory goes away.
+        if (eventLoop->isServiceThread(serviceThread)) {
+            lock.unlock();
+            eventLoop->cancel(serviceThread, this);
+            destroyOnServiceThread();
+        } else {
+            eventLoop->post(serviceThread, WebSocketEventLoop::CommandType::DESTROY, this);
+            cvShutdown.wait(lock, [this] { return destroyed; });
+        }
     }
 }
 
@@ -139,43 +118,36 @@ void WebSocketLibWebSocket::setLogLevel(uint8_t level, LogCallback function)
 
 void WebSocketLibWebSocket::setRootCertificate(const std::string& rootCA)
 {
-    // libwebsocket expects a file, not the content so write the content to temporary file
-
-// iOS does not support the std::filesystem API, might require something else
-// but there is a decent chance that configuring the rootCA on iOS is unnecessary.
-#if !defined(TARGET_OS_IPHONE) || !TARGET_OS_IPHONE
-    auto path = fs::temp_directory_path();
-    certFilePath = path.append("cacert.pem").string();
-
-    std::ofstream file;
-    file.open(certFilePath.c_str(), std::ios::out);
-    auto length = static_cast<std::streamsize>(rootCA.length());
-    file.write(rootCA.c_str(), length);
-    file.close();
-#endif
+    // Kept in memory, the event loop parses it once into a trust store shared by every connection using it
+    rootCertificate = rootCA;
 }
 
-void WebSocketLibWebSocket::open(const std::string& inputURL, const std::string& protocol)
+void WebSocketLibWebSocket::setCompression(const WebSocketCompression& options)
 {
-    // Create the websockets context. This tracks open connections and knows how to route any
-    // traffic and which protocol version to use, and if each connection is client or server side.
-    struct lws_context_creation_info ctxCreationInfo
-    {
-    };
-    memset(&ctxCreationInfo, 0, sizeof ctxCreationInfo);
+    compression = options;
+}
 
-    // Provides the data necessary to connect to another websocket server with lws_client_connect_via_info.
-    struct lws_client_connect_info clientConnectInfo
-    {
-    };
-    memset(&clientConnectInfo, 0, sizeof(clientConnectInfo));
+void WebSocketLibWebSocket::setReceiveBufferSize(uint32_t size)
+{
+    receiveBufferSize = size;
+}
 
-    const char *urlProtocol = nullptr, *urlPathStart = nullptr;
+void WebSocketLibWebSocket::setTLSSessionFile(const std::string& filePath)
+{
+    if (!dfx::api::utils::TLSSessionCache::getShared().setFilePath(filePath)) {
+        log(LOG_LEVEL_WARNING, "Unable to read TLS sessions from %s\n", filePath.c_str());
+    }
+}
+
+void WebSocketLibWebSocket::open(const std::string& inputURL, const std::string& protocol)
+{
+    const char *urlProtocol = nullptr, *urlAddress = nullptr, *urlPathStart = nullptr;
+    int urlPort = 0;
 
     // NOLINTNEXTLINE(modernize-avoid-c-arrays)  suggests using std::array<>
     char localURLPath[1024];
     lws_strncpy(localURLPath, inputURL.data(), sizeof(localURLPath));
-    if (lws_parse_uri(localURLPath, &urlProtocol, &clientConnectInfo.address, &clientConnectInfo.port, &urlPathStart)) {
+    if (lws_parse_uri(localURLPath, &urlProtocol, &urlAddress, &urlPort, &urlPathStart)) {
         log(LOG_LEVEL_ERROR, "WebSocket: Failure to parse URI. Connection closed during setup.");
         setState(WebSocketState::CLOSED);
         return;
@@ -189,150 +161,203 @@ void WebSocketLibWebSocket::open(const std::string& inputURL, const std::string&
         urlPath << urlPathStart;
     }
 
-    std::string urlPathString = urlPath.str();      // Temporary to protect c_str() life
-    clientConnectInfo.path = urlPathString.c_str(); // Set the info's path to the fixed up url path
-
-    const char* ca_filepath = certFilePath.c_str();
-
-    // Set up the context creation info
-    ctxCreationInfo.options = 0;                   // LWS_SERVER_OPTION_H2_JUST_FIX_WINDOW_UPDATE_OVERFLOW;
-    ctxCreationInfo.port = CONTEXT_PORT_NO_LISTEN; // We don't want this client to listen
-    ctxCreationInfo.protocols = protocols;         // Use our protocol list
-    ctxCreationInfo.gid = -1;
-    ctxCreationInfo.uid = -1;
-    ctxCreationInfo.extensions = nullptr;
-    ctxCreationInfo.user = this; // Callback void*
-
-    ctxCreationInfo.ssl_ca_filepath = ca_filepath;      // info.ca_filepath;
-    ctxCreationInfo.ssl_cert_filepath = nullptr;        // info.server_cert_filepath;
-    ctxCreationInfo.ssl_private_key_filepath = nullptr; // info.server_private_key_filepath;
-    ctxCreationInfo.options |= LWS_SERVER_OPTION_DO_SSL_GLOBAL_INIT | LWS_SERVER_OPTION_CREATE_VHOST_SSL_CTX;
-    
-    // timeout and retry policy
-    ctxCreationInfo.keepalive_timeout = 30;
-    ctxCreationInfo.ka_time = 20;
-    ctxCreationInfo.ka_probes = 3;
-    ctxCreationInfo.ka_interval = 1;
-    ctxCreationInfo.timeout_secs = 30;
-    ctxCreationInfo.retry_and_idle_policy = &retry_bo;
-
-    // Create the context with the info
-    context = lws_create_context(&ctxCreationInfo);
-    if (context == nullptr) {
+    // Keep copies, the connection is made later from the service thread
+    address = urlAddress;
+    port = urlPort;
+    path = urlPath.str();
+    useSSL = !strcmp(urlProtocol, "https") || !strcmp(urlProtocol, "wss");
+    protocolName = (protocol == "json") ? "json" : "proto";
+
+    std::unique_lock<std::mutex> lock(shutdownMutex);
+    if (attached) {
+        log(LOG_LEVEL_ERROR, "WebSocket: Already open.");
+        return;
+    }
+
+    serviceThread = eventLoop->attach();
+    if (serviceThread == nullptr) {
+        log(LOG_LEVEL_ERROR, "WebSocket: No service thread available. Connection closed during setup.");
         setState(WebSocketState::CLOSED);
-    } else {
-        // Set up the client creation info
-        clientConnectInfo.context = context; // Use our created context
-        if (!strcmp(urlProtocol, "https") || !strcmp(urlProtocol, "wss")) {
-            clientConnectInfo.ssl_connection =
-                LCCSCF_USE_SSL | LCCSCF_ALLOW_SELFSIGNED | LCCSCF_SKIP_SERVER_CERT_HOSTNAME_CHECK;
-        }
-        clientConnectInfo.host = clientConnectInfo.address;   // Set the connections host to the address
-        clientConnectInfo.origin = clientConnectInfo.address; // Set the connections origin to the address
-        clientConnectInfo.ietf_version_or_minus_one = -1;     // IETF version is -1 (the latest one)
-        clientConnectInfo.userdata = this;
+        return;
+    }
+    attached = true;
+    setState(WebSocketState::CONNECTING);
 
-        if (protocol == "json") {
-            clientConnectInfo.protocol = protocols[1].name;
-        } else {
-            clientConnectInfo.protocol = protocols[0].name;
-        }
+    eventLoop->post(serviceThread, WebSocketEventLoop::CommandType::CONNECT, this);
+}
 
-        clientConnectInfo.pwsi = &wsi; // The created client should be placed here
-        clientConnectInfo.retry_and_idle_policy = &retry_bo;
-        clientConnectInfo.priority = 1;
-        clientConnectInfo.ssl_connection |= LCCSCF_IP_HIGH_RELIABILITY;
+void WebSocketLibWebSocket::connectOnServiceThread()
+{
+    auto* vhost = eventLoop->getVHost(serviceThread, rootCertificate, compression, receiveBufferSize);
+    if (vhost == nullptr) {
+        releaseConnection();
+        return;
+    }
 
-        // Connect with the client info
-        lws_client_connect_via_info(&clientConnectInfo);
-        if (wsi == nullptr) {
-            setState(WebSocketState::CLOSED);
-        } else {
-            std::unique_lock<std::mutex> lock(shutdownMutex);
-            serviceThreadJoined = false;
-            serviceThread = std::make_unique<std::thread>(&WebSocketLibWebSocket::serviceThreadRunnable, this);
-            setState(WebSocketState::CONNECTING);
-        }
+    // Provides the data necessary to connect to another websocket server with lws_client_connect_via_info.
+    struct lws_client_connect_info clientConnectInfo
+    {
+    };
+    memset(&clientConnectInfo, 0, sizeof(clientConnectInfo));
+
+    clientConnectInfo.context = serviceThread->context; // Use the service thread context
+    clientConnectInfo.vhost = vhost;
+    clientConnectInfo.address = address.c_str();
+    clientConnectInfo.port = port;
+    clientConnectInfo.path = path.c_str();
+    if (useSSL) {
+        clientConnectInfo.ssl_connection =
+            LCCSCF_USE_SSL | LCCSCF_ALLOW_SELFSIGNED | LCCSCF_SKIP_SERVER_CERT_HOSTNAME_CHECK;
+    }
+    clientConnectInfo.host = clientConnectInfo.address;   // Set the connections host to the address
+    clientConnectInfo.origin = clientConnectInfo.address; // Set the connections origin to the address
+    clientConnectInfo.ietf_version_or_minus_one = -1;     // IETF version is -1 (the latest one)
+    clientConnectInfo.userdata = this;
+    clientConnectInfo.protocol = protocolName.c_str();
+
+    clientConnectInfo.pwsi = &wsi; // The created client should be placed here
+    clientConnectInfo.priority = 1;
+    clientConnectInfo.ssl_connection |= LCCSCF_IP_HIGH_RELIABILITY;
+
+    // Connect with the client info, a failure may already have been reported through the callback
+    lws_client_connect_via_info(&clientConnectInfo);
+    if (wsi == nullptr && getState() != WebSocketState::CLOSED) {
+        WebSocketEvent event;
+        event.type = WebSocketEventType::ERROR_EVENT;
+        event.error.message = "Failure to create connection";
+
+        releaseConnection(&event);
     }
 }
 
-void WebSocketLibWebSocket::serviceThreadRunnable()
+void WebSocketLibWebSocket::writableOnServiceThread()
 {
-    // Main loop runs till bExit is true, which forces an exit of this loop
-    while (true) {
-        auto state = getState();
-        if (state == WebSocketState::CLOSING || state == WebSocketState::CLOSED) {
-            break;
-        }
+    writableRequested = false;
+    if (wsi != nullptr && established) {
+        lws_callback_on_writable(wsi);
+    }
+}
+
+void WebSocketLibWebSocket::closeOnServiceThread()
+{
+    if (wsi == nullptr) {
+        releaseConnection();
+    } else if (established) {
+        // Let the writeable callback send the close frame
+        lws_callback_on_writable(wsi);
+    } else {
+        lws_set_timeout(wsi, PENDING_TIMEOUT_CLOSE_SEND, LWS_TO_KILL_ASYNC);
+    }
+}
 
-        // LWS' function to run the message loop, which polls in this example every
-        // 100 milliseconds on our created context
-        const int timeout_ms = 100;
-        lws_service(context, timeout_ms);
+void WebSocketLibWebSocket::destroyOnServiceThread()
+{
+    if (wsi != nullptr) {
+        // Any remaining callbacks for the connection must no longer reach this instance
+        lws_set_wsi_user(wsi, nullptr);
+        lws_set_timeout(wsi, PENDING_TIMEOUT_CLOSE_SEND, LWS_TO_KILL_ASYNC);
+        wsi = nullptr;
     }
+    releaseConnection();
 
     std::unique_lock<std::mutex> lock(shutdownMutex);
-    setState(WebSocketState::CLOSED);
+    destroyed = true;
+    cvShutdown.notify_all();
 }
 
-void WebSocketLibWebSocket::close()
+void WebSocketLibWebSocket::releaseConnection(const WebSocketEvent* event)
 {
-    bool haveJoinedThread = true; // Assume it has been joined
+    wsi = nullptr;
+    established = false;
+    receiveBuffer.clear(); // Partial message will never complete
+
     {
         std::unique_lock<std::mutex> lock(shutdownMutex);
-        auto state = getState();
-        if (state != WebSocketState::CLOSED) {
-            if (state != WebSocketState::CLOSING) {
-                setState(WebSocketState::CLOSING);
-            }
-        }
-        haveJoinedThread = serviceThreadJoined;
+        setState(WebSocketState::CLOSED);
     }
 
-    if (!haveJoinedThread) {
-        serviceThread->join();
+    // Nothing more will be written, release what is queued so the send queue empties and any
+    // producers waiting for room see the close.
+    std::deque<std::unique_ptr<WebSocketSendBuffer>> discarded;
+    {
+        std::unique_lock<std::mutex> lock(mutex); // Protect - pendingSendData
+        discarded.swap(pendingSendData);
+    }
+    for (auto& buffer : discarded) {
+        releaseSendBuffer(std::move(buffer));
+    }
 
-        std::unique_lock<std::mutex> lock(shutdownMutex);
-        lws_context_destroy(context); // Can not call while lws_service() in play
-        serviceThreadJoined = true;
-        setState(WebSocketState::CLOSED);
-    } else {
-        // Nothing to do - service thread already joined, and so socket is closed
+    if (event != nullptr) {
+        notifyClient(*event);
+    }
+
+    // Only now may close() return, the owner is free to destroy itself once it does so nothing for this
+    // instance can run after this point.
+    std::unique_lock<std::mutex> lock(shutdownMutex);
+    if (attached) {
+        attached = false;
+        eventLoop->detach(serviceThread);
+    }
+    cvShutdown.notify_all();
+}
+
+void WebSocketLibWebSocket::close()
+{
+    std::unique_lock<std::mutex> lock(shutdownMutex);
+    if (!attached) {
+        return; // Nothing to do - never opened or connection already gone
+    }
+
+    // A CLOSED socket which is still attached is delivering its final event, only wait for it to finish
+    auto state = getState();
+    if (state != WebSocketState::CLOSING && state != WebSocketState::CLOSED) {
+        setState(WebSocketState::CLOSING);
+        eventLoop->post(serviceThread, WebSocketEventLoop::CommandType::CLOSE, this);
+    }
+
+    // Can't block the service thread on itself, the connection will finish closing once we return
+    if (!eventLoop->isServiceThread(serviceThread)) {
+        cvShutdown.wait(lock, [this] { return !attached; });
     }
 }
 
 void WebSocketLibWebSocket::sendUTF8(const std::string& str)
 {
-    auto buffer = std::make_shared<std::vector<uint8_t>>();
-    buffer->resize(LWS_PRE, 0);
-    std::copy(str.begin(), str.end(), std::back_inserter(*buffer));
+    auto buffer = acquireSendBuffer(str.size());
+    buffer->append(str);
 
-    sendFormattedBinaryBuffer(buffer);
+    send(std::move(buffer));
 }
 
 void WebSocketLibWebSocket::sendBinary(const std::vector<uint8_t>& data)
 {
-    auto buffer = std::make_shared<std::vector<uint8_t>>();
-    buffer->resize(LWS_PRE, 0);
-    std::copy(data.begin(), data.end(), std::back_inserter(*buffer));
+    auto buffer = acquireSendBuffer(data.size());
+    buffer->append(data.data(), data.size());
 
-    sendFormattedBinaryBuffer(buffer);
+    send(std::move(buffer));
 }
 
-void WebSocketLibWebSocket::sendFormattedBinaryBuffer(std::shared_ptr<std::vector<uint8_t>> buffer)
+void WebSocketLibWebSocket::enqueueSend(std::unique_ptr<WebSocketSendBuffer> buffer)
 {
+    std::unique_lock<std::mutex> lock(shutdownMutex);
+    if (getState() == WebSocketState::CLOSED) {
+        // Connection is gone, nothing would ever write it
+        lock.unlock();
+        releaseSendBuffer(std::move(buffer));
+        return;
+    }
+
     {
-        std::unique_lock<std::mutex> lock(mutex);
+        std::unique_lock<std::mutex> sendLock(mutex); // Protect - pendingSendData
 
         // This is client/server thread... we should not send unless we can do it without blocking.
         pendingSendData.push_back(std::move(buffer));
     }
 
-    if (getState() == WebSocketState::OPEN) {
-        // Add it to the queue of things to send, and check to see if it would block. The event that comes
-        // back will have our background thread send the event. If we are open, send a callback request. If
-        // we are not open yet, the open will handle it.
-        lws_callback_on_writable(wsi);
+    // Only the service thread may touch the connection, have it ask for a writeable callback. If
+    // we are not open yet, the open will handle it and one request covers everything queued.
+    if (attached && getState() == WebSocketState::OPEN && !writableRequested.exchange(true)) {
+        eventLoop->post(serviceThread, WebSocketEventLoop::CommandType::WRITABLE, this);
     }
 }
 
@@ -341,6 +366,12 @@ int WebSocketLibWebSocket::handleEvent(struct lws* wsi, enum lws_callback_reason
     bool shouldLog = false;
     switch (reason) {
         case LWS_CALLBACK_CLIENT_ESTABLISHED: {
+            established = true;
+            if (getState() == WebSocketState::CLOSING) {
+                // close() was requested while connecting
+                lws_callback_on_writable(wsi);
+                break;
+            }
             setState(WebSocketState::OPEN);
 
             // We have an established socket, but might still block if we were to write. To avoid the
@@ -358,19 +389,21 @@ int WebSocketLibWebSocket::handleEvent(struct lws* wsi, enum lws_callback_reason
             break;
         }
         case LWS_CALLBACK_CLIENT_CLOSED: {
-            setState(WebSocketState::CLOSING);
+            // The connection is gone, nothing more for this instance from it.
+            lws_set_wsi_user(wsi, nullptr);
 
             WebSocketEvent event;
             event.type = WebSocketEventType::CLOSED;
 
-            notifyClient(event);
+            releaseConnection(&event);
 
             return -1; // We want it closed
         }
         case LWS_CALLBACK_CLIENT_CONNECTION_ERROR: {
-            setState(WebSocketState::CLOSING); // Assume errors are non-recoverable
+            // Assume errors are non-recoverable, lws destroys the connection after this callback
+            lws_set_wsi_user(wsi, nullptr);
 
-            std::string message(static_cast<char*>(in));
+            std::string message(in != nullptr ? static_cast<char*>(in) : "Connection error");
 
             WebSocketErrorEvent error;
             error.code = reason;
@@ -380,39 +413,92 @@ int WebSocketLibWebSocket::handleEvent(struct lws* wsi, enum lws_callback_reason
             event.type = WebSocketEventType::ERROR_EVENT;
             event.error = error;
 
-            notifyClient(event);
+            releaseConnection(&event);
             break;
         }
         case LWS_CALLBACK_CLIENT_RECEIVE: {
-            // To support fragmented messages would need to check for the final frame of a message
-            // with lws_is_final_fragment. This check can be combined with
-            // libwebsockets_remaining_packet_payload to gather the whole contents of a message.
+            // A message may arrive over several callbacks, either as multiple frames or as a frame larger
+            // than the rx buffer. Gather them into a pooled buffer and deliver the message once complete.
+            // Only the size of the first frame is known up front, a message which does not fit in it is
+            // likely to be as large as the last one which did not either rather than growing piece by piece.
+            if (lws_is_first_fragment(wsi)) {
+                size_t frameSize = len + lws_remaining_packet_payload(wsi);
+                bool isWhole = lws_is_final_fragment(wsi) != 0;
+                receiveBuffer = acquireReceiveBuffer(isWhole ? frameSize : std::max(frameSize, receiveSizeHint));
+                receiveIsText = !lws_frame_is_binary(wsi);
+            }
 
-            WebSocketEvent event;
-            event.type = WebSocketEventType::MESSAGE;
-            event.message.data =
-                std::make_shared<std::vector<uint8_t>>(static_cast<uint8_t*>(in), (static_cast<uint8_t*>(in) + len));
-            event.message.isText = false;
+            receiveBuffer.insert(receiveBuffer.end(), static_cast<uint8_t*>(in), static_cast<uint8_t*>(in) + len);
 
-            notifyClient(event);
+            if (lws_is_final_fragment(wsi)) {
+                if (lws_is_first_fragment(wsi) == 0) {
+                    receiveSizeHint = receiveBuffer.size();
+                }
+
+                WebSocketEvent event;
+                event.type = WebSocketEventType::MESSAGE;
+                event.message.data = shareReceiveBuffer(std::move(receiveBuffer));
+                event.message.isText = receiveIsText;
+                receiveBuffer = std::vector<uint8_t>();
+
+                notifyClient(event);
+            }
             break;
         }
         case LWS_CALLBACK_CLIENT_WRITEABLE: {
-            std::unique_lock<std::mutex> lock(mutex); // Protect - pendingSendData
+            if (getState() == WebSocketState::CLOSING) {
+                // Requested close, returning non-zero has lws send the close frame and tear down
+                lws_close_reason(wsi, LWS_CLOSE_STATUS_NORMAL, nullptr, 0);
+                return -1;
+            }
 
-            // We are writable... send what might be queued up.
-            if (!pendingSendData.empty()) {
-                auto data = pendingSendData.front();
-                pendingSendData.pop_front();
+            // Take everything queued so far in one go rather than locking for each message
+            std::deque<std::unique_ptr<WebSocketSendBuffer>> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex); // Protect - pendingSendData
+                batch.swap(pendingSendData);
+            }
+
+            // We are writable... send as much of the batch as the socket will take. The buffers were built
+            // with LWS_PRE headroom so lws can frame them in place. When the kernel only accepts part of a
+            // message lws holds the remainder and reports the pipe as choked, stop there and carry on from
+            // the next writeable callback once it has been flushed.
+            int result = 0;
+            while (!batch.empty()) {
+                auto data = std::move(batch.front());
+                batch.pop_front();
 
                 lws_write_protocol protocol = LWS_WRITE_BINARY;
-                lws_write(wsi, data->data() + LWS_PRE, data->size() - LWS_PRE, protocol);
+                if (lws_write(wsi, data->data(), data->size(), protocol) < 0) {
+                    result = -1; // Connection has failed, lws closes it
+                }
+                releaseSendBuffer(std::move(data), result == 0);
 
-                // If still something to send in the queue, check for when it is safe to send without blocking
-                if (!pendingSendData.empty()) {
-                    lws_callback_on_writable(wsi);
+                if (result != 0 || lws_send_pipe_choked(wsi) != 0) {
+                    break;
                 }
             }
+
+            // Return whatever was not written to the front of the queue, ahead of anything queued meanwhile
+            bool morePending = false;
+            {
+                std::unique_lock<std::mutex> lock(mutex); // Protect - pendingSendData
+                pendingSendData.insert(pendingSendData.begin(),
+                                       std::make_move_iterator(batch.begin()),
+                                       std::make_move_iterator(batch.end()));
+                morePending = !pendingSendData.empty();
+            }
+
+            // If still something to send in the queue, check for when it is safe to send without blocking
+            if (result == 0 && morePending) {
+                lws_callback_on_writable(wsi);
+            }
+            return result;
+        }
+        case LWS_CALLBACK_WSI_DESTROY: {
+            // Should have seen CLIENT_CLOSED or CONNECTION_ERROR first but make sure we let go
+            lws_set_wsi_user(wsi, nullptr);
+            releaseConnection();
             break;
         }
         case LWS_CALLBACK_OPENSSL_LOAD_EXTRA_CLIENT_VERIFY_CERTS: